@@ -0,0 +1,174 @@
+#include "unit.hh"
+#include "exception.h"
+namespace unit {
+/// @ingroup utest
+/// @brief Tests automatic stack tracing.
+///
+/// Tests the automatic stack tracing system, consisting of the
+/// -finstrument-functions hooks of the Trace class. This file is compiled with
+/// -finstrument-functions, so every function within it adds its own function
+/// item to the stack.
+namespace autotrace {
+
+
+
+/// @brief Used for all strings.
+using string = std::string;
+/// @brief Used for throwing a unit test failure.
+using fail = UnitTest::Run::Fail;
+/// @brief Used as shorthand.
+using gwe = Gwers::Exception;
+/// @brief Used as shorthand.
+using gwtr = Gwers::Trace;
+
+
+
+/// @brief Internal function that records the state of the stack.
+__attribute__((noinline)) void inner(std::size_t& depth, string& top)
+{
+   auto i = gwtr::end();
+   depth = gwtr::depth();
+   top = *(--i);
+}
+
+
+
+/// @brief Internal function that throws a %Gwers exception.
+__attribute__((noinline)) void thrower()
+{
+   throw gwe("test_who","test_what",66);
+}
+
+
+
+/// @brief Internal variable that is used with base_catch() testing.
+bool handled;
+
+
+
+/// @brief Internal function that throws a %Gwers exception for base_catch().
+__attribute__((noinline)) void throw_base()
+{
+   thrower();
+}
+
+
+
+/// @brief Internal function that handles the exception of throw_base(),
+/// without a function item of its own.
+__attribute__((no_instrument_function))
+   void handler(gwe::Type t, gwe*, std::exception*)
+{
+   auto i = gwtr::end();
+   handled = t==gwe::Type::gwers&&gwtr::locked()&&
+             (--i)->find("unit::autotrace::thrower")!=string::npos;
+}
+
+
+
+/// @brief Internal function that calls base_catch() from an instrumented
+/// function.
+__attribute__((noinline)) void caught(std::size_t& depth)
+{
+   gwe::base_catch(throw_base,handler);
+   depth = gwtr::depth();
+}
+
+
+
+/// @brief Unit tests automatic function items.
+///
+/// This function unit tests the function items added by the
+/// -finstrument-functions hooks of the Gwers::Trace class. It performs these
+/// tests with three unit tests.
+///
+/// -# Calls an instrumented function, making sure it added exactly one function
+/// item to the stack and that the item reads as the function's name.
+///
+/// -# Makes sure the function item of the called function was popped once it
+/// returned.
+///
+/// -# Calls an instrumented function that throws a %Gwers exception, making
+/// sure the function item of the throwing function is kept on the locked stack
+/// once the exception is caught.
+void basic(UnitTest::Run& ut)
+{
+   std::size_t base {gwtr::depth()};
+   std::size_t depth {0};
+   string top;
+   inner(depth,top);
+   if (depth!=base+1||top.find("unit::autotrace::inner")==string::npos)
+   {
+      throw fail();
+   }
+   ut.next();
+   if (gwtr::depth()!=base)
+   {
+      throw fail();
+   }
+   ut.next();
+   bool good {false};
+   try
+   {
+      thrower();
+   }
+   catch (gwe&)
+   {
+      auto i = gwtr::end();
+      good = gwtr::locked()&&
+             (--i)->find("unit::autotrace::thrower")!=string::npos;
+   }
+   gwtr::rewind(base);
+   if (!good)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Unit tests base_catch() within instrumented functions.
+///
+/// This function unit tests Gwers::Exception::base_catch() called from a
+/// function instrumented with -finstrument-functions, whose exit hook pops its
+/// own function item once base_catch() returns. It performs these tests with
+/// two unit tests.
+///
+/// -# Calls an instrumented function that calls base_catch() with a base
+/// function throwing a %Gwers exception, making sure the handler saw the
+/// function item of the throwing function on the locked stack.
+///
+/// -# Makes sure the stack was rewound to the function item of the calling
+/// function once base_catch() returned, and back to where it started once the
+/// calling function returned.
+void base(UnitTest::Run& ut)
+{
+   std::size_t base {gwtr::depth()};
+   std::size_t depth {0};
+   handled = false;
+   caught(depth);
+   if (!handled)
+   {
+      throw fail();
+   }
+   ut.next();
+   if (depth!=base+1||gwtr::depth()!=base||gwtr::locked())
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Initialize all unit tests for automatic tracing.
+void init(UnitTest& ut)
+{
+   UnitTest::Run& t = ut.add("AutoTrace",nullptr,nullptr);
+   t.add("basic",basic);
+   t.add("base",base);
+}
+
+
+
+}
+}
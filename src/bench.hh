@@ -0,0 +1,19 @@
+#ifndef BENCH_HH
+#define BENCH_HH
+#include "benchmark.hh"
+
+
+/// @brief Benchmarks for entire code base.
+///
+/// This encompasses all benchmarking code which is not part of the library
+/// itself. All benchmarking code for the entire code base is part of this name
+/// space.
+namespace bench {
+namespace autotrace { void init(Benchmark&); }
+namespace format { void init(Benchmark&); }
+namespace key { void init(Benchmark&); }
+}
+
+
+
+#endif
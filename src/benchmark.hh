@@ -0,0 +1,205 @@
+#ifndef BENCHMARK_HH
+#define BENCHMARK_HH
+#include <string>
+#include <vector>
+
+
+
+/// @defgroup btest Benchmarking
+/// @brief Framework where all benchmarks and supporting classes reside.
+///
+/// This encompasses all benchmarks, which are provided in benchmarking
+/// functions, and the benchmarking support class Benchmark. Benchmarks are
+/// divided into their own namespaces based off the name of the class or
+/// hierarchy being measured, and those namespaces are encompassed into another
+/// namespace called bench. The benchmarks are built into their own program,
+/// separate from the unit tests, with the bench target.
+///
+/// All benchmarks are ran through a single instance of the Benchmark class,
+/// adding benchmarks to it and then executing all benchmarks that were added.
+/// Every benchmarking namespace will have a function called init(Benchmark&)
+/// which will add all of its benchmarks to the Benchmark object. A benchmarking
+/// function is given a number of iterations to run. The number is doubled until
+/// a single call takes long enough to time accurately, and the average time of
+/// one iteration is then printed to standard output.
+
+
+
+/// @ingroup btest
+/// @brief Stores a list of Benchmark::Run objects that will be measured.
+///
+/// This stores a list of Benchmark::Run objects, each one coinciding with the
+/// namespace of a separate collection of benchmarks. Objects can only be added,
+/// not removed. Once all objects are added, they can be executed.
+class Benchmark
+{
+public:
+   // *
+   // * DECLERATIONS
+   // *
+   class Run;
+   /// @brief Used for all strings.
+   using string = std::string;
+   // *
+   // * BASIC METHODS
+   // *
+   Benchmark() = default;
+   // *
+   // * COPY METHODS
+   // *
+   Benchmark(const Benchmark&) = delete;
+   Benchmark& operator=(const Benchmark&) = delete;
+   // *
+   // * MOVE METHODS
+   // *
+   Benchmark(Benchmark&&) = delete;
+   Benchmark& operator=(Benchmark&&) = delete;
+   // *
+   // * FUNCTIONS
+   // *
+   /// @brief Creates a new Benchmark::Run object and returns a reference.
+   ///
+   /// @param name The name for this benchmark object that is the namespace of
+   /// the collected benchmarks.
+   ///
+   /// @return The new Benchmark::Run object that was just created.
+   Run& add(const string& name);
+   /// @brief Executes all stored Benchmark::Run objects.
+   void execute();
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   /// @brief Prevents the compiler from optimizing away a value.
+   ///
+   /// @param p Pointer to value that must be treated as used.
+   static void keep(const void* p);
+private:
+   // *
+   // * DECLERATIONS
+   // *
+   using list = std::vector<Run>;
+   // *
+   // * VARIABLES
+   // *
+   list _runs;
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | RUN                                                                      |
+// *==========================================================================*
+//
+//
+//
+
+
+
+/// @brief Stores a list of function pointers that will be measured.
+///
+/// This stores a list of name and function pointer pairs. Each function runs
+/// the code being measured the number of iterations it is given.
+///
+/// @warning The execution of these objects are not meant to be called directly,
+/// it is called through the main Benchmark object's execution task.
+class Benchmark::Run
+{
+public:
+   // *
+   // * DECLERATIONS
+   // *
+   /// @brief Used for all strings.
+   using string = Benchmark::string;
+   /// @brief Used for benchmarking functions.
+   using bfp = void(*)(std::size_t);
+   // *
+   // * BASIC METHODS
+   // *
+   /// @brief Initializes object with empty benchmarking list.
+   ///
+   /// @param name The namespace for all benchmarks added to this object.
+   Run(const string& name);
+   // *
+   // * COPY METHODS
+   // *
+   Run(const Run&) = delete;
+   Run& operator=(const Run&) = delete;
+   // *
+   // * MOVE METHODS
+   // *
+   /// @brief Default move constructor.
+   Run(Run&&) = default;
+   /// @brief Default move operator.
+   Run& operator=(Run&&) = default;
+   // *
+   // * FUNCTIONS
+   // *
+   /// @brief Add a new benchmarking function.
+   ///
+   /// @param name Name for specific benchmark.
+   /// @param test Pointer to benchmarking function.
+   void add(const string& name, bfp test);
+   /// @brief Run list of all benchmarks, printing the time of each.
+   void execute();
+private:
+   // *
+   // * DECLERATIONS
+   // *
+   using list = std::vector<std::pair<string,bfp>>;
+   // *
+   // * VARIABLES
+   // *
+   string _name;
+   list _tests;
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | INLINE/TEMPLATE                                                          |
+// *==========================================================================*
+//
+//
+//
+
+
+
+inline void Benchmark::keep(const void* p)
+{
+   asm volatile("" : : "g"(p) : "memory");
+}
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | RUN INLINE/TEMPLATE                                                      |
+// *==========================================================================*
+//
+//
+//
+
+
+
+inline Benchmark::Run::Run(const string& name):
+   _name {name}
+{}
+
+
+
+inline void Benchmark::Run::add(const string& name, bfp test)
+{
+   _tests.emplace_back(name,test);
+}
+
+
+
+#endif
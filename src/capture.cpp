@@ -0,0 +1,47 @@
+#include "capture.h"
+namespace Gwers {
+
+
+
+void Capture::rethrow()
+{
+   if (_exception)
+   {
+      Trace::restore(std::move(_trace));
+      std::rethrow_exception(_exception);
+   }
+}
+
+
+
+Capture Capture::current()
+{
+   Capture ret;
+   ret._exception = std::current_exception();
+   if (ret._exception)
+   {
+      try
+      {
+         std::rethrow_exception(ret._exception);
+      }
+      catch (Exception& e)
+      {
+         ret._type = Exception::Type::gwers;
+         ret._gwers = &e;
+      }
+      catch (std::exception& e)
+      {
+         ret._type = Exception::Type::std;
+         ret._std = &e;
+      }
+      catch (...)
+      {}
+      ret._trace = Trace::snapshot();
+      ret._tag = Tag::current();
+   }
+   return ret;
+}
+
+
+
+}
@@ -0,0 +1,160 @@
+#include <thread>
+#include "unit.hh"
+#include "capture.h"
+namespace unit {
+/// @ingroup utest
+/// @brief Tests cross thread exception transport.
+///
+/// Tests the cross thread exception transport, consisting of the Capture
+/// class.
+namespace capture {
+
+
+
+/// @brief Used for all strings.
+using string = std::string;
+/// @brief Used for throwing a unit test failure.
+using fail = UnitTest::Run::Fail;
+/// @brief Used as shorthand.
+using gwe = Gwers::Exception;
+/// @brief Used as shorthand.
+using gwtr = Gwers::Trace;
+/// @brief Used as shorthand.
+using gwc = Gwers::Capture;
+
+
+
+/// @brief Internal function that captures an exception on another thread.
+///
+/// @param which Type of exception to throw, 0 for %Gwers, 1 for standard, and
+/// 2 for unknown.
+///
+/// @return Token captured on the other thread.
+gwc capture_on_thread(int which)
+{
+   gwc ret;
+   std::thread t([&ret,which] {
+      gwtr::flush();
+      try
+      {
+         gwtr t1("outer");
+         gwtr t2("inner");
+         switch (which)
+         {
+         case 0:
+            throw gwe("test_who","test_what",66);
+         case 1:
+            throw std::exception();
+         default:
+            throw int(66);
+         }
+      }
+      catch (...)
+      {
+         ret = gwc::current();
+      }
+   });
+   t.join();
+   return ret;
+}
+
+
+
+/// @brief Unit tests capturing of exceptions.
+///
+/// This function unit tests the static Gwers::Capture::current() function along
+/// with all get functions. It performs these tests with three unit tests.
+///
+/// -# Makes sure a default constructed token and a token captured outside of
+/// any catch block are empty.
+///
+/// -# Captures a %Gwers exception thrown within two Trace objects on another
+/// thread, making sure the token is moved back to this thread with the correct
+/// exception type, exception information, and function stack.
+///
+/// -# Captures a standard and an unknown exception on another thread, making
+/// sure the type of each token is correct.
+void current(UnitTest::Run& ut)
+{
+   gwc c;
+   if (!c.empty()||!gwc::current().empty())
+   {
+      throw fail();
+   }
+   ut.next();
+   c = capture_on_thread(0);
+   if (c.empty()||c.type()!=gwe::Type::gwers||c.gwers()==nullptr||
+       c.standard()!=nullptr||c.gwers()->who()!=string("test_who")||
+       c.gwers()->line()!=66||c.trace().size()!=2||
+       c.trace()[0]!=string("outer")||c.trace()[1]!=string("inner"))
+   {
+      throw fail();
+   }
+   ut.next();
+   gwc s {capture_on_thread(1)};
+   gwc u {capture_on_thread(2)};
+   if (s.type()!=gwe::Type::std||s.standard()==nullptr||s.gwers()!=nullptr||
+       u.type()!=gwe::Type::unknown||u.standard()!=nullptr||
+       u.gwers()!=nullptr)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Unit tests rethrowing of exceptions.
+///
+/// This function unit tests the Gwers::Capture::rethrow() function. It performs
+/// these tests with two unit tests.
+///
+/// -# Captures a %Gwers exception on another thread and rethrows it on this
+/// thread from within a Trace object, making sure the exception caught is the
+/// original one and the function stack of this thread holds this thread's
+/// function item followed by the captured function items.
+///
+/// -# Makes sure rethrowing an empty token does nothing.
+void rethrow(UnitTest::Run& ut)
+{
+   gwc c {capture_on_thread(0)};
+   bool caught {false};
+   try
+   {
+      gwtr t("joiner");
+      c.rethrow();
+   }
+   catch (gwe& e)
+   {
+      caught = true;
+      auto i = gwtr::begin();
+      if (e.who()!=string("test_who")||e.line()!=66||
+          *(i++)!=string("joiner")||*(i++)!=string("outer")||
+          *(i++)!=string("inner")||i!=gwtr::end())
+      {
+         throw fail();
+      }
+   }
+   gwtr::flush();
+   if (!caught)
+   {
+      throw fail();
+   }
+   ut.next();
+   gwc e;
+   e.rethrow();
+}
+
+
+
+/// @brief Initialize all unit tests for Capture class.
+void init(UnitTest& ut)
+{
+   UnitTest::Run& t = ut.add("Capture",nullptr,nullptr);
+   t.add("current",current);
+   t.add("rethrow",rethrow);
+}
+
+
+
+}
+}
@@ -0,0 +1,151 @@
+#ifndef GWERS_CAPTURE_H
+#define GWERS_CAPTURE_H
+#include <exception>
+#include "exception.h"
+namespace Gwers {
+
+
+
+/// @ingroup exception
+/// @brief Transports a caught exception and its function stack between threads.
+///
+/// This packages the exception currently being handled, along with a snapshot
+/// of the Trace function stack of the thread it was thrown on, into a single
+/// token that can be moved to any other thread. The exception object itself is
+/// never copied; the token holds a std::exception_ptr referring to it. If the
+/// function stack is locked, as it always is after a %Gwers exception has been
+/// thrown, the function items are moved into the token instead of copied.
+///
+/// The token can be inspected on any thread, or rethrown on any thread with
+/// rethrow(). Rethrowing places the captured function stack on top of the
+/// function stack of the rethrowing thread and locks it, so whoever catches the
+/// rethrown exception sees where it was originally thrown. The Tag of the
+/// capturing thread is kept as well, so an exception of any type can still be
+/// charged to whoever it was raised for.
+///
+/// @warning A token can only be rethrown once, because rethrowing moves the
+/// captured function stack out of the token.
+class Capture
+{
+public:
+   // *
+   // * DECLERATIONS
+   // *
+   /// @brief Used for all strings.
+   using string = std::string;
+   /// @brief Used for the snapshot of the function stack.
+   using list = Trace::list;
+   // *
+   // * BASIC METHODS
+   // *
+   /// @brief Initializes empty token holding no exception.
+   Capture() = default;
+   // *
+   // * FUNCTIONS
+   // *
+   /// @brief Get whether this token holds an exception.
+   bool empty() const;
+   /// @brief Get type of exception held.
+   Exception::Type type() const;
+   /// @brief Get %Gwers exception held.
+   ///
+   /// @return Pointer to %Gwers exception held or nullptr if the exception is
+   /// not of type Exception::Type::gwers.
+   const Exception* gwers() const;
+   /// @brief Get standard library exception held.
+   ///
+   /// @return Pointer to standard library exception held or nullptr if the
+   /// exception is not of type Exception::Type::std.
+   const std::exception* standard() const;
+   /// @brief Get snapshot of function stack taken when captured.
+   const list& trace() const;
+   /// @brief Get Tag of the thread that captured the exception.
+   std::uint32_t tag() const;
+   /// @brief Rethrows the exception held on the calling thread.
+   ///
+   /// Places the captured function stack on top of the calling thread's
+   /// function stack, locking it, and then rethrows the exception held by this
+   /// token. If this token is empty then this does nothing.
+   void rethrow();
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   /// @brief Captures the exception currently being handled.
+   ///
+   /// This must be called from within a catch block. It captures the exception
+   /// being handled along with a snapshot of the calling thread's function
+   /// stack.
+   ///
+   /// @return Token holding the captured exception, or an empty token if no
+   /// exception is currently being handled.
+   static Capture current();
+private:
+   // *
+   // * VARIABLES
+   // *
+   std::exception_ptr _exception;
+   Exception::Type _type {Exception::Type::unknown};
+   const Exception* _gwers {nullptr};
+   const std::exception* _std {nullptr};
+   list _trace;
+   std::uint32_t _tag {0};
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | INLINE/TEMPLATE                                                          |
+// *==========================================================================*
+//
+//
+//
+
+
+
+inline bool Capture::empty() const
+{
+   return !_exception;
+}
+
+
+
+inline Exception::Type Capture::type() const
+{
+   return _type;
+}
+
+
+
+inline const Exception* Capture::gwers() const
+{
+   return _gwers;
+}
+
+
+
+inline const std::exception* Capture::standard() const
+{
+   return _std;
+}
+
+
+
+inline const Capture::list& Capture::trace() const
+{
+   return _trace;
+}
+
+
+
+inline std::uint32_t Capture::tag() const
+{
+   return _tag;
+}
+
+
+
+}
+#endif
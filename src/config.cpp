@@ -0,0 +1,346 @@
+#include "config.h"
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+namespace Gwers {
+
+
+
+namespace
+{
+   struct Base
+   {
+      unsigned rate;
+      Site::Level level;
+   };
+   std::mutex g_mutex;
+   std::vector<const Config::Snapshot*>* g_published {nullptr};
+   std::unordered_map<Site*,Base> g_bases;
+
+
+
+   std::string_view trim(std::string_view text)
+   {
+      const char* space {" \t\r"};
+      std::size_t begin {text.find_first_not_of(space)};
+      if (begin==std::string_view::npos)
+      {
+         return std::string_view();
+      }
+      return text.substr(begin,text.find_last_not_of(space)-begin+1);
+   }
+
+
+
+   template<class T> bool number(std::string_view text, T& value)
+   {
+      auto r = std::from_chars(text.data(),text.data()+text.size(),value);
+      return r.ec==std::errc()&&r.ptr==text.data()+text.size();
+   }
+
+
+
+   bool level(std::string_view text, Site::Level& value)
+   {
+      const char* names[] {"off","sampled","name","full"};
+      for (int i = 0;i<4;++i)
+      {
+         if (text==names[i])
+         {
+            value = static_cast<Site::Level>(i);
+            return true;
+         }
+      }
+      return false;
+   }
+
+
+
+   bool rule(std::string_view line, Config::Snapshot& out)
+   {
+      std::size_t first {line.find_first_of(" \t")};
+      if (first==std::string_view::npos)
+      {
+         return false;
+      }
+      std::string_view key {line.substr(0,first)};
+      std::string_view rest {trim(line.substr(first))};
+      if (key=="check")
+      {
+         return number(rest,out.check);
+      }
+      std::size_t last {rest.find_last_of(" \t")};
+      if (last==std::string_view::npos)
+      {
+         return false;
+      }
+      Config::Rule r {Config::Rule::Kind::rate,
+                      std::string(trim(rest.substr(0,last))),1,
+                      Site::Level::full};
+      std::string_view value {rest.substr(last+1)};
+      if (key=="rate"&&number(value,r.rate))
+      {
+         out.rules.push_back(std::move(r));
+         return true;
+      }
+      if (key=="level"&&level(value,r.level))
+      {
+         r.kind = Config::Rule::Kind::level;
+         out.rules.push_back(std::move(r));
+         return true;
+      }
+      return false;
+   }
+
+
+
+   std::string slurp(const std::string& path)
+   {
+      std::string ret;
+      int fd {::open(path.c_str(),O_RDONLY|O_CLOEXEC)};
+      if (fd<0)
+      {
+         return ret;
+      }
+      char buffer[4096];
+      while (true)
+      {
+         ssize_t n {::read(fd,buffer,sizeof(buffer))};
+         if (n<0&&errno==EINTR)
+         {
+            continue;
+         }
+         if (n<=0)
+         {
+            break;
+         }
+         ret.append(buffer,n);
+      }
+      ::close(fd);
+      return ret;
+   }
+}
+
+
+
+Config::Snapshot Config::_initial {};
+std::atomic<const Config::Snapshot*> Config::_current {&_initial};
+std::atomic<int> Config::_check {std::numeric_limits<int>::max()};
+const bool Config::_started {start()};
+
+
+
+Config::Config(const std::string& path):
+   _path {path}
+{
+   std::size_t slash {path.rfind('/')};
+   std::string dir {slash==std::string::npos?".":path.substr(0,slash+1)};
+   if (::pipe2(_wake,O_CLOEXEC)!=0)
+   {
+      _wake[0] = _wake[1] = -1;
+   }
+   _inotify = ::inotify_init1(IN_CLOEXEC|IN_NONBLOCK);
+   if (_inotify>=0&&
+       ::inotify_add_watch(_inotify,dir.c_str(),
+                           IN_CLOSE_WRITE|IN_MOVED_TO|IN_CREATE|IN_DELETE)<0)
+   {
+      ::close(_inotify);
+      _inotify = -1;
+   }
+   reload();
+   if (_inotify>=0&&_wake[0]>=0)
+   {
+      _thread = std::thread(&Config::run,this);
+   }
+}
+
+
+
+Config::~Config()
+{
+   if (_thread.joinable())
+   {
+      char c {0};
+      while (::write(_wake[1],&c,1)<0&&errno==EINTR);
+      _thread.join();
+   }
+   for (int fd:{_inotify,_wake[0],_wake[1]})
+   {
+      if (fd>=0)
+      {
+         ::close(fd);
+      }
+   }
+}
+
+
+
+std::size_t Config::parse(std::string_view text, Snapshot& out)
+{
+   std::size_t ret {0};
+   while (!text.empty())
+   {
+      std::size_t end {text.find_first_of("\n;")};
+      std::string_view line {trim(text.substr(0,end))};
+      text = end==std::string_view::npos?std::string_view():text.substr(end+1);
+      if (!line.empty()&&line[0]!='#'&&!rule(line,out))
+      {
+         ++ret;
+      }
+   }
+   return ret;
+}
+
+
+
+void Config::publish(Snapshot snapshot)
+{
+   std::lock_guard<std::mutex> lock {g_mutex};
+   snapshot.version = get().version+1;
+   for (auto i:Site::all())
+   {
+      auto b = g_bases.find(i);
+      if (b==g_bases.end())
+      {
+         b = g_bases.emplace(i,Base {i->rate(),i->level()}).first;
+      }
+      unsigned rate {b->second.rate};
+      Site::Level level {b->second.level};
+      for (auto& r:snapshot.rules)
+      {
+         if (match(*i,r.pattern))
+         {
+            if (r.kind==Rule::Kind::rate)
+            {
+               rate = r.rate;
+            }
+            else
+            {
+               level = r.level;
+            }
+         }
+      }
+      if (i->rate()!=(rate?rate:1))
+      {
+         i->set_rate(rate);
+      }
+      if (i->level()!=level)
+      {
+         i->set_level(level);
+      }
+   }
+   _check.store(snapshot.check,std::memory_order_relaxed);
+   if (!g_published)
+   {
+      g_published = new std::vector<const Snapshot*>;
+   }
+   g_published->push_back(new Snapshot(std::move(snapshot)));
+   _current.store(g_published->back(),std::memory_order_release);
+}
+
+
+
+bool Config::match(const Site& site, std::string_view pattern)
+{
+   if (pattern=="*")
+   {
+      return true;
+   }
+   std::string_view function {site.function()};
+   if (!pattern.empty()&&pattern.back()=='*')
+   {
+      pattern.remove_suffix(1);
+      return function.substr(0,pattern.size())==pattern;
+   }
+   std::size_t colon {pattern.rfind(':')};
+   int line {0};
+   if (colon!=std::string_view::npos&&colon>0&&pattern[colon-1]!=':'&&
+       number(pattern.substr(colon+1),line))
+   {
+      std::string_view file {site.file()};
+      std::string_view name {pattern.substr(0,colon)};
+      return line==site.line()&&file.size()>=name.size()&&
+             file.substr(file.size()-name.size())==name;
+   }
+   return function==pattern;
+}
+
+
+
+bool Config::start()
+{
+   if (const char* env = std::getenv("GWX_CONFIG"))
+   {
+      Snapshot s;
+      parse(env,s);
+      publish(std::move(s));
+   }
+   return true;
+}
+
+
+
+void Config::reload()
+{
+   Snapshot s;
+   if (const char* env = std::getenv("GWX_CONFIG"))
+   {
+      parse(env,s);
+   }
+   parse(slurp(_path),s);
+   publish(std::move(s));
+}
+
+
+
+void Config::run()
+{
+   std::size_t slash {_path.rfind('/')};
+   std::string name {slash==std::string::npos?_path:_path.substr(slash+1)};
+   alignas(inotify_event) char buffer[4096];
+   pollfd fds[2] {{_inotify,POLLIN,0},{_wake[0],POLLIN,0}};
+   while (true)
+   {
+      if (::poll(fds,2,-1)<0)
+      {
+         if (errno==EINTR)
+         {
+            continue;
+         }
+         break;
+      }
+      if (fds[1].revents)
+      {
+         break;
+      }
+      bool changed {false};
+      ssize_t n;
+      while ((n = ::read(_inotify,buffer,sizeof(buffer)))>0)
+      {
+         for (char* p = buffer;p<buffer+n;)
+         {
+            auto e = reinterpret_cast<inotify_event*>(p);
+            if (e->len>0&&name==e->name)
+            {
+               changed = true;
+            }
+            p += sizeof(inotify_event)+e->len;
+         }
+      }
+      if (changed)
+      {
+         reload();
+      }
+   }
+}
+
+
+
+}
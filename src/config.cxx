@@ -0,0 +1,190 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "unit.hh"
+#include "config.h"
+#include "trace.h"
+namespace unit {
+/// @ingroup utest
+/// @brief Tests hot reloadable settings.
+///
+/// Tests the publishing and reloading of tracing settings, consisting of the
+/// Config class.
+namespace config {
+
+
+
+/// @brief Used for all strings.
+using string = std::string;
+/// @brief Used for throwing a unit test failure.
+using fail = UnitTest::Run::Fail;
+/// @brief Used as shorthand.
+using gwc = Gwers::Config;
+/// @brief Used as shorthand.
+using gws = Gwers::Site;
+/// @brief Used as shorthand.
+using level = Gwers::Site::Level;
+
+
+
+/// @brief Internal variable holding line number of site in target().
+int line {0};
+
+
+
+/// @brief Internal function whose site settings are changed.
+void target()
+{
+   GWX_BEGIN_S(2,"unit::config::target()"); line = __LINE__;
+}
+
+
+
+/// @brief Internal function that finds a site by the name of its function.
+gws* find(const char* function)
+{
+   for (auto i:gws::all())
+   {
+      if (std::strcmp(i->function(),function)==0)
+      {
+         return i;
+      }
+   }
+   return nullptr;
+}
+
+
+
+/// @brief Internal function that writes text to a file, replacing it.
+void write(const string& path, const string& text)
+{
+   string tmp {path+".tmp"};
+   std::ofstream(tmp) << text;
+   rename(tmp.c_str(),path.c_str());
+}
+
+
+
+/// @brief Unit tests reading and publishing settings.
+///
+/// This function unit tests the parse(), match(), publish(), and get()
+/// functions of the Gwers::Config class. It performs these tests with three
+/// unit tests.
+///
+/// -# Reads text with good rules, comments, blank lines, and bad lines,
+/// making sure every good rule is read in order and every bad line counted.
+///
+/// -# Matches a site against every kind of pattern, making sure only the
+/// patterns naming it match.
+///
+/// -# Publishes rules for a site and then publishes no rules, making sure the
+/// site takes the settings of the rules and then goes back to the ones it had,
+/// while the check tier and version of the settings in use follow along.
+void publish(UnitTest::Run& ut)
+{
+   gwc::Snapshot s;
+   if (gwc::parse("# comment\n\nrate unit::* 8; level f(int, char) name\n"
+                  "check 2;rate x;level y loud;bogus\n",s)!=3||
+       s.check!=2||s.rules.size()!=2||
+       s.rules[0].kind!=gwc::Rule::Kind::rate||
+       s.rules[0].pattern!="unit::*"||s.rules[0].rate!=8||
+       s.rules[1].kind!=gwc::Rule::Kind::level||
+       s.rules[1].pattern!="f(int, char)"||s.rules[1].level!=level::name)
+   {
+      throw fail();
+   }
+   ut.next();
+   target();
+   gws* site {find("unit::config::target()")};
+   string here {"config.cxx:"+std::to_string(line)};
+   if (!site||!gwc::match(*site,"*")||!gwc::match(*site,"unit::config::*")||
+       !gwc::match(*site,"unit::config::target()")||
+       !gwc::match(*site,here)||gwc::match(*site,"unit::site::*")||
+       gwc::match(*site,"config.cxx:1")||gwc::match(*site,"unit::config"))
+   {
+      throw fail();
+   }
+   ut.next();
+   std::uint64_t version {gwc::get().version};
+   s = gwc::Snapshot();
+   gwc::parse("level * off;level "+here+" sampled;rate unit::config::* 16;"
+              "check 3",s);
+   gwc::publish(s);
+   const gwc::Snapshot& in {gwc::get()};
+   if (in.version!=version+1||in.check!=3||in.rules.size()!=3||
+       site->level()!=level::sampled||site->rate()!=16)
+   {
+      gwc::publish(gwc::Snapshot());
+      throw fail();
+   }
+   gwc::publish(gwc::Snapshot());
+   if (gwc::get().version!=version+2||
+       gwc::get().check!=gwc::Snapshot().check||
+       site->level()!=level::full||site->rate()!=2)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Unit tests watching a file of rules.
+///
+/// This function unit tests the constructor and destructor of the
+/// Gwers::Config class. It performs these tests with two unit tests.
+///
+/// -# Writes a file of rules and watches it, making sure its rules are
+/// published at once.
+///
+/// -# Replaces the file with other rules, making sure they are published
+/// within a few seconds, and stops watching, making sure the settings last
+/// published stay in use.
+void watch(UnitTest::Run& ut)
+{
+   target();
+   gws* site {find("unit::config::target()")};
+   string file {"/tmp/gwx_config_"+std::to_string(getpid())};
+   write(file,"level unit::config::target() name\ncheck 1\n");
+   std::uint64_t version {gwc::get().version};
+   {
+      gwc config(file);
+      if (!site||gwc::get().version!=version+1||gwc::get().check!=1||
+          site->level()!=level::name)
+      {
+         throw fail();
+      }
+      ut.next();
+      write(file,"rate unit::config::target() 32\ncheck 2\n");
+      for (int i = 0;i<500&&gwc::get().check!=2;++i)
+      {
+         std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+   }
+   unlink(file.c_str());
+   bool good {gwc::get().check==2&&site->rate()==32&&
+              site->level()==level::full};
+   gwc::publish(gwc::Snapshot());
+   if (!good)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Initialize all unit tests for Config class.
+void init(UnitTest& ut)
+{
+   UnitTest::Run& t = ut.add("Config",nullptr,nullptr);
+   t.add("publish",publish);
+   t.add("watch",watch);
+}
+
+
+
+}
+}
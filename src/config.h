@@ -0,0 +1,201 @@
+#ifndef GWERS_CONFIG_H
+#define GWERS_CONFIG_H
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "site.h"
+namespace Gwers {
+
+
+
+/// @ingroup exception
+/// @brief Changes tracing and checking settings while the program runs.
+///
+/// The settings in use at any time are one immutable snapshot, which get()
+/// returns with a single atomic load and no lock. Publishing new settings
+/// builds a whole new snapshot, applies it to every site, and then swaps the
+/// pointer to it, so a reader of get() sees either the old settings or the new
+/// ones and never a mix. A replaced snapshot is never freed, not even when the
+/// program exits, because a reader may still hold it and get() returns it
+/// without the reader announcing itself, so a reference returned by get()
+/// stays valid for as long as the program runs. Each snapshot only holds its
+/// rules, and settings are only published when the program starts, when a
+/// Config is constructed, and when its file is written, so the snapshots kept
+/// grow by one small set of rules for every edit of the file.
+///
+/// Calls through a site do not read the snapshot, however, only the rate and
+/// level of their own site, and checks only read a copy of the check tier kept
+/// on its own. publish() writes these to one site after another, the rate and
+/// the level of each apart, and the check tier before the snapshot. While
+/// settings are being published, calls may therefore see some sites already
+/// changed and others not yet, or a site with its new rate and its old level.
+/// Every site has its new settings once publish() returns.
+///
+/// Settings are written as text with one rule per line; blank lines and lines
+/// starting with # are ignored, and so is any line that cannot be read:
+///
+/// - rate P N sets the sampling rate of every site matching P to N.
+/// - level P L sets the level of detail of every site matching P to L, which
+///   is one of off, sampled, name, or full.
+/// - check N sets the check tier to N. A check of the GWX_ASSERT, GWX_CHECK,
+///   and GWX_PASS macros and their variants is only made while its level is at
+///   most the tier, the level of a check being the check level of its policy
+///   for the _P macros and 1 for the others. Code can also read the tier with
+///   get() to decide at runtime how many of its own checks to run. Every check
+///   is made until a check rule lowers the tier.
+///
+/// A pattern P is * for every site, a name ending in * for every site whose
+/// function name starts with the rest, file:line for the site at that line of
+/// a file whose path ends with file, or else the exact function name of a
+/// site. Rules are applied in order on top of the rate and level each site had
+/// the first time settings were published, so a later rule wins over an
+/// earlier one and removing a rule puts its sites back as they were.
+///
+/// The rules in the GWX_CONFIG environment variable, where rules are separated
+/// by semicolons, are published when the program starts, before main() is
+/// called, so a program that only uses the macros follows them too. Sites of a
+/// shared library are only enrolled once reached, so these rules do not reach
+/// them; see Site. Constructing an object of this class publishes the rules in
+/// the GWX_CONFIG environment variable again, followed by the rules in a file,
+/// and then watches the file with inotify on a thread of its own, publishing
+/// again every time the file is written or replaced. An operator can then
+/// raise the detail on a misbehaving process for a few minutes by editing the
+/// file, and lower it again afterwards.
+///
+/// @warning Settings published here and a Governor both change the levels of
+/// sites; if both are used, the last one to change a site wins.
+class Config
+{
+public:
+   // *
+   // * DECLERATIONS
+   // *
+   /// @brief A single rule.
+   struct Rule
+   {
+      /// @brief Kinds of rules.
+      enum class Kind
+      {
+         rate,
+         level
+      };
+      /// @brief Kind of rule.
+      Kind kind;
+      /// @brief Pattern of sites the rule applies to.
+      std::string pattern;
+      /// @brief Sampling rate set by a rate rule.
+      unsigned rate;
+      /// @brief Level of detail set by a level rule.
+      Site::Level level;
+   };
+   /// @brief An immutable set of settings.
+   struct Snapshot
+   {
+      /// @brief Number of times settings were published before this one.
+      std::uint64_t version {0};
+      /// @brief Check tier, the highest level of checks that are made.
+      int check {std::numeric_limits<int>::max()};
+      /// @brief Rules applied to sites, in order.
+      std::vector<Rule> rules;
+   };
+   // *
+   // * BASIC METHODS
+   // *
+   /// @brief Publishes settings from environment and file, then watches file.
+   ///
+   /// @param path Path of the file of rules, which need not exist yet.
+   Config(const std::string& path);
+   /// @brief Stops watching file, keeping the settings last published.
+   ~Config();
+   // *
+   // * COPY METHODS
+   // *
+   Config(const Config&) = delete;
+   Config& operator=(const Config&) = delete;
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   /// @brief Get settings in use.
+   static const Snapshot& get();
+   /// @brief Get whether checks of a level are made.
+   ///
+   /// @param level Level of the checks.
+   ///
+   /// @return True if the level is at most the check tier in use.
+   static bool checking(int level);
+   /// @brief Reads rules from text.
+   ///
+   /// @param text Text of rules, one per line or separated by semicolons.
+   /// @param out Snapshot the rules are added to.
+   ///
+   /// @return Number of lines that could not be read.
+   static std::size_t parse(std::string_view text, Snapshot& out);
+   /// @brief Applies settings to every site and makes them the ones in use.
+   ///
+   /// @param snapshot Settings to publish, whose version is set by this call.
+   static void publish(Snapshot snapshot);
+   /// @brief Get whether a site matches a pattern.
+   ///
+   /// @param site Site to match.
+   /// @param pattern Pattern of a rule.
+   static bool match(const Site& site, std::string_view pattern);
+private:
+   // *
+   // * FUNCTIONS
+   // *
+   void reload();
+   void run();
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   static bool start();
+   // *
+   // * VARIABLES
+   // *
+   std::string _path;
+   int _inotify {-1};
+   int _wake[2] {-1,-1};
+   std::thread _thread;
+   // *
+   // * STATIC VARIABLES
+   // *
+   static Snapshot _initial;
+   static std::atomic<const Snapshot*> _current;
+   static std::atomic<int> _check;
+   static const bool _started;
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | INLINE/TEMPLATE                                                          |
+// *==========================================================================*
+//
+//
+//
+
+
+
+inline const Config::Snapshot& Config::get()
+{
+   return *_current.load(std::memory_order_acquire);
+}
+
+
+
+inline bool Config::checking(int level)
+{
+   return level<=_check.load(std::memory_order_relaxed);
+}
+
+
+
+}
+#endif
@@ -0,0 +1,49 @@
+#include "context.h"
+namespace Gwers {
+
+
+
+void gwx_format(Format& str, const Context::Field& field)
+{
+   using Kind = Context::Field::Kind;
+   str << field.key() << "=";
+   switch (field.kind())
+   {
+   case Kind::boolean:
+      str << field.boolean();
+      break;
+   case Kind::integer:
+      str << field.integer();
+      break;
+   case Kind::natural:
+      str << field.natural();
+      break;
+   case Kind::real:
+      str << field.real();
+      break;
+   case Kind::pointer:
+      str << field.pointer();
+      break;
+   case Kind::text:
+      str << field.text();
+      break;
+   }
+}
+
+
+
+void gwx_format(Format& str, const Context& context)
+{
+   for (auto i = context.begin();i!=context.end();++i)
+   {
+      if (i!=context.begin())
+      {
+         str << " ";
+      }
+      str << *i;
+   }
+}
+
+
+
+}
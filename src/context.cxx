@@ -0,0 +1,158 @@
+#include <string>
+#include "unit.hh"
+#include "exception.h"
+namespace unit {
+/// @ingroup utest
+/// @brief Tests key value context of exceptions.
+///
+/// Tests the key value pairs attached to exceptions, consisting of the Context
+/// class and the GWX_ASSERT_C and GWX_CHECK_C macros.
+namespace context {
+GWX_DECLARE(unit::context)
+GWX_EXCEPTION(OutOfRange)
+/// @brief Policy with assertion checks disabled.
+GWX_POLICY(Unchecked,2,0)
+
+
+
+/// @brief Used for all strings.
+using string = std::string;
+/// @brief Used for throwing a unit test failure.
+using fail = UnitTest::Run::Fail;
+/// @brief Used as shorthand.
+using gwcx = Gwers::Context;
+/// @brief Used as shorthand.
+using kind = Gwers::Context::Field::Kind;
+
+
+
+/// @brief Internal enumeration used as a field value.
+enum class Color: unsigned { red, green };
+
+
+
+/// @brief Internal variable counting calls to value().
+int calls {0};
+
+
+
+/// @brief Internal function that counts how many times it is called.
+int value()
+{
+   return ++calls;
+}
+
+
+
+/// @brief Unit tests fields and formatting.
+///
+/// This function unit tests the Gwers::Context class. It performs these tests
+/// with two unit tests.
+///
+/// -# Adds a field of every kind to a context, making sure each keeps its key,
+/// kind, and value, that strings are cut off, and that fields past capacity
+/// are ignored.
+///
+/// -# Formats a context, making sure every field is written as key=value
+/// separated by spaces.
+void basic(UnitTest::Run& ut)
+{
+   int i {-7};
+   unsigned size {4};
+   const char* name {"a very long name that will not fit"};
+   gwcx c;
+   c.add(GWX_KV(i));
+   c.add(GWX_KV(size));
+   c.add(GWX_KV(name));
+   c.add(gwcx::Field("color",Color::green));
+   c.add(gwcx::Field("ignored",true));
+   const gwcx::Field* f {c.find("name")};
+   if (c.size()!=gwcx::capacity||c.find("ignored")||!f||
+       f->kind()!=kind::text||f->text()!=string(name,gwcx::text_size)||
+       c.find("i")->kind()!=kind::integer||c.find("i")->integer()!=-7||
+       c.find("size")->kind()!=kind::natural||c.find("size")->natural()!=4||
+       c.find("color")->kind()!=kind::natural||c.find("color")->natural()!=1)
+   {
+      throw fail();
+   }
+   ut.next();
+   gwcx d;
+   double ratio {0.5};
+   bool ok {false};
+   d.add(GWX_KV(ratio));
+   d.add(GWX_KV(ok));
+   d.add(GWX_KV(size+1));
+   Gwers::Format::Fixed<64> str;
+   str << d;
+   if (str.view()!="ratio=0.5 ok=0 size+1=5")
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Unit tests the GWX_ASSERT_C and GWX_CHECK_C macros.
+///
+/// This function unit tests throwing exceptions with context. It performs these
+/// tests with three unit tests.
+///
+/// -# Makes sure a passing GWX_ASSERT_C does not throw or evaluate any of its
+/// values.
+///
+/// -# Makes sure a failing GWX_ASSERT_C throws the given exception with the
+/// given values in its context.
+///
+/// -# Makes sure GWX_CHECK_C_P with a policy that disables checks still
+/// executes its condition but never throws.
+void macros(UnitTest::Run& ut)
+{
+   calls = 0;
+   int index {2};
+   int size {4};
+   GWX_ASSERT_C(index<size,OutOfRange,__LINE__,GWX_KV(value()));
+   if (calls!=0)
+   {
+      throw fail();
+   }
+   ut.next();
+   index = 9;
+   try
+   {
+      GWX_ASSERT_C(index<size,OutOfRange,__LINE__,GWX_KV(index),
+                   GWX_KV(size));
+      throw fail();
+   }
+   catch (OutOfRange& e)
+   {
+      Gwers::Trace::flush();
+      const gwcx& c {e.context()};
+      if (e.what()!=string("OutOfRange")||c.size()!=2||
+          c.begin()->integer()!=9||string(c.begin()->key())!="index"||
+          c.find("size")->integer()!=4)
+      {
+         throw fail();
+      }
+   }
+   ut.next();
+   GWX_CHECK_C_P(Unchecked,value()<0,OutOfRange,__LINE__,GWX_KV(index));
+   if (calls!=1)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Initialize all unit tests for Context class.
+void init(UnitTest& ut)
+{
+   UnitTest::Run& t = ut.add("Context",nullptr,nullptr);
+   t.add("basic",basic);
+   t.add("macros",macros);
+}
+
+
+
+}
+}
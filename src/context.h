@@ -0,0 +1,335 @@
+#ifndef GWERS_CONTEXT_H
+#define GWERS_CONTEXT_H
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+#include "format.h"
+#define GWX_KV(V) ::Gwers::Context::Field(#V,V)
+namespace Gwers {
+
+
+
+/// @ingroup exception
+/// @brief Typed key value pairs describing why an exception was thrown.
+///
+/// This holds a few values attached to an exception by the GWX_ASSERT_C and
+/// GWX_CHECK_C macros, such as the sizes, ids, or offsets that made a check
+/// fail. Each value is kept with its key and its type in a fixed array inside
+/// the exception object, so attaching them allocates nothing and formats
+/// nothing; a value is only turned into text if something writes the context
+/// with a Format. Exporters that want the values themselves instead of text can
+/// walk the fields and read each one by its kind.
+///
+/// Keys are never copied and must be string literals, which they are when made
+/// by the GWX_KV(V) macro, whose key is the text of the expression V. Strings
+/// given as values are copied into the field, cut off if they are longer than
+/// text_size characters. Fields past capacity are ignored.
+class Context
+{
+public:
+   // *
+   // * CONSTANTS
+   // *
+   /// @brief Number of fields a context holds.
+   static constexpr std::size_t capacity {4};
+   /// @brief Number of characters of a string value a field holds.
+   static constexpr std::size_t text_size {23};
+   // *
+   // * DECLERATIONS
+   // *
+   /// @brief A single key value pair of a context.
+   class Field
+   {
+   public:
+      // *
+      // * DECLERATIONS
+      // *
+      /// @brief Kinds of values a field can hold.
+      enum class Kind: unsigned char
+      {
+         boolean, ///< Bool, read with boolean().
+         integer, ///< Signed integer or enum, read with integer().
+         natural, ///< Unsigned integer or enum, read with natural().
+         real, ///< Floating point number, read with real().
+         pointer, ///< Pointer, read with pointer().
+         text ///< String, read with text().
+      };
+      // *
+      // * BASIC METHODS
+      // *
+      /// @brief Initializes field.
+      ///
+      /// @tparam T Type of value, which must be arithmetic, an enum, a pointer,
+      /// or convertible to std::string_view.
+      ///
+      /// @param key Key of field, which must outlive the field.
+      /// @param value Value of field.
+      template<class T> Field(const char* key, const T& value);
+      // *
+      // * FUNCTIONS
+      // *
+      /// @brief Get key of field.
+      const char* key() const;
+      /// @brief Get kind of value held.
+      Kind kind() const;
+      /// @brief Get value of a boolean field.
+      bool boolean() const;
+      /// @brief Get value of an integer field.
+      std::int64_t integer() const;
+      /// @brief Get value of a natural field.
+      std::uint64_t natural() const;
+      /// @brief Get value of a real field.
+      double real() const;
+      /// @brief Get value of a pointer field.
+      const void* pointer() const;
+      /// @brief Get value of a text field.
+      std::string_view text() const;
+   private:
+      friend class Context;
+      // *
+      // * BASIC METHODS
+      // *
+      Field() = default;
+      // *
+      // * FUNCTIONS
+      // *
+      void set(std::string_view value);
+      // *
+      // * VARIABLES
+      // *
+      const char* _key {nullptr};
+      union
+      {
+         bool _boolean;
+         std::int64_t _integer;
+         std::uint64_t _natural {0};
+         double _real;
+         const void* _pointer;
+         char _text[text_size+1];
+      };
+      Kind _kind {Kind::natural};
+   };
+   // *
+   // * FUNCTIONS
+   // *
+   /// @brief Get number of fields.
+   std::size_t size() const;
+   /// @brief Get whether this context holds no fields.
+   bool empty() const;
+   /// @brief Get first field.
+   const Field* begin() const;
+   /// @brief Get one past the last field.
+   const Field* end() const;
+   /// @brief Finds field by key.
+   ///
+   /// @param key Key of field.
+   ///
+   /// @return Pointer to first field with the given key or nullptr if there is
+   /// none.
+   const Field* find(std::string_view key) const;
+   /// @brief Adds field unless this context is full.
+   ///
+   /// @param field Field to add.
+   void add(const Field& field);
+private:
+   // *
+   // * VARIABLES
+   // *
+   Field _fields[capacity];
+   std::size_t _size {0};
+};
+
+
+
+/// @brief Writes field as key=value.
+void gwx_format(Format& str, const Context::Field& field);
+/// @brief Writes every field as key=value separated by spaces.
+void gwx_format(Format& str, const Context& context);
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | INLINE/TEMPLATE                                                          |
+// *==========================================================================*
+//
+//
+//
+
+
+
+inline std::size_t Context::size() const
+{
+   return _size;
+}
+
+
+
+inline bool Context::empty() const
+{
+   return _size==0;
+}
+
+
+
+inline const Context::Field* Context::begin() const
+{
+   return _fields;
+}
+
+
+
+inline const Context::Field* Context::end() const
+{
+   return begin()+_size;
+}
+
+
+
+inline const Context::Field* Context::find(std::string_view key) const
+{
+   for (auto i = begin();i!=end();++i)
+   {
+      if (key==i->key())
+      {
+         return i;
+      }
+   }
+   return nullptr;
+}
+
+
+
+inline void Context::add(const Field& field)
+{
+   if (_size<capacity)
+   {
+      _fields[_size++] = field;
+   }
+}
+
+
+
+template<class T> Context::Field::Field(const char* key, const T& value):
+   _key {key}
+{
+   if constexpr (std::is_same<T,bool>::value)
+   {
+      _kind = Kind::boolean;
+      _boolean = value;
+   }
+   else if constexpr (std::is_enum<T>::value)
+   {
+      *this = Field(key,static_cast<std::underlying_type_t<T>>(value));
+   }
+   else if constexpr (std::is_integral<T>::value&&std::is_signed<T>::value)
+   {
+      _kind = Kind::integer;
+      _integer = value;
+   }
+   else if constexpr (std::is_integral<T>::value)
+   {
+      _kind = Kind::natural;
+      _natural = value;
+   }
+   else if constexpr (std::is_floating_point<T>::value)
+   {
+      _kind = Kind::real;
+      _real = static_cast<double>(value);
+   }
+   else if constexpr (std::is_convertible<const T&,const char*>::value)
+   {
+      const char* text {value};
+      set(text?text:"(null)");
+   }
+   else if constexpr (std::is_convertible<const T&,std::string_view>::value)
+   {
+      set(value);
+   }
+   else
+   {
+      static_assert(std::is_pointer<T>::value,
+                    "Context field value must be arithmetic, enum, pointer, or "
+                    "string.");
+      _kind = Kind::pointer;
+      _pointer = static_cast<const void*>(value);
+   }
+}
+
+
+
+inline const char* Context::Field::key() const
+{
+   return _key;
+}
+
+
+
+inline Context::Field::Kind Context::Field::kind() const
+{
+   return _kind;
+}
+
+
+
+inline bool Context::Field::boolean() const
+{
+   return _boolean;
+}
+
+
+
+inline std::int64_t Context::Field::integer() const
+{
+   return _integer;
+}
+
+
+
+inline std::uint64_t Context::Field::natural() const
+{
+   return _natural;
+}
+
+
+
+inline double Context::Field::real() const
+{
+   return _real;
+}
+
+
+
+inline const void* Context::Field::pointer() const
+{
+   return _pointer;
+}
+
+
+
+inline std::string_view Context::Field::text() const
+{
+   return _text;
+}
+
+
+
+inline void Context::Field::set(std::string_view value)
+{
+   std::size_t size {value.size()<text_size?value.size():text_size};
+   _kind = Kind::text;
+   if (size>0)
+   {
+      std::memcpy(_text,value.data(),size);
+   }
+   _text[size] = '\0';
+}
+
+
+
+}
+#endif
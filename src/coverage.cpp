@@ -0,0 +1,222 @@
+#include "coverage.h"
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include "format.h"
+#include "site.h"
+namespace Gwers {
+
+
+
+struct Coverage::Map
+{
+   std::atomic<std::uint64_t> words[capacity/64];
+   std::atomic<std::uint64_t> epoch;
+};
+
+
+
+namespace
+{
+   std::mutex g_mutex;
+   std::atomic<std::uint32_t> g_next {0};
+}
+
+
+
+std::atomic<bool> Coverage::_covering {false};
+std::atomic<std::uint64_t> Coverage::_epoch {0};
+Coverage::Map Coverage::_exited {};
+std::vector<Coverage::Map*> Coverage::_maps;
+thread_local Coverage::Handle Coverage::_handle {};
+
+
+
+Coverage::Handle::~Handle()
+{
+   if (map)
+   {
+      std::lock_guard<std::mutex> lock {g_mutex};
+      std::uint64_t epoch {map->epoch.load(std::memory_order_relaxed)};
+      if (epoch==_exited.epoch.load(std::memory_order_relaxed))
+      {
+         for (std::size_t i = 0;i<capacity/64;++i)
+         {
+            std::uint64_t word {map->words[i].load(std::memory_order_relaxed)};
+            if (word)
+            {
+               _exited.words[i].fetch_or(word,std::memory_order_relaxed);
+            }
+         }
+      }
+      _maps.erase(std::find(_maps.begin(),_maps.end(),map));
+      delete map;
+   }
+}
+
+
+
+void Coverage::start()
+{
+   std::lock_guard<std::mutex> lock {g_mutex};
+   std::uint64_t epoch {_epoch.load(std::memory_order_relaxed)+1};
+   clear(_exited);
+   _exited.epoch.store(epoch,std::memory_order_relaxed);
+   _epoch.store(epoch,std::memory_order_release);
+   _covering.store(true,std::memory_order_release);
+}
+
+
+
+void Coverage::stop()
+{
+   _covering.store(false,std::memory_order_release);
+}
+
+
+
+std::vector<Site*> Coverage::covered()
+{
+   std::unique_ptr<Map> merged {new Map {}};
+   merge(*merged);
+   std::vector<Site*> ret;
+   for (auto i:Site::all())
+   {
+      std::uint32_t index {i->_index.load(std::memory_order_relaxed)};
+      if (index>0&&index<=capacity&&
+          merged->words[(index-1)/64].load(std::memory_order_relaxed)&
+          std::uint64_t(1)<<(index-1)%64)
+      {
+         ret.push_back(i);
+      }
+   }
+   return ret;
+}
+
+
+
+void Coverage::print(int fd)
+{
+   Site::list sites {Site::all()};
+   std::vector<Site*> reached {covered()};
+   Format::Fixed<512> str;
+   str << "COVERAGE: " << reached.size() << " of " << sites.size()
+       << " sites reached\n";
+   str.put(fd);
+   auto r = reached.begin();
+   for (auto i:sites)
+   {
+      bool hit {r!=reached.end()&&*r==i};
+      if (hit)
+      {
+         ++r;
+      }
+      str.clear();
+      str << (hit?"+ ":"- ") << i->file() << ":" << i->line() << " "
+          << i->function() << "\n";
+      str.put(fd);
+   }
+}
+
+
+
+void Coverage::hit(Site* site)
+{
+   std::uint32_t index {site->_index.load(std::memory_order_relaxed)};
+   if (index==0)
+   {
+      index = Coverage::index(site);
+   }
+   if (index>capacity)
+   {
+      return;
+   }
+   Map* map {_handle.map};
+   std::uint64_t epoch {_epoch.load(std::memory_order_acquire)};
+   if (!map||_handle.epoch!=epoch)
+   {
+      map = attach(epoch);
+   }
+   std::atomic<std::uint64_t>& word {map->words[(index-1)/64]};
+   std::uint64_t bit {std::uint64_t(1)<<(index-1)%64};
+   std::uint64_t value {word.load(std::memory_order_relaxed)};
+   if (!(value&bit))
+   {
+      word.store(value|bit,std::memory_order_relaxed);
+   }
+}
+
+
+
+std::uint32_t Coverage::index(Site* site)
+{
+   std::uint32_t ret {0};
+   std::uint32_t next {g_next.fetch_add(1,std::memory_order_relaxed)+1};
+   if (site->_index.compare_exchange_strong(ret,next,
+                                            std::memory_order_relaxed))
+   {
+      ret = next;
+   }
+   return ret;
+}
+
+
+
+Coverage::Map* Coverage::attach(std::uint64_t epoch)
+{
+   Map* map {_handle.map};
+   if (!map)
+   {
+      map = new Map {};
+      std::lock_guard<std::mutex> lock {g_mutex};
+      _maps.push_back(map);
+   }
+   else
+   {
+      map->epoch.store(0,std::memory_order_release);
+      clear(*map);
+   }
+   map->epoch.store(epoch,std::memory_order_release);
+   _handle.map = map;
+   _handle.epoch = epoch;
+   return map;
+}
+
+
+
+void Coverage::clear(Map& map)
+{
+   for (auto& i:map.words)
+   {
+      i.store(0,std::memory_order_relaxed);
+   }
+}
+
+
+
+void Coverage::merge(Map& out)
+{
+   std::lock_guard<std::mutex> lock {g_mutex};
+   std::uint64_t epoch {_epoch.load(std::memory_order_acquire)};
+   std::vector<Map*> maps {_maps};
+   maps.push_back(&_exited);
+   for (auto m:maps)
+   {
+      if (m->epoch.load(std::memory_order_acquire)!=epoch)
+      {
+         continue;
+      }
+      for (std::size_t i = 0;i<capacity/64;++i)
+      {
+         std::uint64_t word {m->words[i].load(std::memory_order_relaxed)};
+         if (word)
+         {
+            out.words[i].fetch_or(word,std::memory_order_relaxed);
+         }
+      }
+   }
+}
+
+
+
+}
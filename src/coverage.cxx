@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "unit.hh"
+#include "trace.h"
+namespace unit {
+/// @ingroup utest
+/// @brief Tests the coverage map of sites.
+///
+/// Tests the recording of which sites have been reached, consisting of the
+/// Coverage class.
+namespace coverage {
+
+
+
+/// @brief Used for all strings.
+using string = std::string;
+/// @brief Used for throwing a unit test failure.
+using fail = UnitTest::Run::Fail;
+/// @brief Used as shorthand.
+using gwcv = Gwers::Coverage;
+/// @brief Used as shorthand.
+using gws = Gwers::Site;
+
+
+
+/// @brief Internal function reached on this thread.
+void here()
+{
+   GWX_BEGIN("unit::coverage::here()");
+}
+
+
+
+/// @brief Internal function reached on another thread.
+void there()
+{
+   GWX_BEGIN_S(1000,"unit::coverage::there()");
+}
+
+
+
+/// @brief Internal function only reached while coverage is off.
+void later()
+{
+   GWX_BEGIN("unit::coverage::later()");
+}
+
+
+
+/// @brief Internal function that is never called.
+void never()
+{
+   GWX_BEGIN("unit::coverage::never()");
+}
+
+
+
+/// @brief Internal function that makes sure a function has a reached site.
+bool reached(const std::vector<gws*>& sites, const string& function)
+{
+   return std::any_of(sites.begin(),sites.end(),[&](gws* i) {
+      return function==i->function();
+   });
+}
+
+
+
+/// @brief Unit tests recording and merging reached sites.
+///
+/// This function unit tests the start(), stop(), covered(), and print()
+/// functions of the Gwers::Coverage class. It performs these tests with three
+/// unit tests.
+///
+/// -# Reaches one site on this thread and a sampled site on a thread that then
+/// exits, making sure both are covered while a site reached only after
+/// stopping and a site never reached are not.
+///
+/// -# Prints every site, making sure reached sites are marked with + and the
+/// others with -.
+///
+/// -# Starts again, making sure the sites reached before are forgotten until
+/// they are reached again.
+///
+/// Since starting forgets every site reached so far, coverage is started again
+/// at the end if it was on before, which is why this runs first.
+void basic(UnitTest::Run& ut)
+{
+   bool was {gwcv::covering()};
+   gwcv::start();
+   here();
+   std::thread t([] { there(); });
+   t.join();
+   gwcv::stop();
+   later();
+   std::vector<gws*> sites {gwcv::covered()};
+   if (gwcv::covering()||!reached(sites,"unit::coverage::here()")||
+       !reached(sites,"unit::coverage::there()")||
+       reached(sites,"unit::coverage::later()")||
+       reached(sites,"unit::coverage::never()"))
+   {
+      throw fail();
+   }
+   ut.next();
+   int fds[2];
+   if (pipe(fds)!=0)
+   {
+      throw fail();
+   }
+   std::thread reader([&] {
+      gwcv::print(fds[1]);
+      close(fds[1]);
+   });
+   string out;
+   char buffer[256];
+   ssize_t n;
+   while ((n = read(fds[0],buffer,sizeof(buffer)))>0)
+   {
+      out.append(buffer,n);
+   }
+   reader.join();
+   close(fds[0]);
+   if (out.find("COVERAGE: "+std::to_string(sites.size())+" of ")!=0||
+       out.find(" unit::coverage::here()\n")==string::npos||
+       out[out.rfind("\n",out.find(" unit::coverage::here()\n"))+1]!='+'||
+       out[out.rfind("\n",out.find(" unit::coverage::never()\n"))+1]!='-')
+   {
+      throw fail();
+   }
+   ut.next();
+   gwcv::start();
+   here();
+   sites = gwcv::covered();
+   if (was)
+   {
+      gwcv::start();
+   }
+   else
+   {
+      gwcv::stop();
+   }
+   if (!reached(sites,"unit::coverage::here()")||
+       reached(sites,"unit::coverage::there()"))
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Initialize all unit tests for Coverage class.
+void init(UnitTest& ut)
+{
+   UnitTest::Run& t = ut.add("Coverage",nullptr,nullptr);
+   t.add("basic",basic);
+}
+
+
+
+}
+}
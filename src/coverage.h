@@ -0,0 +1,118 @@
+#ifndef GWERS_COVERAGE_H
+#define GWERS_COVERAGE_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+namespace Gwers {
+class Site;
+
+
+
+/// @ingroup exception
+/// @brief Records which sites the program has reached.
+///
+/// While coverage is on, every call through a site sets the bit of that site
+/// in a bitmap belonging to the calling thread. Since a thread only ever writes
+/// its own bitmap, and only the first call through a site changes it, a call
+/// costs one more load of a word the thread already owns and needs no atomic
+/// read-modify-write, which is cheap enough to leave on for long soak tests
+/// where gcov would be far too slow. This is counted whatever the sampling rate
+/// or level of the site, even one that is off.
+///
+/// The bitmaps of all threads, including those that have exited, are merged
+/// with a bitwise or whenever covered() or print() is called, and compared
+/// with the list of all sites so the ones never reached are shown as well.
+/// Each site is given its bit the first time any thread reaches it, and each
+/// bitmap holds capacity bits; sites reached after that many are not counted.
+///
+/// @warning A GWX_BEGIN_P site whose policy turns tracing off compiles to
+/// nothing and is therefore never counted as reached.
+class Coverage
+{
+public:
+   // *
+   // * CONSTANTS
+   // *
+   /// @brief Largest number of sites that can be counted.
+   static constexpr std::size_t capacity {65536};
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   /// @brief Forgets every site reached so far and turns coverage on.
+   static void start();
+   /// @brief Turns coverage off, keeping the sites reached so far.
+   static void stop();
+   /// @brief Get whether coverage is on.
+   static bool covering();
+   /// @brief Get sites reached since coverage was last started.
+   ///
+   /// @return Sites reached by any thread, sorted as all() sorts them.
+   static std::vector<Site*> covered();
+   /// @brief Writes every site of the program as text with whether it has been
+   /// reached.
+   ///
+   /// @param fd File descriptor the text is written to.
+   ///
+   /// A first line gives how many sites were reached out of all sites, then
+   /// each site follows on its own line marked with + if it was reached or -
+   /// if it was not.
+   static void print(int fd);
+   /// @brief Records site reached by this thread.
+   ///
+   /// @param site Site reached.
+   ///
+   /// @warning This function should never be called directly by the user. It
+   /// is called by the Site class.
+   static void hit(Site* site);
+private:
+   // *
+   // * DECLERATIONS
+   // *
+   struct Map;
+   struct Handle
+   {
+      ~Handle();
+      Map* map {nullptr};
+      std::uint64_t epoch {0};
+   };
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   static std::uint32_t index(Site* site);
+   static Map* attach(std::uint64_t epoch);
+   static void clear(Map& map);
+   static void merge(Map& out);
+   // *
+   // * STATIC VARIABLES
+   // *
+   static std::atomic<bool> _covering;
+   static std::atomic<std::uint64_t> _epoch;
+   static Map _exited;
+   static std::vector<Map*> _maps;
+   thread_local static Handle _handle;
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | INLINE/TEMPLATE                                                          |
+// *==========================================================================*
+//
+//
+//
+
+
+
+inline bool Coverage::covering()
+{
+   return _covering.load(std::memory_order_relaxed);
+}
+
+
+
+}
+#endif
@@ -1,20 +1,27 @@
 #include "exception.h"
+#include <cstdlib>
 namespace Gwers {
 
 
 
+std::atomic<Exception::ffp> Exception::_fatal {dump};
+
+
+
 void Exception::base_catch(fp base, efp handler)
 {
-   Trace::flush();
+   std::size_t depth {Trace::locked()?0:Trace::depth()};
+   Trace::rewind(depth);
+#ifdef GWX__EXCEPTIONS
    try
    {
       base();
    }
-   catch (Exception e)
+   catch (Exception& e)
    {
       handler(Type::gwers,&e,nullptr);
    }
-   catch (std::exception e)
+   catch (std::exception& e)
    {
       handler(Type::std,nullptr,&e);
    }
@@ -22,6 +29,63 @@ void Exception::base_catch(fp base, efp handler)
    {
       handler(Type::unknown,nullptr,nullptr);
    }
+   Trace::rewind(depth);
+#else
+   (void)handler;
+   base();
+#endif
+}
+
+
+
+void Exception::fatal(const Exception& e)
+{
+   _fatal.load()(e,Trace::begin(),Trace::end());
+   std::abort();
+}
+
+
+
+void Exception::set_fatal(ffp handler)
+{
+   _fatal.store(handler?handler:dump);
+}
+
+
+
+void Exception::dump(const Exception& e, Trace::iter begin, Trace::iter end)
+{
+   Format::Fixed<512> str;
+   str << "Gwers: " << e.who() << ":" << e.what() << " line " << e.line()
+       << "\n";
+   if (!e.context().empty())
+   {
+      str << "CONTEXT: " << e.context() << "\n";
+   }
+   str << "TRACE:\n";
+   report(str);
+   for (auto i = begin;i!=end;++i)
+   {
+      str.clear();
+      str << *i << "\n";
+      report(str);
+   }
+}
+
+
+
+void Exception::report(const Format& str)
+{
+   str.put(2);
+}
+
+
+
+void Exception::probe() const
+{
+#ifdef GWX_USDT
+   Probe::raise(_who.c_str(),_what.c_str(),_line);
+#endif
 }
 
 
@@ -1,3 +1,7 @@
+#include <csignal>
+#include <cstring>
+#include <sys/wait.h>
+#include <unistd.h>
 #include "unit.hh"
 #include "exception.h"
 namespace unit {
@@ -6,6 +10,14 @@ namespace unit {
 ///
 /// Tests the exception handling system, consisting of the Exception class.
 namespace exception {
+GWX_DECLARE(unit::exception)
+GWX_EXCEPTION(Failed)
+/// @brief Policy with assertion checks enabled.
+GWX_POLICY(Checked,2,1)
+/// @brief Policy with assertion checks disabled.
+GWX_POLICY(Unchecked,2,0)
+/// @brief Policy with assertion checks of the second tier.
+GWX_POLICY(Heavy,2,2)
 
 
 
@@ -17,6 +29,8 @@ using fail = UnitTest::Run::Fail;
 using gwe = Gwers::Exception;
 /// @brief Used as shorthand.
 using gwtr = Gwers::Trace;
+/// @brief Used as shorthand.
+using gwc = Gwers::Config;
 
 
 
@@ -40,7 +54,7 @@ void basic(UnitTest::Run&)
       gwtr t("TestFunction");
       throw gwe("test_who","test_what",33);
    }
-   catch (gwe t)
+   catch (const gwe& t)
    {
       if (t.line()!=33||t.who()!=string("test_who")||
           t.what()!=string("test_what")||
@@ -79,7 +93,7 @@ void assert(UnitTest::Run& ut)
    {
       gwe::assert<Fake>(false,66);
    }
-   catch (Fake e)
+   catch (const Fake& e)
    {
       if (e.line()==66)
       {
@@ -96,7 +110,7 @@ void assert(UnitTest::Run& ut)
    {
       gwe::assert<Fake>(true,66);
    }
-   catch (Fake)
+   catch (const Fake&)
    {
       test = false;
    }
@@ -223,6 +237,250 @@ void base_catch(UnitTest::Run& ut)
 
 
 
+/// @brief Internal fatal handler that is used with fatal() unit testing.
+///
+/// Writes the who, what, line, and top function item it is given to standard
+/// output, then exits the process with a status of 0.
+void fatal_func(const gwe& e, gwtr::iter begin, gwtr::iter end)
+{
+   string out {e.who()+":"+e.what()+":"+std::to_string(e.line())};
+   if (begin!=end)
+   {
+      out += ":"+*(--end);
+   }
+   if (write(1,out.c_str(),out.size())<0)
+   {
+      _exit(1);
+   }
+   _exit(0);
+}
+
+
+
+/// @brief Internal function that runs a function in a child process.
+///
+/// @param child Function ran in the child process, whose standard output and
+/// standard error are captured.
+/// @param status Set to the wait status of the child process.
+///
+/// @return Everything the child process wrote.
+string run_child(void (*child)(), int& status)
+{
+   int fds[2];
+   if (pipe(fds)!=0)
+   {
+      throw fail();
+   }
+   pid_t pid {fork()};
+   if (pid==0)
+   {
+      dup2(fds[1],1);
+      dup2(fds[1],2);
+      close(fds[0]);
+      child();
+      _exit(2);
+   }
+   close(fds[1]);
+   string ret;
+   char buffer[256];
+   ssize_t n;
+   while ((n = read(fds[0],buffer,sizeof(buffer)))>0)
+   {
+      ret.append(buffer,n);
+   }
+   close(fds[0]);
+   waitpid(pid,&status,0);
+   return ret;
+}
+
+
+
+/// @brief Internal function that calls fatal() with a custom handler.
+void fatal_custom()
+{
+   gwe::set_fatal(fatal_func);
+   gwtr t("frame");
+   gwe::fatal(gwe("test_who","test_what",66));
+}
+
+
+
+/// @brief Internal function that calls fatal() with the default handler.
+void fatal_default()
+{
+   gwtr t("frame");
+   gwe::fatal(gwe("test_who","test_what",66));
+}
+
+
+
+/// @brief Unit tests static fatal function.
+///
+/// This function unit tests the static Gwers::Exception::fatal() and
+/// Gwers::Exception::set_fatal() functions along with the default fatal
+/// handler. Each test is ran in a child process, because fatal() never
+/// returns. It performs these tests with two unit tests.
+///
+/// -# Installs a custom fatal handler and calls fatal within a Trace object in
+/// a child process, making sure the handler was given the correct exception
+/// information and function stack.
+///
+/// -# Calls fatal within a Trace object in a child process with the default
+/// fatal handler, making sure the exception information and function stack
+/// were written to standard error and the child process aborted.
+void fatal(UnitTest::Run& ut)
+{
+   int status;
+   string out {run_child(fatal_custom,status)};
+   if (!WIFEXITED(status)||WEXITSTATUS(status)!=0||
+       out!=string("test_who:test_what:66:frame"))
+   {
+      throw fail();
+   }
+   ut.next();
+   out = run_child(fatal_default,status);
+   if (!WIFSIGNALED(status)||WTERMSIG(status)!=SIGABRT||
+       out.find("test_who:test_what line 66")==string::npos||
+       out.find("frame")==string::npos)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Internal variable that is used with policy unit testing.
+int touch_count;
+
+
+
+/// @brief Internal function that is used with policy unit testing.
+bool touch()
+{
+   ++touch_count;
+   return false;
+}
+
+
+
+/// @brief Unit tests the assertion macros with policies.
+///
+/// This function unit tests the GWX_ASSERT_P, GWX_CHECK_P, and GWX_PASS_P
+/// macros with policies that enable and disable assertion checks. It performs
+/// these tests with three unit tests.
+///
+/// -# Uses GWX_ASSERT_P with a failing condition and a policy with checks
+/// disabled, making sure nothing is thrown and the condition is not executed.
+///
+/// -# Uses GWX_CHECK_P and GWX_PASS_P with failing conditions and a policy
+/// with checks disabled, making sure nothing is thrown and both conditions are
+/// still executed.
+///
+/// -# Uses GWX_ASSERT_P with a failing condition and a policy with checks
+/// enabled, making sure the exception given is thrown.
+void policy(UnitTest::Run& ut)
+{
+   touch_count = 0;
+   GWX_ASSERT_P(Unchecked,touch(),Failed,__LINE__);
+   if (touch_count!=0)
+   {
+      throw fail();
+   }
+   ut.next();
+   GWX_CHECK_P(Unchecked,touch(),Failed,__LINE__);
+   GWX_PASS_P(Unchecked,true,==,touch(),Failed,__LINE__);
+   if (touch_count!=2)
+   {
+      throw fail();
+   }
+   ut.next();
+   bool caught {false};
+   try
+   {
+      GWX_ASSERT_P(Checked,touch(),Failed,__LINE__);
+   }
+   catch (Failed& e)
+   {
+      caught = e.who()==string("unit::exception");
+   }
+   gwtr::flush();
+   if (!caught||touch_count!=3)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Unit tests the assertion macros with the check tier of Gwers::Config.
+///
+/// This function unit tests the assertion macros with check tiers published
+/// at runtime. It performs these tests with three unit tests.
+///
+/// -# Publishes a check tier of 1, making sure a failing GWX_ASSERT_P and
+/// GWX_CHECK_P with a policy of check level 2 throw nothing, the condition of
+/// the first not being executed and that of the second still being executed,
+/// while a failing GWX_ASSERT still throws.
+///
+/// -# Publishes a check tier of 0, making sure a failing GWX_ASSERT and
+/// GWX_CHECK_C throw nothing, only the condition of the second being executed.
+///
+/// -# Publishes no check tier, making sure a failing GWX_ASSERT_P with a policy
+/// of check level 2 throws again.
+void tier(UnitTest::Run& ut)
+{
+   gwc::Snapshot s;
+   gwc::parse("check 1",s);
+   gwc::publish(s);
+   touch_count = 0;
+   GWX_ASSERT_P(Heavy,touch(),Failed,__LINE__);
+   GWX_CHECK_P(Heavy,touch(),Failed,__LINE__);
+   bool caught {false};
+   try
+   {
+      GWX_ASSERT(touch(),Failed,__LINE__);
+   }
+   catch (Failed&)
+   {
+      caught = true;
+   }
+   gwtr::flush();
+   if (!caught||touch_count!=2)
+   {
+      gwc::publish(gwc::Snapshot());
+      throw fail();
+   }
+   ut.next();
+   s = gwc::Snapshot();
+   gwc::parse("check 0",s);
+   gwc::publish(s);
+   touch_count = 0;
+   GWX_ASSERT(touch(),Failed,__LINE__);
+   GWX_CHECK_C(touch(),Failed,__LINE__,GWX_KV(touch_count));
+   gwc::publish(gwc::Snapshot());
+   if (touch_count!=1)
+   {
+      throw fail();
+   }
+   ut.next();
+   caught = false;
+   try
+   {
+      GWX_ASSERT_P(Heavy,touch(),Failed,__LINE__);
+   }
+   catch (Failed&)
+   {
+      caught = true;
+   }
+   gwtr::flush();
+   if (!caught)
+   {
+      throw fail();
+   }
+}
+
+
+
 /// @brief Initialize all unit tests for Exception class.
 void init(UnitTest& ut)
 {
@@ -230,6 +488,9 @@ void init(UnitTest& ut)
    t.add("basic",basic);
    t.add("assert",assert);
    t.add("base_catch",base_catch);
+   t.add("fatal",fatal);
+   t.add("policy",policy);
+   t.add("tier",tier);
 }
 
 
@@ -1,26 +1,88 @@
 #ifndef GWERS_EXCEPTION_HH
 #define GWERS_EXCEPTION_HH
+#include <atomic>
 #include <string>
+#include "config.h"
+#include "context.h"
+#include "metrics.h"
+#include "profile.h"
+#include "tag.h"
 #include "trace.h"
-#ifdef DEBUG
+#if defined(__cpp_exceptions)||defined(__EXCEPTIONS)
+#define GWX__EXCEPTIONS
+#endif
+#define GWX_POLICY(N,T,C) struct N\
+                          {\
+                             static constexpr int trace {T};\
+                             static constexpr int check {C};\
+                          };
 #define GWX_DECLARE(N) static inline const char* GWX__get__who() { return #N; }
+#ifdef DEBUG
 #define GWX_EXCEPTION(X) struct X : public ::Gwers::Exception\
                          {\
                             X(int l):\
-                               ::Gwers::Exception(GWX__get__who(),#X,l)\
+                               ::Gwers::Exception(GWX__get__who(),#X,l,\
+                                                  GWX_COUNTER(#X))\
                             {}\
                          };
-#define GWX_ASSERT(T,X,L) ::Gwers::Exception::assert<X>(T,L);
-#define GWX_CHECK(T,X,L) ::Gwers::Exception::assert<X>(T,L);
-#define GWX_PASS(V,C,F,X,L) ::Gwers::Exception::assert<X>(V C F,L);
+#define GWX_ASSERT(T,X,L) GWX__ASSERT(1,T,X,L)
+#define GWX_CHECK(T,X,L) GWX__CHECK(1,T,X,L)
+#define GWX_PASS(V,C,F,X,L) GWX__PASS(1,V,C,F,X,L)
+#define GWX_ASSERT_C(T,X,L,...) GWX__ASSERT_C(1,T,X,L,__VA_ARGS__)
+#define GWX_CHECK_C(T,X,L,...) GWX__CHECK_C(1,T,X,L,__VA_ARGS__)
+#define GWX__ASSERT(N,T,X,L) ::Gwers::Exception::assert<X>(\
+                                !::Gwers::Config::checking(N)||(T),L);
+#define GWX__CHECK(N,T,X,L) ::Gwers::Exception::assert<X>(\
+                               (T)||!::Gwers::Config::checking(N),L);
+#define GWX__PASS(N,V,C,F,X,L) ::Gwers::Exception::assert<X>(\
+                                  (V C F)||!::Gwers::Config::checking(N),L);
+#define GWX__ASSERT_C(N,T,X,L,...) do { if (::Gwers::Config::checking(N)&&\
+                                          !(T)) {\
+                                      ::Gwers::Exception::raise<X>(L,\
+                                                                   __VA_ARGS__);\
+                                   } } while (0);
+#define GWX__CHECK_C(N,T,X,L,...) do { if (!(T)&&\
+                                         ::Gwers::Config::checking(N)) {\
+                                     ::Gwers::Exception::raise<X>(L,\
+                                                                  __VA_ARGS__);\
+                                  } } while (0);
+#ifdef GWX__EXCEPTIONS
 #define GWX_TRY(S,X,L) try { S; } catch(...) { throw X(L); }
 #else
-#define GWX_DECLARE(N)
+#define GWX_TRY(S,X,L) S;
+#endif
+#define GWX_ASSERT_P(P,T,X,L) do { if (P::check>0) {\
+                                 GWX__ASSERT(P::check,T,X,L) } } while (0);
+#define GWX_CHECK_P(P,T,X,L) do { if (P::check>0) {\
+                                GWX__CHECK(P::check,T,X,L) }\
+                                else { (void)(T); } } while (0);
+#define GWX_PASS_P(P,V,C,F,X,L) do { if (P::check>0) {\
+                                   GWX__PASS(P::check,V,C,F,X,L) }\
+                                   else { (void)(F); } } while (0);
+#define GWX_TRY_P(P,S,X,L) do { if (P::check>0) { GWX_TRY(S,X,L) }\
+                                else { S; } } while (0);
+#define GWX_ASSERT_C_P(P,T,X,L,...) do { if (P::check>0) {\
+                                       GWX__ASSERT_C(P::check,T,X,L,\
+                                                     __VA_ARGS__) } }\
+                                    while (0);
+#define GWX_CHECK_C_P(P,T,X,L,...) do { if (P::check>0) {\
+                                      GWX__CHECK_C(P::check,T,X,L,\
+                                                   __VA_ARGS__) }\
+                                      else { (void)(T); } } while (0);
+#else
 #define GWX_EXCEPTION(X)
 #define GWX_ASSERT(T,X,L)
-#define GWX_CHECK(T,X,L) T;
-#define GWX_PASS(V,C,F,X,L) F;
+#define GWX_CHECK(T,X,L) (void)(T);
+#define GWX_PASS(V,C,F,X,L) (void)(F);
 #define GWX_TRY(S,X,L) S;
+#define GWX_ASSERT_P(P,T,X,L)
+#define GWX_CHECK_P(P,T,X,L) (void)(T);
+#define GWX_PASS_P(P,V,C,F,X,L) (void)(F);
+#define GWX_TRY_P(P,S,X,L) S;
+#define GWX_ASSERT_C(T,X,L,...)
+#define GWX_CHECK_C(T,X,L,...) (void)(T);
+#define GWX_ASSERT_C_P(P,T,X,L,...)
+#define GWX_CHECK_C_P(P,T,X,L,...) (void)(T);
 #endif
 namespace Gwers {
 
@@ -43,8 +105,9 @@ namespace Gwers {
 ///
 /// GWX_DECLARE(N) must be called once before any GWX_EXCEPTION is defined
 /// within a namespace or class. N is the fully qualified name of the namespace
-/// or class, including all namespaces and classes it is nested within. If DEBUG
-/// is not defined then all GWX_DECLARE macros resolve to an empty string.
+/// or class, including all namespaces and classes it is nested within. Unlike
+/// the other macros it is the same whether DEBUG is defined or not, since the
+/// metrics of Gwers::Metrics are scoped by it as well.
 ///
 /// GWX_EXCEPTION(X) defines a new exception within the scope it is defined. It
 /// is recommended to define all exceptions within the individual classes of
@@ -77,6 +140,16 @@ namespace Gwers {
 /// not defined then the function F will still be executed but with no
 /// comparison or possibility of throwing an exception.
 ///
+/// GWX_ASSERT_C(T,X,L,...) and GWX_CHECK_C(T,X,L,...) work the same as
+/// GWX_ASSERT and GWX_CHECK but attach the values that explain the failure to
+/// the thrown exception, given after L as Gwers::Context::Field objects. The
+/// easiest way to make one is GWX_KV(V), which keys the value of the
+/// expression V by the text of V, so GWX_ASSERT_C(i<size,OutOfRange,__LINE__,
+/// GWX_KV(i),GWX_KV(size)) throws with the context i=7 size=4. The values are
+/// only evaluated if T is false, are stored in a small fixed array inside the
+/// exception with their types, and are only formatted into text if someone
+/// writes them out; see Exception::context().
+///
 /// GWX_TRY(S,X,L) will catch any exception thrown by S, throwing a new
 /// exception of type X. S will almost always be a system function that has the
 /// potential of throwing an exception that is not of type Gwers::Exception. If
@@ -92,9 +165,51 @@ namespace Gwers {
 /// resolution and all arguments, and the variable list of argument after F is
 /// the list of all arguments given to the function, if any. By providing the
 /// values of all function arguments the stack trace information will provide a
-/// very rich depth of information. It is recommended to use
-/// %__PRETTY_FUNCTION__ for the F argument of GWX_BEGIN. If DTRACE is not
-/// defined then all X_BEGIN macros resolve to an empty line.
+/// very rich depth of information. It is recommended to use GWX_FUNCTION for
+/// the F argument of GWX_BEGIN, which is %__PRETTY_FUNCTION__ shortened at
+/// compile time to the qualified function name and parameter list, without the
+/// return type and with template arguments trimmed; see Gwers::Trace::Name.
+/// GWX_BEGIN_I(F,...) works the same as GWX_BEGIN but interns the resulting
+/// function item, for names built at runtime that repeat heavily; see
+/// Gwers::Intern. GWX_BEGIN_S(N,F,...) works the same as GWX_BEGIN but only
+/// traces one of every N calls, for small functions called so often that
+/// tracing every call costs too much; the rate of any site can also be changed
+/// at runtime, see Gwers::Site. If DTRACE is not defined then all X_BEGIN
+/// macros resolve to an empty line.
+///
+/// DEBUG and DTRACE decide the cost of assertion checks and tracing for an
+/// entire translation unit, including every header it includes. Each module
+/// can lower its own cost further with a policy. GWX_POLICY(N,T,C) declares a
+/// policy named N with a trace level of T and a check level of C, both
+/// constant expressions. A trace level of 2 or more adds function items with
+/// all argument values, a level of 1 adds only function names and never formats
+/// any argument, and a level of 0 or less adds nothing at all. A check level of
+/// 1 or more performs assertion checks and a level of 0 or less performs none.
+/// GWX_BEGIN_P(P,F,...), GWX_ASSERT_P(P,T,X,L), GWX_CHECK_P(P,T,X,L),
+/// GWX_PASS_P(P,V,C,F,X,L), GWX_TRY_P(P,S,X,L), GWX_ASSERT_C_P(P,T,X,L,...),
+/// and GWX_CHECK_C_P(P,T,X,L,...) work the same as the macros
+/// without the _P suffix, with the added first argument P being the policy of
+/// the module. A policy can only lower the cost; if DEBUG or DTRACE is not
+/// defined then the _P macros resolve to exactly what their plain counterparts
+/// do. When a policy disables checks, GWX_ASSERT_P does not execute T while
+/// GWX_CHECK_P, GWX_PASS_P, and GWX_TRY_P still execute T, F, and S. Because
+/// the levels are compile time constants, a disabled frame or check compiles to
+/// nothing, so a hot inner loop module and a control module with full tracing
+/// can be built into the same program.
+///
+/// Checks that are compiled in can still be skipped at runtime by lowering the
+/// check tier of Gwers::Config. A check is only made while its level, the check
+/// level of its policy for the _P macros or 1 for the others, is at most the
+/// tier, which costs a single load of the tier. GWX_ASSERT and its variants
+/// load it before evaluating T and skip T along with the check, while
+/// GWX_CHECK and GWX_PASS and their variants always execute T and F and only
+/// load the tier if the check fails.
+///
+/// Two more flags change what the X_BEGIN macros compile to. GWX_STATIC_KEYS
+/// puts a switch in front of every site that is a single NOP until tracing is
+/// turned on at runtime; see Gwers::Key. GWX_USDT places probe points for
+/// external tracers such as perf and bpftrace at every site, even if DTRACE
+/// is not defined; see Gwers::Probe.
 ///
 /// If an exception is caught, DTRACE is enabled, and you wish to examine the
 /// function stack, then use the Trace::begin() and Trace::end() functions to
@@ -105,6 +220,17 @@ namespace Gwers {
 /// Exception::base_catch(), which is used for setting up the root of where all
 /// exceptions are caught along with telling the Trace class where the root of
 /// the stack trace begins.
+///
+/// Code compiled with -fno-exceptions can still use all of the above macros.
+/// In that case a failed GWX_ASSERT, GWX_CHECK, or GWX_PASS does not throw,
+/// instead constructing the exception object and passing it to
+/// Exception::fatal(), which calls the fatal handler installed with
+/// Exception::set_fatal() and then aborts the program. The default fatal
+/// handler, Exception::dump(), writes the who, what, line, and context of the
+/// exception along with the function stack to standard error. GWX_TRY resolves
+/// to the statement S alone and base_catch() calls its base function without
+/// catching anything. Only the exception and trace code of the library can be
+/// built without exceptions, which is done by the libgwers.n.a variant.
 
 
 
@@ -113,11 +239,14 @@ namespace Gwers {
 ///
 /// This holds information about a single exception that has been thrown. It
 /// holds information about who, what, and the line number. When an object of
-/// this type is constructed it also locks the Trace stack if DTRACE is defined.
-/// This also contains static functions that handle catching or throwing these
-/// exception objects. The base_catch() function should be used where you desire
-/// the root of your function tracing to begin, very similar to the main
-/// function in regular code.
+/// this type is constructed it also locks the Trace stack if DTRACE is defined,
+/// adds one to the Metrics counter named by its who and what, fires the raise
+/// probe of Probe if the library was built with GWX_USDT defined, and keeps the
+/// Tag of the thread, charging itself to that tag
+/// with Profile if profiling is on. This also contains static functions that
+/// handle catching or throwing these exception objects. The base_catch()
+/// function should be used where you desire the root of your function tracing
+/// to begin, very similar to the main function in regular code.
 ///
 /// @warning Exceptions are not designed to pass from one thread to another, so
 /// there should be a base_catch call for each separate thread that exists.
@@ -166,6 +295,15 @@ public:
    /// the exception handler. It will be called by base_catch() if an exception
    /// is thrown and then caught in said function.
    using efp = void (*)(Type t, Exception* e, std::exception* std);
+   /// @brief Used for the fatal handler of fatal().
+   ///
+   /// @param e The exception that would have been thrown.
+   /// @param begin Beginning of the function stack of the calling thread.
+   /// @param end One past the end of the function stack of the calling thread.
+   ///
+   /// This is the function pointer given to set_fatal(). It will be called by
+   /// fatal() and should never return.
+   using ffp = void (*)(const Exception& e, Trace::iter begin, Trace::iter end);
    // *
    // * BASIC METHODS
    // *
@@ -182,6 +320,38 @@ public:
    /// @warning This constructor should never be called by the user, instead
    /// using the macros supplied for error checking.
    Exception(const string& who, const string& what, int line);
+   /// @brief Initializes exception object counted by a counter already looked
+   /// up.
+   ///
+   /// @param who Scope where this exception is thrown, either its namespace or
+   /// class.
+   /// @param what The specific type of exception that is thrown.
+   /// @param line The line of code where this exception is being thrown.
+   /// @param counter Counter of Metrics named by who and what.
+   ///
+   /// The constructor above looks the counter up by name, which builds its
+   /// name and takes the lock of Metrics on every throw. Each type defined by
+   /// GWX_EXCEPTION looks its counter up once with GWX_COUNTER and calls this
+   /// constructor instead, so a throw only adds to a shard of the counter.
+   ///
+   /// @warning This constructor should never be called by the user, instead
+   /// using the macros supplied for error checking.
+   Exception(const string& who, const string& what, int line,
+             Metrics::Counter& counter);
+   /// @brief Virtual destructor.
+   ///
+   /// This is virtual so exception handlers given a pointer to this class can
+   /// find the actual type of exception that was thrown, such as an Aggregate
+   /// thrown by parallel_for(). The bytes of this exception are given back to
+   /// Memory.
+   virtual ~Exception();
+   // *
+   // * COPY METHODS
+   // *
+   /// @brief Copies exception, counting its bytes with Memory.
+   Exception(const Exception& e);
+   /// @brief Copies exception, counting its bytes with Memory.
+   Exception& operator=(const Exception& e);
    // *
    // * FUNCTIONS
    // *
@@ -191,6 +361,10 @@ public:
    const string& what() const;
    /// @brief Get line number where exception was thrown.
    int line() const;
+   /// @brief Get key value pairs attached by GWX_ASSERT_C or GWX_CHECK_C.
+   const Context& context() const;
+   /// @brief Get Tag of the thread this exception was constructed on.
+   std::uint32_t tag() const;
    // *
    // * STATIC FUNCTIONS
    // *
@@ -203,11 +377,27 @@ public:
    /// @param line Line number where assertion is being declared.
    ///
    /// Tests condition given to it, throwing an exception of the type given if
-   /// and only if the condition is false.
+   /// and only if the condition is false. If compiled with -fno-exceptions, the
+   /// exception is given to fatal() instead of being thrown.
    ///
    /// @warning This function should never be called by the user, instead using
    /// the macros supplied for error checking.
    template<class X> static void assert(bool cond, int line);
+   /// @brief Throws exception with key value pairs attached.
+   ///
+   /// @tparam X %Exception type that will be thrown.
+   /// @tparam Fields Types of fields, which must all be Context::Field.
+   ///
+   /// @param line Line number where exception is being thrown.
+   /// @param fields Fields added to the context of the exception.
+   ///
+   /// If compiled with -fno-exceptions, the exception is given to fatal()
+   /// instead of being thrown.
+   ///
+   /// @warning This function should never be called by the user, instead using
+   /// the GWX_ASSERT_C and GWX_CHECK_C macros.
+   template<class X, class... Fields>
+   [[noreturn]] static void raise(int line, const Fields&... fields);
    /// @brief Base of function stack that will catch any exception.
    ///
    /// @param base Function that will be called immediately after calling this
@@ -220,15 +410,61 @@ public:
    /// and not call the base function again. This means that any thrown
    /// exception will cease normal execution of the program running from the
    /// base function. See Exception::efp for more information about what is
-   /// passed to the exception handling function.
+   /// passed to the exception handling function. Exceptions are caught by
+   /// reference, so the pointer given to the exception handling function points
+   /// to the actual exception object that was thrown.
+   ///
+   /// Function items already on the stack when this is called are kept, so the
+   /// exit hooks of functions instrumented with -finstrument-functions that
+   /// called this still find their own items to pop. If the stack is locked,
+   /// its items are left over from an exception caught elsewhere and are
+   /// flushed instead. Once the exception handling function returns, the stack
+   /// is rewound and unlocked back to the depth it had when this was called.
    static void base_catch(fp base, efp handler);
+   /// @brief Ends program for an exception that cannot be thrown.
+   ///
+   /// @param e The exception that would have been thrown.
+   ///
+   /// Calls the fatal handler installed with set_fatal() with the given
+   /// exception and the function stack of the calling thread. If the handler
+   /// returns, the program is aborted anyway. This is used in place of throwing
+   /// by code compiled with -fno-exceptions.
+   [[noreturn]] static void fatal(const Exception& e);
+   /// @brief Installs fatal handler.
+   ///
+   /// @param handler Function called by fatal(), or nullptr to install the
+   /// default handler dump().
+   static void set_fatal(ffp handler);
+   /// @brief Default fatal handler.
+   ///
+   /// Writes the who, what, and line of the given exception, then its context
+   /// if it has one, followed by the function stack, to standard error. Each
+   /// line is formatted into a buffer on the stack and written with a single
+   /// system call, so nothing is allocated and no stream is used; lines too
+   /// long for the buffer are cut off.
+   static void dump(const Exception& e, Trace::iter begin, Trace::iter end);
 private:
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   static void report(const Format& str);
+   // *
+   // * FUNCTIONS
+   // *
+   std::int64_t bytes() const;
+   void probe() const;
    // *
    // * VARIABLES
    // *
    string _who;
    string _what;
    int _line;
+   std::uint32_t _tag;
+   Context _context;
+   // *
+   // * STATIC VARIABLES
+   // *
+   static std::atomic<ffp> _fatal;
 };
 
 
@@ -246,11 +482,75 @@ private:
 
 
 inline Exception::Exception(const string& who, const string& what, int line):
+   Exception(who,what,line,Metrics::counter(who,what))
+{}
+
+
+
+inline Exception::Exception(const string& who, const string& what, int line,
+                            Metrics::Counter& counter):
    _who {who},
    _what {what},
-   _line {line}
+   _line {line},
+   _tag {Tag::current()}
 {
+   probe();
    Trace::lock();
+   Recorder::raise(_what);
+   counter.add();
+   Memory::add(Memory::Kind::exception,bytes());
+   if (Profile::profiling())
+   {
+      Profile::raise(_tag,Trace::site(),bytes());
+   }
+}
+
+
+
+inline Exception::Exception(const Exception& e):
+   _who {e._who},
+   _what {e._what},
+   _line {e._line},
+   _tag {e._tag},
+   _context {e._context}
+{
+   Memory::add(Memory::Kind::exception,bytes());
+}
+
+
+
+inline Exception& Exception::operator=(const Exception& e)
+{
+   Memory::add(Memory::Kind::exception,-bytes());
+   _who = e._who;
+   _what = e._what;
+   _line = e._line;
+   _tag = e._tag;
+   _context = e._context;
+   Memory::add(Memory::Kind::exception,bytes());
+   return *this;
+}
+
+
+
+inline Exception::~Exception()
+{
+   Memory::add(Memory::Kind::exception,-bytes());
+}
+
+
+
+inline std::int64_t Exception::bytes() const
+{
+   std::size_t n {sizeof(Exception)};
+   for (const string* i:{&_who,&_what})
+   {
+      if (i->capacity()>string().capacity())
+      {
+         n += i->capacity()+1;
+      }
+   }
+   return n;
 }
 
 
@@ -276,15 +576,48 @@ inline int Exception::line() const
 
 
 
+inline const Context& Exception::context() const
+{
+   return _context;
+}
+
+
+
+inline std::uint32_t Exception::tag() const
+{
+   return _tag;
+}
+
+
+
 template<class X> void Exception::assert(bool cond, int line)
 {
    if (!cond)
    {
+#ifdef GWX__EXCEPTIONS
       throw X(line);
+#else
+      fatal(X(line));
+#endif
    }
 }
 
 
 
+template<class X, class... Fields>
+void Exception::raise(int line, const Fields&... fields)
+{
+   X e(line);
+   Context& context {static_cast<Exception&>(e)._context};
+   (context.add(fields),...);
+#ifdef GWX__EXCEPTIONS
+   throw e;
+#else
+   fatal(e);
+#endif
+}
+
+
+
 }
 #endif
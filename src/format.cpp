@@ -0,0 +1,90 @@
+#include "format.h"
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+namespace Gwers {
+
+
+
+void Format::write(std::string_view text)
+{
+   std::size_t n {text.size()};
+   if (n>_capacity-_size)
+   {
+      n = _capacity-_size;
+      _truncated = true;
+   }
+   std::memcpy(_buffer+_size,text.data(),n);
+   _size += n;
+   _buffer[_size] = '\0';
+}
+
+
+
+void Format::put(int fd) const
+{
+   std::size_t done {0};
+   while (done<_size)
+   {
+      ssize_t n {::write(fd,_buffer+done,_size-done)};
+      if (n<0&&errno==EINTR)
+      {
+         continue;
+      }
+      if (n<=0)
+      {
+         break;
+      }
+      done += n;
+   }
+}
+
+
+
+void Format::integer(long long value)
+{
+   char buffer[24];
+   auto r = std::to_chars(buffer,buffer+sizeof(buffer),value);
+   write(std::string_view(buffer,r.ptr-buffer));
+}
+
+
+
+void Format::integer(unsigned long long value)
+{
+   char buffer[24];
+   auto r = std::to_chars(buffer,buffer+sizeof(buffer),value);
+   write(std::string_view(buffer,r.ptr-buffer));
+}
+
+
+
+void Format::real(double value)
+{
+   char buffer[32];
+   auto r = std::to_chars(buffer,buffer+sizeof(buffer),value);
+   write(std::string_view(buffer,r.ptr-buffer));
+}
+
+
+
+void Format::real(long double value)
+{
+   char buffer[64];
+   auto r = std::to_chars(buffer,buffer+sizeof(buffer),value);
+   write(std::string_view(buffer,r.ptr-buffer));
+}
+
+
+
+void Format::pointer(const void* value)
+{
+   char buffer[2+2*sizeof(void*)] {'0','x'};
+   auto r = std::to_chars(buffer+2,buffer+sizeof(buffer),
+                          reinterpret_cast<std::uintptr_t>(value),16);
+   write(std::string_view(buffer,r.ptr-buffer));
+}
+
+
+
+}
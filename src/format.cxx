@@ -0,0 +1,211 @@
+#include <cstring>
+#include <ostream>
+#include <unistd.h>
+#include "unit.hh"
+#include "format.h"
+namespace unit {
+/// @ingroup utest
+/// @brief Tests formatting of values into fixed buffers.
+///
+/// Tests the formatting of values as text into fixed size buffers, consisting
+/// of the Format class.
+namespace format {
+
+
+
+/// @brief Used for throwing a unit test failure.
+using fail = UnitTest::Run::Fail;
+/// @brief Used for all strings.
+using string = std::string;
+/// @brief Used as shorthand.
+using gwf = Gwers::Format;
+
+
+
+/// @brief Internal enumeration used to test formatting of enumerations.
+enum class Color { red = 2 };
+
+
+
+/// @brief Internal type formatted with its own gwx_format function.
+struct Custom { int a; int b; };
+
+
+
+/// @brief Internal type formatted through an output stream.
+struct Streamed { int a; };
+
+
+
+/// @brief Internal function formatting a Custom value.
+void gwx_format(gwf& str, const Custom& value)
+{
+   str << "(" << value.a << "," << value.b << ")";
+}
+
+
+
+/// @brief Internal function writing a Streamed value to an output stream.
+std::ostream& operator<<(std::ostream& str, const Streamed& value)
+{
+   return str << "<" << value.a << ">";
+}
+
+
+
+/// @brief Unit tests formatting of built in types.
+///
+/// This function unit tests the << operator of the Gwers::Format class with
+/// built in types. It performs these tests with three unit tests.
+///
+/// -# Writes integers of several types, bools, characters, and an enumeration,
+/// making sure each is written as an output stream would write it.
+///
+/// -# Writes floating point numbers, making sure each is written as the
+/// shortest text that reads back as the same value.
+///
+/// -# Writes strings of several types and pointers, making sure strings are
+/// written as they are, a null character pointer as (null), and other
+/// pointers in hexadecimal.
+void basic(UnitTest::Run& ut)
+{
+   gwf::Fixed<128> str;
+   str << -42 << " " << 18446744073709551615ull << " " << short(7) << " "
+       << true << false << " " << 'x' << " " << Color::red;
+   if (str.view()!="-42 18446744073709551615 7 10 x 2"||str.truncated())
+   {
+      throw fail();
+   }
+   ut.next();
+   str.clear();
+   str << 1.5 << " " << 0.1 << " " << -2.0f << " " << 1e100;
+   if (str.view()!="1.5 0.1 -2 1e+100")
+   {
+      throw fail();
+   }
+   ut.next();
+   str.clear();
+   const char* null {nullptr};
+   str << "a" << string("b") << std::string_view("c") << null << " "
+       << reinterpret_cast<const void*>(0x1234) << " "
+       << static_cast<int*>(nullptr);
+   if (str.view()!="abc(null) 0x1234 0x0"||
+       std::strcmp(str.c_str(),"abc(null) 0x1234 0x0")!=0)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Unit tests buffers and truncation.
+///
+/// This function unit tests writing past the end of a buffer and writing into
+/// a buffer given by the caller. It performs these tests with two unit tests.
+///
+/// -# Writes more text than fits into a small buffer, making sure the text is
+/// cut off, still null terminated, and the formatter reports it was truncated,
+/// then clears it and makes sure it is empty and no longer truncated.
+///
+/// -# Formats into a buffer given by the caller, making sure the text is
+/// written into that buffer.
+void buffer(UnitTest::Run& ut)
+{
+   gwf::Fixed<8> str;
+   str << "abcdef" << 12345;
+   if (str.view()!="abcdef1"||std::strlen(str.c_str())!=7||!str.truncated())
+   {
+      throw fail();
+   }
+   str.clear();
+   if (str.size()!=0||str.truncated()||str.c_str()[0]!='\0')
+   {
+      throw fail();
+   }
+   ut.next();
+   char buffer[16];
+   gwf out(buffer,sizeof(buffer));
+   out << "n=" << 42;
+   if (std::strcmp(buffer,"n=42")!=0||out.str()!="n=42")
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Unit tests formatting of user types.
+///
+/// This function unit tests the two ways user types are formatted. It performs
+/// these tests with two unit tests.
+///
+/// -# Writes a type with a gwx_format function, making sure that function is
+/// used.
+///
+/// -# Writes a type that can only be written to an output stream, making sure
+/// it is written through one.
+void custom(UnitTest::Run& ut)
+{
+   gwf::Fixed<32> str;
+   str << Custom {1,2};
+   if (str.view()!="(1,2)")
+   {
+      throw fail();
+   }
+   ut.next();
+   str.clear();
+   str << Streamed {3};
+   if (str.view()!="<3>")
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Unit tests writing text to a file descriptor.
+///
+/// This function unit tests the put() method of the Gwers::Format class. It
+/// performs these tests with two unit tests.
+///
+/// -# Puts text into a pipe, making sure all of it can be read back.
+///
+/// -# Puts text to a file descriptor that is not open, making sure it returns.
+void put(UnitTest::Run& ut)
+{
+   int fds[2];
+   if (::pipe(fds)!=0)
+   {
+      throw fail();
+   }
+   gwf::Fixed<32> str;
+   str << "put " << 42 << "\n";
+   str.put(fds[1]);
+   ::close(fds[1]);
+   char buffer[32];
+   ssize_t n {::read(fds[0],buffer,sizeof(buffer))};
+   ::close(fds[0]);
+   if (n!=7||string(buffer,n)!="put 42\n")
+   {
+      throw fail();
+   }
+   ut.next();
+   str.put(-1);
+}
+
+
+
+/// @brief Initialize all unit tests for Format class.
+void init(UnitTest& ut)
+{
+   UnitTest::Run& t = ut.add("Format",nullptr,nullptr);
+   t.add("basic",basic);
+   t.add("buffer",buffer);
+   t.add("custom",custom);
+   t.add("put",put);
+}
+
+
+
+}
+}
@@ -0,0 +1,291 @@
+#ifndef GWERS_FORMAT_H
+#define GWERS_FORMAT_H
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+namespace Gwers {
+
+
+
+/// @ingroup exception
+/// @brief Formats values as text into a fixed size buffer.
+///
+/// This writes values given to it with the << operator as text into a buffer
+/// of fixed size, in the same way as an output string stream would, but
+/// without any locale, virtual calls, or allocation. Integers and floating
+/// point numbers are written with std::to_chars, floating point numbers as the
+/// shortest text that reads back as the same value. Pointers are written in
+/// hexadecimal, characters and bools as an output stream would write them, and
+/// strings as they are. Anything that does not fit in the buffer is cut off
+/// and the formatter remembers it was truncated; the text in the buffer is
+/// always null terminated.
+///
+/// Formatting of user types is done by a function gwx_format(Format&, const
+/// T&) found by argument dependent lookup in the namespace of the type, which
+/// writes the value with the << operator. Types that have no such function
+/// but can be written to an output stream are formatted through a temporary
+/// output string stream, which does allocate.
+///
+/// Formatting into a buffer given by the caller is async-signal-safe for every
+/// type other than those written through an output string stream. The Fixed
+/// class template holds a buffer of its own, and is what the Trace class uses
+/// to build function items.
+class Format
+{
+public:
+   // *
+   // * DECLERATIONS
+   // *
+   template<std::size_t N> class Fixed;
+   // *
+   // * BASIC METHODS
+   // *
+   /// @brief Initializes formatter writing into a buffer.
+   ///
+   /// @param buffer Buffer that text is written into.
+   /// @param size Size of the buffer, including room for the null character
+   /// that always ends the text. Must be at least 1.
+   Format(char* buffer, std::size_t size);
+   // *
+   // * COPY METHODS
+   // *
+   Format(const Format&) = delete;
+   Format& operator=(const Format&) = delete;
+   // *
+   // * FUNCTIONS
+   // *
+   /// @brief Get text written so far as a null terminated string.
+   const char* c_str() const;
+   /// @brief Get text written so far.
+   std::string_view view() const;
+   /// @brief Get copy of text written so far.
+   std::string str() const;
+   /// @brief Get length of text written so far.
+   std::size_t size() const;
+   /// @brief Get whether any text was cut off because the buffer was full.
+   bool truncated() const;
+   /// @brief Removes all text written so far.
+   void clear();
+   /// @brief Writes characters.
+   ///
+   /// @param text Characters to write, which are cut off if they do not fit.
+   void write(std::string_view text);
+   /// @brief Writes text written so far to a file descriptor.
+   ///
+   /// @param fd File descriptor the text is written to.
+   ///
+   /// This retries writes that were interrupted by a signal, and stops early if
+   /// the file descriptor fails or takes no more text. It is async-signal-safe.
+   void put(int fd) const;
+   // *
+   // * OPERATORS
+   // *
+   /// @brief Writes value as text.
+   ///
+   /// @tparam T Type of value.
+   ///
+   /// @param value Value to write.
+   ///
+   /// @return Reference to this formatter.
+   template<class T> Format& operator<<(const T& value);
+private:
+   // *
+   // * DECLERATIONS
+   // *
+   template<class T, class = void> struct Custom : std::false_type {};
+   template<class T, class = void> struct Streamed : std::false_type {};
+   // *
+   // * FUNCTIONS
+   // *
+   void integer(long long value);
+   void integer(unsigned long long value);
+   void real(double value);
+   void real(long double value);
+   void pointer(const void* value);
+   // *
+   // * VARIABLES
+   // *
+   char* _buffer;
+   std::size_t _capacity;
+   std::size_t _size {0};
+   bool _truncated {false};
+};
+
+
+
+/// @brief Formatter holding a buffer of its own.
+///
+/// @tparam N Size of the buffer, including the null character that always ends
+/// the text.
+template<std::size_t N> class Format::Fixed : public Format
+{
+public:
+   // *
+   // * BASIC METHODS
+   // *
+   /// @brief Initializes formatter with empty buffer.
+   Fixed();
+private:
+   // *
+   // * VARIABLES
+   // *
+   char _data[N];
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | INLINE/TEMPLATE                                                          |
+// *==========================================================================*
+//
+//
+//
+
+
+
+template<class T> struct Format::Custom<T,std::void_t<decltype(
+   gwx_format(std::declval<Format&>(),std::declval<const T&>()))>>:
+   std::true_type
+{};
+
+
+
+template<class T> struct Format::Streamed<T,std::void_t<decltype(
+   std::declval<std::ostream&>() << std::declval<const T&>())>>:
+   std::true_type
+{};
+
+
+
+inline Format::Format(char* buffer, std::size_t size):
+   _buffer {buffer},
+   _capacity {size-1}
+{
+   _buffer[0] = '\0';
+}
+
+
+
+inline const char* Format::c_str() const
+{
+   return _buffer;
+}
+
+
+
+inline std::string_view Format::view() const
+{
+   return std::string_view(_buffer,_size);
+}
+
+
+
+inline std::string Format::str() const
+{
+   return std::string(_buffer,_size);
+}
+
+
+
+inline std::size_t Format::size() const
+{
+   return _size;
+}
+
+
+
+inline bool Format::truncated() const
+{
+   return _truncated;
+}
+
+
+
+inline void Format::clear()
+{
+   _size = 0;
+   _truncated = false;
+   _buffer[0] = '\0';
+}
+
+
+
+template<class T> Format& Format::operator<<(const T& value)
+{
+   if constexpr (std::is_same_v<T,bool>)
+   {
+      write(value?"1":"0");
+   }
+   else if constexpr (std::is_same_v<T,char>||std::is_same_v<T,signed char>||
+                      std::is_same_v<T,unsigned char>)
+   {
+      char c = static_cast<char>(value);
+      write(std::string_view(&c,1));
+   }
+   else if constexpr (std::is_enum_v<T>)
+   {
+      *this << static_cast<std::underlying_type_t<T>>(value);
+   }
+   else if constexpr (std::is_integral_v<T>&&std::is_signed_v<T>)
+   {
+      integer(static_cast<long long>(value));
+   }
+   else if constexpr (std::is_integral_v<T>)
+   {
+      integer(static_cast<unsigned long long>(value));
+   }
+   else if constexpr (std::is_same_v<T,long double>)
+   {
+      real(value);
+   }
+   else if constexpr (std::is_floating_point_v<T>)
+   {
+      real(static_cast<double>(value));
+   }
+   else if constexpr (std::is_convertible_v<const T&,const char*>)
+   {
+      const char* s = value;
+      write(s?std::string_view(s):std::string_view("(null)"));
+   }
+   else if constexpr (std::is_convertible_v<const T&,std::string_view>)
+   {
+      write(std::string_view(value));
+   }
+   else if constexpr (std::is_pointer_v<T>||std::is_null_pointer_v<T>)
+   {
+      pointer(reinterpret_cast<const void*>(value));
+   }
+   else if constexpr (Custom<T>::value)
+   {
+      gwx_format(*this,value);
+   }
+   else
+   {
+      static_assert(Streamed<T>::value,"Type cannot be formatted.");
+      std::ostringstream str;
+      str << value;
+      write(str.str());
+   }
+   return *this;
+}
+
+
+
+template<std::size_t N> Format::Fixed<N>::Fixed():
+   Format(_data,N)
+{
+   static_assert(N>0,"Buffer must hold at least the null character.");
+}
+
+
+
+}
+#endif
@@ -0,0 +1,219 @@
+#include "governor.h"
+#include <algorithm>
+#include <ctime>
+#include <string>
+#include <vector>
+#include "trace.h"
+namespace Gwers {
+
+
+
+Governor::Governor(double budget, std::chrono::milliseconds interval):
+   _budget {budget},
+   _interval {interval},
+   _thread {&Governor::run,this}
+{}
+
+
+
+Governor::~Governor()
+{
+   {
+      std::lock_guard<std::mutex> lock {_mutex};
+      _stop = true;
+   }
+   _wake.notify_all();
+   _thread.join();
+}
+
+
+
+void Governor::calibrate()
+{
+   using clock = std::chrono::steady_clock;
+   const int count {4096};
+   std::vector<std::string> frames;
+   frames.reserve(1);
+   auto start = clock::now();
+   for (int i = 0;i<count;++i)
+   {
+      Trace::Text str;
+      str << "Gwers::Governor::calibrate()";
+      Trace::build(str,i,count);
+      frames.emplace_back(str.view());
+      frames.pop_back();
+   }
+   auto middle = clock::now();
+   for (int i = 0;i<count;++i)
+   {
+      Trace::Text str;
+      str << "Gwers::Governor::calibrate()";
+      frames.emplace_back(str.view());
+      frames.pop_back();
+   }
+   auto end = clock::now();
+   std::atomic<unsigned> generation {0};
+   Site::Local local;
+   volatile int sink {0};
+   for (int i = 0;i<count;++i)
+   {
+      if (Coverage::covering())
+      {
+         sink = sink+1;
+      }
+      if (local.count>1&&
+          local.generation==generation.load(std::memory_order_relaxed))
+      {
+         --local.count;
+      }
+      else
+      {
+         local.count = Site::off_rate;
+         local.generation = generation.load(std::memory_order_relaxed);
+         sink = sink+1;
+      }
+   }
+   auto last = clock::now();
+   _full = std::chrono::duration<double,std::nano>(middle-start).count()/count;
+   _name = std::chrono::duration<double,std::nano>(end-middle).count()/count;
+   _skip = std::chrono::duration<double,std::nano>(last-end).count()/count;
+}
+
+
+
+void Governor::run()
+{
+   calibrate();
+   double last {now()};
+   std::unique_lock<std::mutex> lock {_mutex};
+   while (!_wake.wait_for(lock,_interval,[this] { return _stop; }))
+   {
+      double cpu {now()};
+      update(cpu-last);
+      last = cpu;
+   }
+   for (auto& i:_records)
+   {
+      if (i.second.site->level()<i.second.base)
+      {
+         i.second.site->set_level(i.second.base);
+      }
+   }
+   _lowered.store(0,std::memory_order_relaxed);
+}
+
+
+
+void Governor::update(double cpu)
+{
+   using Level = Site::Level;
+   for (auto i:Site::all())
+   {
+      auto r = _records.find(i);
+      if (r==_records.end())
+      {
+         _records.emplace(i,Record {i,i->level(),i->calls(),0});
+      }
+      else
+      {
+         std::uint64_t calls {i->calls()};
+         r->second.delta = double(calls-r->second.calls);
+         r->second.calls = calls;
+      }
+   }
+   std::vector<Record*> order;
+   double total {0};
+   for (auto& i:_records)
+   {
+      total += cost(i.second,i.second.site->level());
+      order.push_back(&i.second);
+   }
+   double budget {_budget*cpu};
+   if (total>budget)
+   {
+      std::sort(order.begin(),order.end(),[this](Record* a, Record* b) {
+         return cost(*a,a->site->level())>cost(*b,b->site->level());
+      });
+      for (auto i:order)
+      {
+         Level level {i->site->level()};
+         while (total>budget&&level>Level::off)
+         {
+            Level lower {static_cast<Level>(static_cast<int>(level)-1)};
+            total += cost(*i,lower)-cost(*i,level);
+            i->site->set_level(lower);
+            level = lower;
+         }
+         if (total<=budget)
+         {
+            break;
+         }
+      }
+   }
+   else if (total<budget/2)
+   {
+      auto raise = [this](Record* r) {
+         Level level {r->site->level()};
+         return cost(*r,static_cast<Level>(static_cast<int>(level)+1))-
+                cost(*r,level);
+      };
+      order.erase(std::remove_if(order.begin(),order.end(),[](Record* r) {
+         return r->site->level()>=r->base;
+      }),order.end());
+      std::sort(order.begin(),order.end(),[&raise](Record* a, Record* b) {
+         return raise(a)<raise(b);
+      });
+      for (auto i:order)
+      {
+         double more {raise(i)};
+         if (total+more<budget/2)
+         {
+            Level level {i->site->level()};
+            i->site->set_level(static_cast<Level>(static_cast<int>(level)+1));
+            total += more;
+         }
+      }
+   }
+   std::size_t lowered {0};
+   for (auto& i:_records)
+   {
+      if (i.second.site->level()<i.second.base)
+      {
+         ++lowered;
+      }
+   }
+   _lowered.store(lowered,std::memory_order_relaxed);
+   _overhead.store(cpu>0?total/cpu:0,std::memory_order_relaxed);
+}
+
+
+
+double Governor::cost(const Record& r, Site::Level level) const
+{
+   double skip {r.delta*_skip};
+   unsigned rate {r.site->rate()};
+   switch (level)
+   {
+   case Site::Level::off:
+      return skip;
+   case Site::Level::sampled:
+      return skip+r.delta/std::max(rate,Site::sampled_rate)*_name;
+   case Site::Level::name:
+      return skip+r.delta/rate*_name;
+   default:
+      return skip+r.delta/rate*_full;
+   }
+}
+
+
+
+double Governor::now()
+{
+   timespec t;
+   clock_gettime(CLOCK_PROCESS_CPUTIME_ID,&t);
+   return double(t.tv_sec)*1.0e9+double(t.tv_nsec);
+}
+
+
+
+}
@@ -0,0 +1,194 @@
+#include <cstring>
+#include "unit.hh"
+#include "governor.h"
+#include "profile.h"
+#include "trace.h"
+namespace unit {
+/// @ingroup utest
+/// @brief Tests the adaptive tracing overhead governor.
+///
+/// Tests the throttling of hot sites, consisting of the Governor class.
+namespace governor {
+
+
+
+/// @brief Used for throwing a unit test failure.
+using fail = UnitTest::Run::Fail;
+/// @brief Used as shorthand.
+using gws = Gwers::Site;
+/// @brief Used for all time durations.
+using ms = std::chrono::milliseconds;
+
+
+
+/// @brief Internal function traced with an argument that is called often.
+int hot(int a)
+{
+   GWX_BEGIN("unit::governor::hot(int)",a);
+   return a+1;
+}
+
+
+
+/// @brief Internal function that finds the site of hot().
+gws* find()
+{
+   for (auto i:gws::all())
+   {
+      if (std::strcmp(i->function(),"unit::governor::hot(int)")==0)
+      {
+         return i;
+      }
+   }
+   return nullptr;
+}
+
+
+
+/// @brief Internal function that calls hot() until its site is lowered.
+///
+/// @param g Governor watching the site.
+/// @param site Site of hot().
+///
+/// @return True if the site was lowered within a few seconds.
+bool drive(const Gwers::Governor& g, gws* site)
+{
+   using clock = std::chrono::steady_clock;
+   auto end = clock::now()+std::chrono::seconds(5);
+   volatile int a {0};
+   while ((site->level()==gws::Level::full||g.lowered()==0)&&
+          clock::now()<end)
+   {
+      for (int i = 0;i<1000;++i)
+      {
+         a = hot(a);
+      }
+   }
+   return site->level()!=gws::Level::full;
+}
+
+
+
+/// @brief Internal function that waits until a site is back at full.
+///
+/// @param g Governor watching the site.
+/// @param site Site of hot().
+///
+/// @return True if the site was raised back to full within a few seconds.
+bool rest(const Gwers::Governor& g, gws* site)
+{
+   for (int i = 0;i<500&&(site->level()!=gws::Level::full||g.lowered()!=0);
+        ++i)
+   {
+      std::this_thread::sleep_for(ms(10));
+   }
+   return site->level()==gws::Level::full&&g.lowered()==0;
+}
+
+
+
+/// @brief Unit tests lowering and raising sites.
+///
+/// This function unit tests the Gwers::Governor class. It performs these tests
+/// with three unit tests.
+///
+/// -# Calls a traced function in a tight loop with a governor allowing 1% of
+/// the processor time for tracing, making sure its site is lowered and the
+/// governor reports it.
+///
+/// -# Stops calling the function, making sure its site is raised back to full
+/// once the load is gone.
+///
+/// -# Lowers the site again, then destroys the governor, making sure the site
+/// is restored to full.
+void basic(UnitTest::Run& ut)
+{
+   gws* site {find()};
+   if (!site)
+   {
+      throw fail();
+   }
+   {
+      Gwers::Governor g(0.01,ms(20));
+      if (!drive(g,site))
+      {
+         throw fail();
+      }
+      ut.next();
+      if (!rest(g,site))
+      {
+         throw fail();
+      }
+      ut.next();
+      if (!drive(g,site))
+      {
+         throw fail();
+      }
+   }
+   if (site->level()!=gws::Level::full)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Internal function that finds whether a site is enrolled.
+bool enrolled(const gws* site)
+{
+   for (auto i:gws::all())
+   {
+      if (i==site)
+      {
+         return true;
+      }
+   }
+   return false;
+}
+
+
+
+/// @brief Unit tests measuring tracing costs.
+///
+/// This function unit tests the measuring done by a Gwers::Governor when it
+/// starts. It performs this test with one unit test.
+///
+/// -# Constructs and destroys a governor while profiling, making sure every
+/// site profiled or covered meanwhile is one enrolled by a GWX_BEGIN macro.
+void quiet(UnitTest::Run&)
+{
+   Gwers::Profile::start();
+   {
+      Gwers::Governor g(0.01,ms(20));
+   }
+   Gwers::Profile::stop();
+   for (auto& i:Gwers::Profile::read())
+   {
+      if (i.site&&!enrolled(i.site))
+      {
+         throw fail();
+      }
+   }
+   for (auto i:Gwers::Coverage::covered())
+   {
+      if (!enrolled(i))
+      {
+         throw fail();
+      }
+   }
+}
+
+
+
+/// @brief Initialize all unit tests for Governor class.
+void init(UnitTest& ut)
+{
+   UnitTest::Run& t = ut.add("Governor",nullptr,nullptr);
+   t.add("basic",basic);
+   t.add("quiet",quiet);
+}
+
+
+
+}
+}
@@ -0,0 +1,138 @@
+#ifndef GWERS_GOVERNOR_H
+#define GWERS_GOVERNOR_H
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "site.h"
+namespace Gwers {
+
+
+
+/// @ingroup exception
+/// @brief Keeps the cost of tracing under a budget by lowering hot sites.
+///
+/// This runs a thread in the background that wakes up once every interval,
+/// reads how many calls passed through every site since it last woke up, and
+/// estimates how much processor time the tracing of those calls cost. The
+/// estimate uses the cost of adding a function item with arguments, adding one
+/// with only a name, and skipping a call, each measured once when the governor
+/// is constructed. These are measured by loops doing the same work on private
+/// buffers and countdowns instead of through Trace, so measuring them adds
+/// nothing to any site, Profile, Recorder, Request, Coverage, or Memory. The
+/// budget is a fraction of the processor time used by the whole process over
+/// the same interval, so a budget of 0.01 keeps tracing at about 1% of the
+/// time the program spends running.
+///
+/// While the estimate is over budget, the sites costing the most are lowered
+/// one level of detail at a time, from full to name, sampled, and then off,
+/// until the estimate is under budget again. While the estimate is under half
+/// of the budget, lowered sites are raised again one level at a time, cheapest
+/// first, as long as that keeps the estimate under half of the budget. A site
+/// is never raised above the level it had when the governor first saw it. The
+/// gap between the two thresholds keeps a site from being lowered and raised
+/// over and over under a steady load. When the governor is destroyed, its
+/// thread is stopped and every site it lowered is restored.
+///
+/// @warning Only one governor should exist at a time, otherwise each will
+/// restore the levels the other has lowered.
+class Governor
+{
+public:
+   // *
+   // * BASIC METHODS
+   // *
+   /// @brief Measures tracing costs and starts background thread.
+   ///
+   /// @param budget Fraction of the processor time of the process that tracing
+   /// is allowed to cost.
+   /// @param interval Time between each look at all sites.
+   Governor(double budget,
+            std::chrono::milliseconds interval = std::chrono::milliseconds(100));
+   /// @brief Stops background thread and restores lowered sites.
+   ~Governor();
+   // *
+   // * COPY METHODS
+   // *
+   Governor(const Governor&) = delete;
+   Governor& operator=(const Governor&) = delete;
+   // *
+   // * FUNCTIONS
+   // *
+   /// @brief Get estimated cost of tracing over the last interval as a
+   /// fraction of the processor time of the process.
+   double overhead() const;
+   /// @brief Get number of sites currently lowered below their own level.
+   std::size_t lowered() const;
+private:
+   // *
+   // * DECLERATIONS
+   // *
+   struct Record
+   {
+      Site* site;
+      Site::Level base;
+      std::uint64_t calls;
+      double delta;
+   };
+   // *
+   // * FUNCTIONS
+   // *
+   void calibrate();
+   void run();
+   void update(double cpu);
+   double cost(const Record& r, Site::Level level) const;
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   static double now();
+   // *
+   // * VARIABLES
+   // *
+   double _budget;
+   std::chrono::milliseconds _interval;
+   double _full {0};
+   double _name {0};
+   double _skip {0};
+   std::unordered_map<Site*,Record> _records;
+   std::atomic<double> _overhead {0};
+   std::atomic<std::size_t> _lowered {0};
+   std::mutex _mutex;
+   std::condition_variable _wake;
+   bool _stop {false};
+   std::thread _thread;
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | INLINE/TEMPLATE                                                          |
+// *==========================================================================*
+//
+//
+//
+
+
+
+inline double Governor::overhead() const
+{
+   return _overhead.load(std::memory_order_relaxed);
+}
+
+
+
+inline std::size_t Governor::lowered() const
+{
+   return _lowered.load(std::memory_order_relaxed);
+}
+
+
+
+}
+#endif
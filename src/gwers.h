@@ -1,10 +1,28 @@
 #include "exception.h"
+#include "capture.h"
+#include "threadpool.h"
+#include "parallel.h"
+#include "governor.h"
+#include "request.h"
+#include "reporter.h"
+#include "coverage.h"
+#include "recorder.h"
+#include "config.h"
+#include "metrics.h"
+#include "memory.h"
+#include "key.h"
+#include "probe.h"
+#include "tag.h"
+#include "profile.h"
 
 /// @mainpage
 /// Hello :)
 /// Start by looking at modules section.
 /// This is a work in progress :)
+/// - @ref parallel
 /// - @ref utest
+/// - @ref btest
+/// - @ref stest
 
 /// @brief Main namespace for the entire %Gwers library.
 ///
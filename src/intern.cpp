@@ -0,0 +1,111 @@
+#include "intern.h"
+#include <functional>
+namespace Gwers {
+
+
+
+std::atomic<Intern::Entry*> Intern::_table[Intern::_buckets];
+std::atomic<std::atomic<const Intern::Entry*>*> Intern::_ids[Intern::_chunks];
+std::atomic<Intern::key> Intern::_next;
+std::atomic<std::size_t> Intern::_size;
+thread_local const Intern::Entry* Intern::_front[Intern::_cache];
+
+
+
+Intern::Entry::Entry(std::string_view t, std::size_t h, key i):
+   text {t},
+   hash {h},
+   id {i}
+{}
+
+
+
+const Intern::string* Intern::text(key id)
+{
+   std::atomic<const Entry*>* chunk {nullptr};
+   if (id/_chunk<_chunks)
+   {
+      chunk = _ids[id/_chunk].load(std::memory_order_acquire);
+   }
+   const Entry* entry {nullptr};
+   if (chunk)
+   {
+      entry = chunk[id%_chunk].load(std::memory_order_acquire);
+   }
+   return entry?&entry->text:nullptr;
+}
+
+
+
+const Intern::Entry* Intern::find(std::string_view text)
+{
+   std::size_t hash {std::hash<std::string_view>()(text)};
+   const Entry*& front {_front[hash%_cache]};
+   if (front&&front->hash==hash&&front->text==text)
+   {
+      return front;
+   }
+   std::atomic<Entry*>& bucket {_table[(hash/_cache)%_buckets]};
+   Entry* head {bucket.load(std::memory_order_acquire)};
+   for (const Entry* i = head;i;i = i->next)
+   {
+      if (i->hash==hash&&i->text==text)
+      {
+         record(i);
+         return front = i;
+      }
+   }
+   Entry* entry {new Entry(text,hash,
+                           _next.fetch_add(1,std::memory_order_relaxed))};
+   entry->next = head;
+   while (!bucket.compare_exchange_weak(head,entry,std::memory_order_release,
+                                        std::memory_order_acquire))
+   {
+      for (const Entry* i = head;i!=entry->next;i = i->next)
+      {
+         if (i->hash==hash&&i->text==text)
+         {
+            delete entry;
+            record(i);
+            return front = i;
+         }
+      }
+      entry->next = head;
+   }
+   record(entry);
+   _size.fetch_add(1,std::memory_order_relaxed);
+   return front = entry;
+}
+
+
+
+void Intern::record(const Entry* entry)
+{
+   if (entry->id/_chunk>=_chunks)
+   {
+      return;
+   }
+   std::atomic<std::atomic<const Entry*>*>& slot {_ids[entry->id/_chunk]};
+   std::atomic<const Entry*>* chunk {slot.load(std::memory_order_acquire)};
+   if (!chunk)
+   {
+      std::atomic<const Entry*>* fresh {new std::atomic<const Entry*>[_chunk]()};
+      if (slot.compare_exchange_strong(chunk,fresh,std::memory_order_acq_rel))
+      {
+         chunk = fresh;
+      }
+      else
+      {
+         delete[] fresh;
+      }
+   }
+   std::atomic<const Entry*>& id {chunk[entry->id%_chunk]};
+   if (id.load(std::memory_order_relaxed)!=entry)
+   {
+      id.store(entry,std::memory_order_release);
+   }
+}
+
+
+
+}
@@ -0,0 +1,108 @@
+#include <thread>
+#include <vector>
+#include "unit.hh"
+#include "intern.h"
+namespace unit {
+/// @ingroup utest
+/// @brief Tests string interning.
+///
+/// Tests the process wide pool of interned strings, consisting of the Intern
+/// class.
+namespace intern {
+
+
+
+/// @brief Used for throwing a unit test failure.
+using fail = UnitTest::Run::Fail;
+/// @brief Used for all strings.
+using string = std::string;
+/// @brief Used as shorthand.
+using gwi = Gwers::Intern;
+
+
+
+/// @brief Unit tests interning strings.
+///
+/// This function unit tests the get(), id(), text(), and size() functions of
+/// the Gwers::Intern class. It performs these tests with three unit tests.
+///
+/// -# Interns two different strings, making sure each gives back a copy of its
+/// text, that interning either again gives back the same pointer and number,
+/// and that the pool grew by exactly two strings.
+///
+/// -# Gets both strings back from their numbers, making sure the pointers are
+/// the same as the ones given by get(), and that a number never given out gives
+/// back nullptr.
+///
+/// -# Has many threads intern the same set of strings at the same time, making
+/// sure every thread gets back the same pointer for the same text and that
+/// each string was only added to the pool once.
+void basic(UnitTest::Run& ut)
+{
+   std::size_t size {gwi::size()};
+   const string* a {gwi::get("unit::intern::a")};
+   const string* b {gwi::get(string("unit::intern::b"))};
+   if (*a!="unit::intern::a"||*b!="unit::intern::b"||a==b||
+       gwi::get("unit::intern::a")!=a||gwi::get("unit::intern::b")!=b||
+       gwi::id(*a)!=gwi::id("unit::intern::a")||gwi::id(*a)==gwi::id(*b)||
+       gwi::size()!=size+2)
+   {
+      throw fail();
+   }
+   ut.next();
+   if (gwi::text(gwi::id(*a))!=a||gwi::text(gwi::id(*b))!=b||
+       gwi::text(~gwi::key(0)))
+   {
+      throw fail();
+   }
+   ut.next();
+   size = gwi::size();
+   const int count {256};
+   std::vector<std::vector<const string*>> found(8);
+   std::vector<std::thread> threads;
+   for (auto& i:found)
+   {
+      threads.emplace_back([&i,count] {
+         for (int j = 0;j<count;++j)
+         {
+            i.push_back(gwi::get("unit::intern::"+std::to_string(j)));
+         }
+      });
+   }
+   for (auto& i:threads)
+   {
+      i.join();
+   }
+   for (auto& i:found)
+   {
+      if (i!=found.front())
+      {
+         throw fail();
+      }
+   }
+   for (int j = 0;j<count;++j)
+   {
+      if (*found.front()[j]!="unit::intern::"+std::to_string(j))
+      {
+         throw fail();
+      }
+   }
+   if (gwi::size()!=size+count)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Initialize all unit tests for Intern class.
+void init(UnitTest& ut)
+{
+   UnitTest::Run& t = ut.add("Intern",nullptr,nullptr);
+   t.add("basic",basic);
+}
+
+
+
+}
+}
@@ -0,0 +1,142 @@
+#ifndef GWERS_INTERN_H
+#define GWERS_INTERN_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+namespace Gwers {
+
+
+
+/// @ingroup exception
+/// @brief Process wide pool of interned strings.
+///
+/// This keeps a single copy of every string given to it for the life of the
+/// process, and gives back a pointer to that copy along with a small number
+/// identifying it. Interning the same text again, from any thread, gives back
+/// the same pointer and the same number, so strings that repeat heavily can be
+/// kept, compared, and written out as a pointer or number instead of as a copy
+/// of their text. This is used for function items of the Trace class whose
+/// names are built at runtime but repeat, see GWX_BEGIN_I.
+///
+/// The pool is a hash table with a fixed number of buckets, each of which is a
+/// singly linked list of strings that only ever grows at its head. Strings are
+/// never removed, so finding a string only reads from the table and takes no
+/// lock, and adding a string is a single compare and swap on the head of its
+/// bucket. Each thread also keeps a small cache of the strings it found last,
+/// so looking up a string the same thread used recently does not touch the
+/// shared table at all.
+///
+/// Numbers are given out in the order strings are added, beginning with 0.
+/// When two threads add the same string at the same time, one of them throws
+/// its copy away, and the number it took for it is never used.
+///
+/// @warning Strings are never freed. Interning strings that do not repeat,
+/// such as ones holding argument values, grows the pool without bound.
+class Intern
+{
+public:
+   // *
+   // * DECLERATIONS
+   // *
+   /// @brief Used for all strings.
+   using string = std::string;
+   /// @brief Type of number identifying an interned string.
+   using key = std::uint32_t;
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   /// @brief Interns string.
+   ///
+   /// @param text Text of string to intern.
+   ///
+   /// @return Pointer to the interned copy of the string, which stays valid for
+   /// the life of the process.
+   static const string* get(std::string_view text);
+   /// @brief Interns string and gets its number.
+   ///
+   /// @param text Text of string to intern.
+   ///
+   /// @return Number identifying the interned string.
+   static key id(std::string_view text);
+   /// @brief Gets interned string from its number.
+   ///
+   /// @param id Number identifying an interned string.
+   ///
+   /// @return Pointer to the interned string, or nullptr if no string has the
+   /// given number.
+   static const string* text(key id);
+   /// @brief Get number of strings interned.
+   static std::size_t size();
+private:
+   // *
+   // * DECLERATIONS
+   // *
+   struct Entry
+   {
+      Entry(std::string_view t, std::size_t h, key i);
+      const string text;
+      const std::size_t hash;
+      const key id;
+      Entry* next {nullptr};
+   };
+   // *
+   // * CONSTANTS
+   // *
+   static constexpr std::size_t _buckets {16384};
+   static constexpr std::size_t _chunk {4096};
+   static constexpr std::size_t _chunks {1024};
+   static constexpr std::size_t _cache {64};
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   static const Entry* find(std::string_view text);
+   static void record(const Entry* entry);
+   // *
+   // * STATIC VARIABLES
+   // *
+   static std::atomic<Entry*> _table[_buckets];
+   static std::atomic<std::atomic<const Entry*>*> _ids[_chunks];
+   static std::atomic<key> _next;
+   static std::atomic<std::size_t> _size;
+   thread_local static const Entry* _front[_cache];
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | INLINE/TEMPLATE                                                          |
+// *==========================================================================*
+//
+//
+//
+
+
+
+inline const Intern::string* Intern::get(std::string_view text)
+{
+   return &find(text)->text;
+}
+
+
+
+inline Intern::key Intern::id(std::string_view text)
+{
+   return find(text)->id;
+}
+
+
+
+inline std::size_t Intern::size()
+{
+   return _size.load(std::memory_order_relaxed);
+}
+
+
+
+}
+#endif
@@ -0,0 +1,234 @@
+#include "key.h"
+#include <algorithm>
+#include <array>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <linux/membarrier.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <ucontext.h>
+#include <unistd.h>
+extern "C" {
+extern const std::uintptr_t __start_gwx_keys[] __attribute__((weak));
+extern const std::uintptr_t __stop_gwx_keys[] __attribute__((weak));
+}
+namespace Gwers {
+
+
+
+namespace
+{
+   std::mutex g_mutex;
+   const unsigned char g_nop[5] {0x0f,0x1f,0x44,0x00,0x00};
+   const unsigned char g_trap {0xcc};
+   std::atomic<const std::uintptr_t*> g_begin {nullptr};
+   std::atomic<const std::uintptr_t*> g_end {nullptr};
+   struct sigaction g_previous;
+
+
+
+   void store(std::uintptr_t code, const unsigned char* bytes,
+              std::size_t size)
+   {
+      auto p = reinterpret_cast<unsigned char*>(code);
+      for (std::size_t i = 0;i<size;++i)
+      {
+         __atomic_store_n(p+i,bytes[i],__ATOMIC_RELAXED);
+      }
+   }
+
+
+
+   bool serialize()
+   {
+      static const bool registered {
+         ::syscall(SYS_membarrier,
+                   MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED_SYNC_CORE,0)==0};
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      return registered&&
+             ::syscall(SYS_membarrier,MEMBARRIER_CMD_PRIVATE_EXPEDITED_SYNC_CORE,
+                       0)==0;
+   }
+
+
+
+   void trap(int signal, siginfo_t* info, void* context)
+   {
+#ifdef __x86_64__
+      auto uc = static_cast<ucontext_t*>(context);
+      std::uintptr_t code {
+         static_cast<std::uintptr_t>(uc->uc_mcontext.gregs[REG_RIP])-1};
+      const std::uintptr_t* begin {g_begin.load(std::memory_order_acquire)};
+      const std::uintptr_t* end {g_end.load(std::memory_order_acquire)};
+      if (begin&&std::binary_search(begin,end,code))
+      {
+         uc->uc_mcontext.gregs[REG_RIP] = static_cast<greg_t>(code);
+         return;
+      }
+#endif
+      if (g_previous.sa_flags&SA_SIGINFO)
+      {
+         g_previous.sa_sigaction(signal,info,context);
+      }
+      else if (g_previous.sa_handler==SIG_DFL||g_previous.sa_handler==SIG_IGN)
+      {
+         ::signal(signal,SIG_DFL);
+         ::raise(signal);
+      }
+      else
+      {
+         g_previous.sa_handler(signal);
+      }
+   }
+
+
+
+   bool install(const std::vector<std::uintptr_t>& codes)
+   {
+      static std::uintptr_t* table {nullptr};
+      if (!table)
+      {
+         table = new std::uintptr_t[codes.size()];
+         std::copy(codes.begin(),codes.end(),table);
+         g_end.store(table+codes.size(),std::memory_order_relaxed);
+         g_begin.store(table,std::memory_order_release);
+         struct sigaction action;
+         std::memset(&action,0,sizeof(action));
+         action.sa_sigaction = trap;
+         action.sa_flags = SA_SIGINFO|SA_RESTART;
+         sigemptyset(&action.sa_mask);
+         if (::sigaction(SIGTRAP,&action,&g_previous)!=0)
+         {
+            return false;
+         }
+      }
+      return true;
+   }
+}
+
+
+
+std::atomic<bool> Key::_enabled {false};
+
+
+
+bool Key::enable()
+{
+   std::lock_guard<std::mutex> lock {g_mutex};
+   if (!patch(true))
+   {
+      patch(false);
+      return false;
+   }
+   _enabled.store(true,std::memory_order_relaxed);
+   return true;
+}
+
+
+
+void Key::disable()
+{
+   std::lock_guard<std::mutex> lock {g_mutex};
+   _enabled.store(false,std::memory_order_relaxed);
+   patch(false);
+}
+
+
+
+std::size_t Key::sites()
+{
+   if (!__start_gwx_keys)
+   {
+      return 0;
+   }
+   return static_cast<std::size_t>(__stop_gwx_keys-__start_gwx_keys)/2;
+}
+
+
+
+bool Key::patch(bool on)
+{
+   std::vector<std::pair<std::uintptr_t,std::uintptr_t>> entries;
+   entries.reserve(sites());
+   for (std::size_t i = 0;i<sites();++i)
+   {
+      entries.emplace_back(__start_gwx_keys[2*i],__start_gwx_keys[2*i+1]);
+   }
+   if (entries.empty())
+   {
+      return true;
+   }
+   std::sort(entries.begin(),entries.end());
+   std::vector<std::uintptr_t> codes;
+   std::vector<std::uintptr_t> pages;
+   std::uintptr_t size {static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE))};
+   for (auto& i:entries)
+   {
+      codes.push_back(i.first);
+      for (std::uintptr_t p:{i.first&~(size-1),(i.first+4)&~(size-1)})
+      {
+         if (pages.empty()||pages.back()!=p)
+         {
+            pages.push_back(p);
+         }
+      }
+   }
+   if (!install(codes))
+   {
+      return false;
+   }
+   bool ret {true};
+   for (auto p:pages)
+   {
+      if (::mprotect(reinterpret_cast<void*>(p),size,
+                     PROT_READ|PROT_WRITE|PROT_EXEC)!=0)
+      {
+         ret = false;
+      }
+   }
+   if (ret)
+   {
+      std::vector<std::array<unsigned char,5>> patched;
+      for (auto& i:entries)
+      {
+         std::array<unsigned char,5> bytes;
+         std::memcpy(bytes.data(),g_nop,5);
+         if (on)
+         {
+            bytes[0] = 0xe9;
+            std::int32_t offset {
+               static_cast<std::int32_t>(i.second-(i.first+5))};
+            std::memcpy(bytes.data()+1,&offset,4);
+         }
+         patched.push_back(bytes);
+      }
+      for (auto& i:entries)
+      {
+         store(i.first,&g_trap,1);
+      }
+      serialize();
+      for (std::size_t i = 0;i<entries.size();++i)
+      {
+         store(entries[i].first+1,patched[i].data()+1,4);
+      }
+      serialize();
+      for (std::size_t i = 0;i<entries.size();++i)
+      {
+         store(entries[i].first,patched[i].data(),1);
+      }
+      serialize();
+   }
+   for (auto p:pages)
+   {
+      ::mprotect(reinterpret_cast<void*>(p),size,PROT_READ|PROT_EXEC);
+   }
+   return ret;
+}
+
+
+
+}
@@ -0,0 +1,189 @@
+#define GWX_STATIC_KEYS
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "unit.hh"
+#include "key.hh"
+extern "C" {
+extern const std::uintptr_t __start_gwx_keys[] __attribute__((weak));
+}
+namespace unit {
+/// @ingroup utest
+/// @brief Tests the switch in front of sites.
+///
+/// Tests turning sites compiled with GWX_STATIC_KEYS on and off by patching
+/// code, consisting of the Key class.
+namespace key {
+
+
+
+/// @brief Used for all strings.
+using string = std::string;
+/// @brief Used for throwing a unit test failure.
+using fail = UnitTest::Run::Fail;
+/// @brief Used as shorthand.
+using gwk = Gwers::Key;
+/// @brief Used as shorthand.
+using gwtr = Gwers::Trace;
+
+
+
+/// @brief Internal function traced with one argument behind the switch.
+///
+/// @return Name of the function item it added, or an empty string if none was
+/// added.
+string keyed(int a)
+{
+   std::size_t depth {gwtr::depth()};
+   GWX_BEGIN("unit::key::keyed(int)",a);
+   if (gwtr::depth()==depth)
+   {
+      return string();
+   }
+   auto i = gwtr::end();
+   return *--i;
+}
+
+
+
+/// @brief Internal function checking the first byte of every patched switch.
+///
+/// @param byte First byte every switch should start with.
+bool patched(unsigned char byte)
+{
+   for (std::size_t i = 0;i<gwk::sites();++i)
+   {
+      std::uintptr_t code {__start_gwx_keys[2*i]};
+      if (*reinterpret_cast<const unsigned char*>(code)!=byte||code%8>3)
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+
+
+/// @brief Unit tests the switch.
+///
+/// This function unit tests the enable(), disable(), enabled(), and sites()
+/// functions of the Gwers::Key class. It performs these tests with three unit
+/// tests.
+///
+/// -# Makes sure the switch starts off, nothing is traced behind it, and on
+/// x86-64 every switch of the program is a NOP that does not cross an aligned
+/// eight byte word.
+///
+/// -# Turns the switch on, making sure the function item is added in full and
+/// every switch is rewritten as a jump.
+///
+/// -# Turns the switch off again, making sure nothing is traced and every
+/// switch is a NOP once more.
+void basic(UnitTest::Run& ut)
+{
+#ifdef GWX__PATCHED
+   const bool patching {true};
+#else
+   const bool patching {false};
+#endif
+   if (gwk::enabled()||!keyed(1).empty()||(gwk::sites()>0)!=patching||
+       !patched(0x0f))
+   {
+      throw fail();
+   }
+   ut.next();
+   bool good {gwk::enable()};
+   good = good&&gwk::enabled()&&keyed(2)=="unit::key::keyed(int)[2]"&&
+          patched(0xe9);
+   gwk::disable();
+   if (!good)
+   {
+      throw fail();
+   }
+   ut.next();
+   if (gwk::enabled()||!keyed(3).empty()||!patched(0x0f))
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Unit tests switches of inline functions and patching while running.
+///
+/// This function unit tests the enable() and disable() functions of the
+/// Gwers::Key class with switches in more than one object and on threads
+/// running through them. It performs these tests with two unit tests.
+///
+/// -# Calls an inline function defined in two objects, from each of them,
+/// making sure nothing is traced while the switch is off and the function item
+/// is added in full from both once it is on.
+///
+/// -# Turns the switch on and off many times while other threads run through
+/// it, making sure every call either adds nothing or adds the function item in
+/// full.
+void shared(UnitTest::Run& ut)
+{
+   if (!key::shared(1).empty()||!elsewhere(2).empty())
+   {
+      throw fail();
+   }
+   bool good {gwk::enable()};
+   good = good&&key::shared(3)=="unit::key::shared(int)[3]"&&
+          elsewhere(4)=="unit::key::shared(int)[4]";
+   gwk::disable();
+   if (!good)
+   {
+      throw fail();
+   }
+   ut.next();
+   std::atomic<bool> stop {false};
+   std::atomic<bool> torn {false};
+   std::vector<std::thread> threads;
+   for (int i = 0;i<4;++i)
+   {
+      threads.emplace_back([&stop,&torn] {
+         while (!stop.load(std::memory_order_relaxed))
+         {
+            string a {keyed(5)};
+            string b {elsewhere(6)};
+            if ((!a.empty()&&a!="unit::key::keyed(int)[5]")||
+                (!b.empty()&&b!="unit::key::shared(int)[6]"))
+            {
+               torn = true;
+            }
+         }
+      });
+   }
+   for (int i = 0;i<200;++i)
+   {
+      gwk::enable();
+      gwk::disable();
+   }
+   stop = true;
+   for (auto& i:threads)
+   {
+      i.join();
+   }
+   if (torn||gwk::enabled()||!patched(0x0f))
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Initialize all unit tests for Key class.
+void init(UnitTest& ut)
+{
+   UnitTest::Run& t = ut.add("Key",nullptr,nullptr);
+   t.add("basic",basic);
+   t.add("shared",shared);
+}
+
+
+
+}
+}
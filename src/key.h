@@ -0,0 +1,142 @@
+#ifndef GWERS_KEY_H
+#define GWERS_KEY_H
+#include <atomic>
+#include <cstddef>
+#if defined(__x86_64__)&&!(defined(__PIC__)&&!defined(__PIE__))
+#define GWX__PATCHED
+#endif
+#if defined(GWX_STATIC_KEYS)&&defined(GWX__PATCHED)
+#define GWX__KEY ::Gwers::Key::branch()
+#elif defined(GWX_STATIC_KEYS)
+#define GWX__KEY ::Gwers::Key::enabled()
+#else
+#define GWX__KEY true
+#endif
+namespace Gwers {
+
+
+
+/// @ingroup exception
+/// @brief Switch that turns every GWX_BEGIN site on or off by patching code.
+///
+/// Even a site that is never traced costs a load of its countdown and a branch
+/// on it. Code compiled with GWX_STATIC_KEYS defined puts a switch in front of
+/// every GWX_BEGIN, GWX_BEGIN_S, GWX_BEGIN_I, and GWX_BEGIN_P site instead, in
+/// the manner of the jump labels of the Linux kernel. The switch compiles to a
+/// single five byte NOP that falls through past the site, and writes the
+/// address of the NOP and of the site into the gwx_keys section, which the
+/// linker gathers into one table for the whole program. The entry is kept in
+/// the same section group as the function holding the switch, so an inline
+/// function or template with a site can be defined in many objects. The whole
+/// site lies behind the switch: its enrolment, its countdown, its function
+/// name buffer, and its Trace object. While the switch is off a site is not
+/// counted as reached or called, and all that is left of it is the NOP and a
+/// flag on the stack that is cleared on entry and tested on return, so the
+/// function ends without a Trace object that was never made. The scale sweep
+/// of the Key class measures such a site against code with no site at all.
+///
+/// enable() turns the switch on without restarting by rewriting every NOP in
+/// the table into a jump to its site, and disable() writes the NOPs back. This
+/// follows the protocol the Linux kernel uses to patch code other cores may be
+/// running: while the pages are made writable with mprotect(), the first byte
+/// of every switch is replaced by an int3 breakpoint, then the last four bytes
+/// are written, then the first byte of the new instruction, with every other
+/// thread made to serialize its instruction stream with membarrier() after
+/// each step. A thread that reaches a switch while it is a breakpoint is sent
+/// SIGTRAP, whose handler, installed the first time the switch is patched,
+/// runs the switch again once it has been patched; any other SIGTRAP is passed
+/// on to the handler installed before it. A thread therefore runs either the
+/// old or the new instruction and never a mix of both.
+///
+/// Patching is only done on x86-64 by code that is not part of a shared
+/// library. Elsewhere, and in any shared library, GWX_STATIC_KEYS makes the
+/// switch a relaxed load of a flag set by the same functions, so the switch
+/// still works and only the cost of a load remains. The switch is off until
+/// enable() is first called. Code compiled without GWX_STATIC_KEYS has no
+/// switch and is not affected by it.
+///
+/// @warning enable() fails and leaves every patched site off if the kernel
+/// does not allow code pages to be made writable. On kernels without the
+/// SYNC_CORE command of membarrier(), enable() and disable() are only safe
+/// while no other thread runs code with a switch. A SIGTRAP handler installed
+/// by the program after the switch was first patched must pass on the signals
+/// it does not handle itself.
+class Key
+{
+public:
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   /// @brief Turns every site on.
+   ///
+   /// @return True if every NOP was rewritten, or false if a page could not be
+   /// made writable.
+   static bool enable();
+   /// @brief Turns every site off.
+   static void disable();
+   /// @brief Get whether the switch is on.
+   static bool enabled();
+   /// @brief Get number of patched switches in the program.
+   static std::size_t sites();
+#ifdef GWX__PATCHED
+   /// @brief The patched switch of a single site.
+   ///
+   /// @return False while the code is a NOP, or true once it is a jump.
+   ///
+   /// @warning This function should never be called directly by the user. It
+   /// is called by the GWX_BEGIN macros when GWX_STATIC_KEYS is defined.
+   __attribute__((always_inline)) static bool branch();
+#endif
+private:
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   static bool patch(bool on);
+   // *
+   // * STATIC VARIABLES
+   // *
+   static std::atomic<bool> _enabled;
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | INLINE/TEMPLATE                                                          |
+// *==========================================================================*
+//
+//
+//
+
+
+
+inline bool Key::enabled()
+{
+   return _enabled.load(std::memory_order_relaxed);
+}
+
+
+
+#ifdef GWX__PATCHED
+__attribute__((always_inline)) inline bool Key::branch()
+{
+   __asm__ goto(".p2align 3,,4\n"
+                "1:\n"
+                ".byte 0x0f,0x1f,0x44,0x00,0x00\n"
+                ".pushsection gwx_keys,\"aw?\"\n"
+                ".balign 8\n"
+                ".quad 1b,%l[on]\n"
+                ".popsection"
+                ::::on);
+   return false;
+on:
+   return true;
+}
+#endif
+
+
+
+}
+#endif
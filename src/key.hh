@@ -0,0 +1,40 @@
+#ifndef KEY_HH
+#define KEY_HH
+#ifndef GWX_STATIC_KEYS
+#define GWX_STATIC_KEYS
+#endif
+#include <string>
+#include "trace.h"
+namespace unit {
+namespace key {
+
+
+
+/// @brief Internal inline function traced behind the switch, which is defined
+/// in both key.cxx and keyed.cxx so the switch of each copy must be dropped
+/// along with the copy the linker throws away.
+///
+/// @return Name of the function item it added, or an empty string if none was
+/// added.
+inline std::string shared(int a)
+{
+   std::size_t depth {Gwers::Trace::depth()};
+   GWX_BEGIN("unit::key::shared(int)",a);
+   if (Gwers::Trace::depth()==depth)
+   {
+      return std::string();
+   }
+   auto i = Gwers::Trace::end();
+   return *--i;
+}
+
+
+
+/// @brief Internal function calling shared() from keyed.cxx.
+std::string elsewhere(int a);
+
+
+
+}
+}
+#endif
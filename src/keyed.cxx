@@ -0,0 +1,15 @@
+#include "key.hh"
+namespace unit {
+namespace key {
+
+
+
+std::string elsewhere(int a)
+{
+   return shared(a);
+}
+
+
+
+}
+}
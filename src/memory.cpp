@@ -0,0 +1,219 @@
+#include "memory.h"
+#include <algorithm>
+#include <mutex>
+#include <sys/syscall.h>
+#include <unistd.h>
+namespace Gwers {
+
+
+
+struct Memory::Account
+{
+   std::atomic<std::int64_t> current {0};
+   std::atomic<std::int64_t> peak {0};
+   std::atomic<std::int64_t> trace {0};
+   std::atomic<std::int64_t> exception {0};
+   std::int64_t pending[2] {0,0};
+   std::uint32_t tid {0};
+};
+
+
+
+namespace
+{
+   std::mutex g_mutex;
+
+
+
+   void raise(std::atomic<std::int64_t>& peak, std::int64_t value)
+   {
+      std::int64_t old {peak.load(std::memory_order_relaxed)};
+      while (old<value&&
+             !peak.compare_exchange_weak(old,value,std::memory_order_relaxed));
+   }
+}
+
+
+
+std::atomic<std::int64_t> Memory::_current {0};
+std::atomic<std::int64_t> Memory::_peak {0};
+std::atomic<std::int64_t> Memory::_trace {0};
+std::atomic<std::int64_t> Memory::_exception {0};
+std::atomic<std::size_t> Memory::_budget {0};
+std::atomic<int> Memory::_allowed {3};
+std::vector<Memory::Account*> Memory::_accounts;
+thread_local Memory::Account* Memory::_account {nullptr};
+thread_local bool Memory::_exited {false};
+thread_local Memory::Guard Memory::_guard {};
+
+
+
+Memory::Guard::~Guard()
+{
+   Account* a {_account};
+   _exited = true;
+   if (a)
+   {
+      settle(*a);
+      count(Kind::trace,-a->trace.load(std::memory_order_relaxed));
+      std::lock_guard<std::mutex> lock {g_mutex};
+      _accounts.erase(std::find(_accounts.begin(),_accounts.end(),a));
+      delete a;
+      _account = nullptr;
+   }
+}
+
+
+
+Memory::Usage Memory::thread()
+{
+   Account* a {_account};
+   if (!a)
+   {
+      return Usage {0,0,0,0};
+   }
+   return Usage {a->current.load(std::memory_order_relaxed),
+                 a->peak.load(std::memory_order_relaxed),
+                 a->trace.load(std::memory_order_relaxed),
+                 a->exception.load(std::memory_order_relaxed)};
+}
+
+
+
+Memory::Usage Memory::process()
+{
+   if (_account)
+   {
+      settle(*_account);
+   }
+   return Usage {_current.load(std::memory_order_relaxed),
+                 _peak.load(std::memory_order_relaxed),
+                 _trace.load(std::memory_order_relaxed),
+                 _exception.load(std::memory_order_relaxed)};
+}
+
+
+
+Memory::list Memory::threads()
+{
+   list ret;
+   std::lock_guard<std::mutex> lock {g_mutex};
+   for (auto a:_accounts)
+   {
+      ret.push_back(Thread {a->tid,
+                            Usage {a->current.load(std::memory_order_relaxed),
+                                   a->peak.load(std::memory_order_relaxed),
+                                   a->trace.load(std::memory_order_relaxed),
+                                   a->exception.load(
+                                      std::memory_order_relaxed)}});
+   }
+   return ret;
+}
+
+
+
+std::size_t Memory::budget()
+{
+   return _budget.load(std::memory_order_relaxed);
+}
+
+
+
+void Memory::set_budget(std::size_t bytes)
+{
+   _budget.store(bytes,std::memory_order_relaxed);
+   judge(_current.load(std::memory_order_relaxed));
+}
+
+
+
+void Memory::add(Kind kind, std::int64_t bytes)
+{
+   if (_exited)
+   {
+      count(kind,bytes);
+      return;
+   }
+   Account* a {_account};
+   if (!a)
+   {
+      a = join();
+   }
+   std::atomic<std::int64_t>& part {kind==Kind::trace?a->trace:a->exception};
+   part.store(part.load(std::memory_order_relaxed)+bytes,
+              std::memory_order_relaxed);
+   std::int64_t current {a->current.load(std::memory_order_relaxed)+bytes};
+   a->current.store(current,std::memory_order_relaxed);
+   if (current>a->peak.load(std::memory_order_relaxed))
+   {
+      a->peak.store(current,std::memory_order_relaxed);
+   }
+   std::int64_t& pending {a->pending[static_cast<int>(kind)]};
+   pending += bytes;
+   if (pending>=chunk||pending<=-chunk)
+   {
+      settle(*a);
+   }
+}
+
+
+
+Memory::Account* Memory::join()
+{
+   Guard& guard {_guard};
+   (void)guard;
+   Account* ret {new Account};
+   ret->tid = static_cast<std::uint32_t>(::syscall(SYS_gettid));
+   {
+      std::lock_guard<std::mutex> lock {g_mutex};
+      _accounts.push_back(ret);
+   }
+   _account = ret;
+   return ret;
+}
+
+
+
+void Memory::settle(Account& account)
+{
+   count(Kind::trace,account.pending[0]);
+   count(Kind::exception,account.pending[1]);
+   account.pending[0] = account.pending[1] = 0;
+}
+
+
+
+void Memory::count(Kind kind, std::int64_t bytes)
+{
+   if (bytes==0)
+   {
+      return;
+   }
+   (kind==Kind::trace?_trace:_exception).fetch_add(bytes,
+                                                   std::memory_order_relaxed);
+   std::int64_t current {_current.fetch_add(bytes,std::memory_order_relaxed)+
+                         bytes};
+   raise(_peak,current);
+   judge(current);
+}
+
+
+
+void Memory::judge(std::int64_t current)
+{
+   std::int64_t budget {static_cast<std::int64_t>(
+                           _budget.load(std::memory_order_relaxed))};
+   int level {3};
+   if (budget>0)
+   {
+      level = current<budget/4*3?3:(current<budget/8*7?2:(current<budget?1:0));
+   }
+   if (_allowed.load(std::memory_order_relaxed)!=level)
+   {
+      _allowed.store(level,std::memory_order_relaxed);
+   }
+}
+
+
+
+}
@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "unit.hh"
+#include "exception.h"
+namespace unit {
+/// @ingroup utest
+/// @brief Tests memory accounting of tracing.
+///
+/// Tests the counting of bytes held by function stacks and exceptions and the
+/// budget that limits them, consisting of the Memory class.
+namespace memory {
+
+
+
+/// @brief Used for all strings.
+using string = std::string;
+/// @brief Used for throwing a unit test failure.
+using fail = UnitTest::Run::Fail;
+/// @brief Used as shorthand.
+using gwe = Gwers::Exception;
+/// @brief Used as shorthand.
+using gwmm = Gwers::Memory;
+/// @brief Used as shorthand.
+using gwtr = Gwers::Trace;
+
+
+
+/// @brief Internal function traced with one argument.
+///
+/// @tparam N Number making a separate site for each unit test, since a site
+/// that was off skips the calls after it.
+///
+/// @return Name of the function item it added, or an empty string if none was
+/// added.
+template<int N> string traced(int a)
+{
+   std::size_t depth {gwtr::depth()};
+   GWX_BEGIN("unit::memory::traced(int)",a);
+   if (gwtr::depth()==depth)
+   {
+      return string();
+   }
+   auto i = gwtr::end();
+   return *--i;
+}
+
+
+
+/// @brief Unit tests counting bytes.
+///
+/// This function unit tests the thread(), process(), and threads() functions
+/// of the Gwers::Memory class. It performs these tests with three unit tests.
+///
+/// -# Adds a function item with a name longer than slack, making sure the bytes
+/// of its name are counted for this thread while it is on the stack, kept as
+/// the peak, and given back once it is removed.
+///
+/// -# Constructs and copies an exception, making sure the bytes of each copy
+/// are counted while it exists and given back once it is destroyed.
+///
+/// -# Adds function items with long names on another thread, making sure the
+/// thread is listed with its bytes while it runs and that the count of the
+/// process is back where it was once the thread has exited.
+void count(UnitTest::Run& ut)
+{
+   gwmm::Usage before {gwmm::thread()};
+   gwmm::Usage during;
+   {
+      gwtr t(string(3000,'a'));
+      during = gwmm::thread();
+   }
+   gwmm::Usage after {gwmm::thread()};
+   if (during.trace<before.trace+3001-gwmm::slack||
+       after.trace!=during.trace-3001||
+       after.peak<during.current||during.current!=during.trace+
+                                                  during.exception)
+   {
+      throw fail();
+   }
+   ut.next();
+   before = gwmm::thread();
+   std::size_t depth {gwtr::depth()};
+   {
+      gwe e(string(40,'w'),string(50,'x'),__LINE__);
+      during = gwmm::thread();
+      gwe copy {e};
+      after = gwmm::thread();
+   }
+   gwtr::rewind(depth);
+   if (during.exception!=before.exception+
+                         static_cast<std::int64_t>(sizeof(gwe))+41+51||
+       after.exception!=before.exception+2*(during.exception-
+                                            before.exception)||
+       gwmm::thread().exception!=before.exception)
+   {
+      throw fail();
+   }
+   ut.next();
+   before = gwmm::process();
+   std::mutex mutex;
+   std::condition_variable cv;
+   int step {0};
+   std::uint32_t tid {0};
+   std::thread t([&] {
+      gwtr t1(string(5000,'b'));
+      gwtr t2(string(5000,'c'));
+      std::unique_lock<std::mutex> lock {mutex};
+      tid = static_cast<std::uint32_t>(syscall(SYS_gettid));
+      step = 1;
+      cv.notify_all();
+      cv.wait(lock,[&] { return step==2; });
+   });
+   gwmm::list threads;
+   {
+      std::unique_lock<std::mutex> lock {mutex};
+      cv.wait(lock,[&] { return step==1; });
+      threads = gwmm::threads();
+      step = 2;
+      cv.notify_all();
+   }
+   t.join();
+   auto i = std::find_if(threads.begin(),threads.end(),
+                         [&](const gwmm::Thread& i) { return i.tid==tid; });
+   after = gwmm::process();
+   if (i==threads.end()||i->usage.trace<10002||after.trace!=before.trace||
+       after.peak<before.current)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Unit tests the budget.
+///
+/// This function unit tests the set_budget() and allowed() functions of the
+/// Gwers::Memory class. It performs these tests with three unit tests.
+///
+/// -# Sets a budget already exceeded, making sure nothing is traced.
+///
+/// -# Sets a budget just over the bytes held now, making sure function items
+/// are still added but without argument values.
+///
+/// -# Removes the budget, making sure function items are added in full again.
+void budget(UnitTest::Run& ut)
+{
+   gwmm::set_budget(1);
+   bool good {gwmm::budget()==1&&gwmm::allowed()==0&&traced<1>(1).empty()};
+   if (!good)
+   {
+      gwmm::set_budget(0);
+      throw fail();
+   }
+   ut.next();
+   gwmm::set_budget(gwmm::process().current*5/4);
+   good = gwmm::allowed()==2&&traced<2>(2)=="unit::memory::traced(int)";
+   gwmm::set_budget(0);
+   if (!good)
+   {
+      throw fail();
+   }
+   ut.next();
+   if (gwmm::allowed()!=3||traced<3>(3)!="unit::memory::traced(int)[3]")
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Initialize all unit tests for Memory class.
+void init(UnitTest& ut)
+{
+   UnitTest::Run& t = ut.add("Memory",nullptr,nullptr);
+   t.add("count",count);
+   t.add("budget",budget);
+}
+
+
+
+}
+}
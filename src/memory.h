@@ -0,0 +1,167 @@
+#ifndef GWERS_MEMORY_H
+#define GWERS_MEMORY_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+namespace Gwers {
+
+
+
+/// @ingroup exception
+/// @brief Accounts for the memory held by tracing and exceptions.
+///
+/// Every thread keeps count of the bytes its function stack holds, which is
+/// the storage of the stack itself plus every function item name too long to
+/// fit inside its string, along with the bytes of every %Gwers exception it
+/// constructs or destroys. Counting is done in plain stores to counters
+/// belonging to the thread, which also keep the highest count the thread ever
+/// reached. A function stack only counts its own change for its thread once
+/// the change grows past slack bytes either way, so pushing and popping
+/// function items mostly costs an add to a counter of the stack. A thread only
+/// adds its change to the count of the whole process once the change grows
+/// past chunk bytes either way, so the count of the process is only touched by
+/// an atomic add once every many function items and can be behind by up to
+/// chunk bytes for every thread. When a thread exits, the bytes of its
+/// function stack are taken off the count of the process, while exceptions
+/// are only taken off once they are destroyed, by whichever
+/// thread that is.
+///
+/// A budget of bytes can be set for the whole process. As the count of the
+/// process nears the budget, every site is held below a lower level of detail
+/// no matter what its own level is: at three quarters of the budget function
+/// items are added without argument values, at seven eighths they are also
+/// sampled, and at the budget nothing is added any more. This keeps a locked
+/// stack, which never pops, or thousands of deep stacks from growing without
+/// limit. Levels are given back as the count falls again.
+///
+/// @warning Stacks given back to be reused by new threads keep their storage
+/// but are no longer counted until a new thread takes them.
+class Memory
+{
+public:
+   // *
+   // * DECLERATIONS
+   // *
+   /// @brief Kinds of storage counted.
+   enum class Kind
+   {
+      trace, ///< Function stack and function item names.
+      exception ///< %Gwers exception objects.
+   };
+   /// @brief Bytes held by a thread or by the whole process.
+   struct Usage
+   {
+      /// @brief Bytes held now.
+      std::int64_t current;
+      /// @brief Highest number of bytes ever held at once.
+      std::int64_t peak;
+      /// @brief Bytes held now by function stacks.
+      std::int64_t trace;
+      /// @brief Bytes held now by exceptions.
+      std::int64_t exception;
+   };
+   /// @brief Bytes held by a single thread.
+   struct Thread
+   {
+      /// @brief Id of the thread given by the kernel.
+      std::uint32_t tid;
+      /// @brief Bytes held by the thread.
+      Usage usage;
+   };
+   /// @brief Type used for lists of threads.
+   using list = std::vector<Thread>;
+   // *
+   // * CONSTANTS
+   // *
+   /// @brief Change in bytes held by a thread before the count of the process
+   /// is updated.
+   static constexpr std::int64_t chunk {16384};
+   /// @brief Change in bytes held by a function stack before it is counted
+   /// for its thread.
+   static constexpr std::int64_t slack {1024};
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   /// @brief Get bytes held by the calling thread.
+   static Usage thread();
+   /// @brief Get bytes held by the whole process.
+   ///
+   /// The change of the calling thread is added to the count of the process
+   /// first, so the count is exact if no other thread is tracing.
+   static Usage process();
+   /// @brief Get bytes held by every thread that has counted any.
+   static list threads();
+   /// @brief Get budget of the process in bytes, 0 meaning none.
+   static std::size_t budget();
+   /// @brief Sets budget of the process.
+   ///
+   /// @param bytes Most bytes tracing and exceptions should hold, or 0 for no
+   /// budget.
+   static void set_budget(std::size_t bytes);
+   /// @brief Get highest level of detail allowed by the budget.
+   ///
+   /// @return The value of a Site::Level, which is full if there is no budget.
+   static int allowed();
+   /// @brief Counts bytes taken or given back by the calling thread.
+   ///
+   /// @param kind Kind of storage.
+   /// @param bytes Bytes taken, or negative for bytes given back.
+   ///
+   /// @warning This function should never be called directly by the user. It
+   /// is called by the Trace and Exception classes.
+   static void add(Kind kind, std::int64_t bytes);
+private:
+   // *
+   // * DECLERATIONS
+   // *
+   struct Account;
+   struct Guard
+   {
+      ~Guard();
+   };
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   static Account* join();
+   static void settle(Account& account);
+   static void count(Kind kind, std::int64_t bytes);
+   static void judge(std::int64_t current);
+   // *
+   // * STATIC VARIABLES
+   // *
+   static std::atomic<std::int64_t> _current;
+   static std::atomic<std::int64_t> _peak;
+   static std::atomic<std::int64_t> _trace;
+   static std::atomic<std::int64_t> _exception;
+   static std::atomic<std::size_t> _budget;
+   static std::atomic<int> _allowed;
+   static std::vector<Account*> _accounts;
+   thread_local static Account* _account;
+   thread_local static bool _exited;
+   thread_local static Guard _guard;
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | INLINE/TEMPLATE                                                          |
+// *==========================================================================*
+//
+//
+//
+
+
+
+inline int Memory::allowed()
+{
+   return _allowed.load(std::memory_order_relaxed);
+}
+
+
+
+}
+#endif
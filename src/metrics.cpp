@@ -0,0 +1,231 @@
+#include "metrics.h"
+#include <mutex>
+#include "format.h"
+namespace Gwers {
+
+
+
+namespace
+{
+   std::mutex g_mutex;
+   std::atomic<std::size_t> g_next {0};
+}
+
+
+
+thread_local std::size_t Metrics::_shard {0};
+
+
+
+Metrics::Counter& Metrics::counter(std::string_view scope,
+                                   std::string_view name)
+{
+   return static_cast<Counter&>(find(scope,name,Kind::counter));
+}
+
+
+
+Metrics::Gauge& Metrics::gauge(std::string_view scope, std::string_view name)
+{
+   return static_cast<Gauge&>(find(scope,name,Kind::gauge));
+}
+
+
+
+Metrics::Histogram& Metrics::histogram(std::string_view scope,
+                                       std::string_view name)
+{
+   return static_cast<Histogram&>(find(scope,name,Kind::histogram));
+}
+
+
+
+Metrics::list Metrics::read()
+{
+   list ret;
+   std::lock_guard<std::mutex> lock {g_mutex};
+   for (auto& i:registry())
+   {
+      ret.push_back(Value {i.first,i.second->kind(),0,0,{}});
+      i.second->read(ret.back());
+   }
+   return ret;
+}
+
+
+
+Metrics::Value Metrics::read(std::string_view name)
+{
+   Value ret {std::string(),Kind::counter,0,0,{}};
+   std::lock_guard<std::mutex> lock {g_mutex};
+   auto i = registry().find(name);
+   if (i!=registry().end())
+   {
+      ret.name = i->first;
+      ret.kind = i->second->kind();
+      i->second->read(ret);
+   }
+   return ret;
+}
+
+
+
+std::uint64_t Metrics::quantile(const Value& value, double q)
+{
+   if (value.kind!=Kind::histogram||value.value<=0)
+   {
+      return 0;
+   }
+   std::uint64_t count {static_cast<std::uint64_t>(value.value)};
+   std::uint64_t rank {static_cast<std::uint64_t>(q*count+0.5)};
+   rank = rank<1?1:(rank>count?count:rank);
+   std::uint64_t seen {0};
+   for (std::size_t i = 0;i<value.buckets.size();++i)
+   {
+      seen += value.buckets[i];
+      if (seen>=rank)
+      {
+         return i==0?0:(i>=64?~std::uint64_t(0):(std::uint64_t(1)<<i)-1);
+      }
+   }
+   return ~std::uint64_t(0);
+}
+
+
+
+void Metrics::print(int fd)
+{
+   Format::Fixed<512> str;
+   for (auto& i:read())
+   {
+      str.clear();
+      switch (i.kind)
+      {
+      case Kind::counter:
+         str << i.name << " counter " << i.value << "\n";
+         break;
+      case Kind::gauge:
+         str << i.name << " gauge " << i.value << "\n";
+         break;
+      default:
+         str << i.name << " histogram count=" << i.value << " sum=" << i.sum
+             << " p50=" << quantile(i,0.5) << " p99=" << quantile(i,0.99)
+             << "\n";
+         break;
+      }
+      str.put(fd);
+   }
+}
+
+
+
+std::size_t Metrics::attach()
+{
+   std::size_t ret {g_next.fetch_add(1,std::memory_order_relaxed)%shards};
+   _shard = ret+1;
+   return ret;
+}
+
+
+
+Metrics::Metric& Metrics::find(std::string_view scope, std::string_view name,
+                               Kind kind)
+{
+   std::string full;
+   full.reserve(scope.size()+2+name.size());
+   if (!scope.empty())
+   {
+      full.append(scope).append("::");
+   }
+   full.append(name);
+   std::lock_guard<std::mutex> lock {g_mutex};
+   auto& r = registry();
+   auto i = r.find(full);
+   if (i==r.end())
+   {
+      std::unique_ptr<Metric> m;
+      switch (kind)
+      {
+      case Kind::counter:
+         m.reset(new Counter);
+         break;
+      case Kind::gauge:
+         m.reset(new Gauge);
+         break;
+      default:
+         m.reset(new Histogram);
+         break;
+      }
+      i = r.emplace(std::move(full),std::move(m)).first;
+   }
+   return *i->second;
+}
+
+
+
+Metrics::registry_type& Metrics::registry()
+{
+   static registry_type* ret {new registry_type};
+   return *ret;
+}
+
+
+
+std::uint64_t Metrics::Counter::value() const
+{
+   std::uint64_t ret {0};
+   for (auto& i:_shards)
+   {
+      ret += i.value.load(std::memory_order_relaxed);
+   }
+   return ret;
+}
+
+
+
+void Metrics::Counter::read(Value& out) const
+{
+   out.value = static_cast<std::int64_t>(value());
+}
+
+
+
+std::int64_t Metrics::Gauge::value() const
+{
+   std::int64_t ret {0};
+   for (auto& i:_shards)
+   {
+      ret += i.value.load(std::memory_order_relaxed);
+   }
+   return ret;
+}
+
+
+
+void Metrics::Gauge::read(Value& out) const
+{
+   out.value = value();
+}
+
+
+
+void Metrics::Histogram::read(Value& out) const
+{
+   out.buckets.assign(buckets,0);
+   std::uint64_t count {0};
+   for (auto& i:_shards)
+   {
+      for (std::size_t j = 0;j<buckets;++j)
+      {
+         std::uint64_t n {i.buckets[j].load(std::memory_order_relaxed)};
+         out.buckets[j] += n;
+         count += n;
+      }
+      out.sum += i.sum.load(std::memory_order_relaxed);
+   }
+   out.value = static_cast<std::int64_t>(count);
+}
+
+
+
+}
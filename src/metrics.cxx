@@ -0,0 +1,197 @@
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "unit.hh"
+#include "exception.h"
+namespace unit {
+/// @ingroup utest
+/// @brief Tests the sharded metrics registry.
+///
+/// Tests counters, gauges, and histograms, consisting of the Metrics class.
+namespace metrics {
+GWX_DECLARE(unit::metrics)
+GWX_EXCEPTION(Failed)
+
+
+
+/// @brief Used for all strings.
+using string = std::string;
+/// @brief Used for throwing a unit test failure.
+using fail = UnitTest::Run::Fail;
+/// @brief Used as shorthand.
+using gwm = Gwers::Metrics;
+
+
+
+/// @brief Internal function that counts one call through a scoped counter.
+void counted()
+{
+   GWX_COUNTER("counted").add();
+}
+
+
+
+/// @brief Unit tests counters and gauges.
+///
+/// This function unit tests the counter(), gauge(), and read() functions of
+/// the Gwers::Metrics class along with the Counter and Gauge classes. It
+/// performs these tests with three unit tests.
+///
+/// -# Counts from many threads at once through the GWX_COUNTER macro, making
+/// sure the counter is named by the scope of GWX_DECLARE and its read value is
+/// the exact number of calls once all threads are done.
+///
+/// -# Raises and lowers a gauge from many threads and then sets it, making
+/// sure every change is kept.
+///
+/// -# Gets the same counter twice and an unknown name, making sure the same
+/// object is returned for the same name and an unknown name reads as empty.
+void basic(UnitTest::Run& ut)
+{
+   constexpr int threads {8};
+   constexpr int calls {10000};
+   std::int64_t before {gwm::read("unit::metrics::counted").value};
+   std::vector<std::thread> pool;
+   for (int i = 0;i<threads;++i)
+   {
+      pool.emplace_back([] {
+         for (int j = 0;j<calls;++j)
+         {
+            counted();
+         }
+      });
+   }
+   for (auto& i:pool)
+   {
+      i.join();
+   }
+   pool.clear();
+   gwm::Value v {gwm::read("unit::metrics::counted")};
+   if (v.name!="unit::metrics::counted"||v.kind!=gwm::Kind::counter||
+       v.value!=before+threads*calls)
+   {
+      throw fail();
+   }
+   ut.next();
+   gwm::Gauge& g {gwm::gauge("unit::metrics","level")};
+   for (int i = 0;i<threads;++i)
+   {
+      pool.emplace_back([&g,i] {
+         for (int j = 0;j<calls;++j)
+         {
+            g.add(i%2?3:-1);
+         }
+      });
+   }
+   for (auto& i:pool)
+   {
+      i.join();
+   }
+   if (g.value()!=threads/2*calls*2)
+   {
+      throw fail();
+   }
+   g.set(-5);
+   if (g.value()!=-5||gwm::read("unit::metrics::level").value!=-5)
+   {
+      throw fail();
+   }
+   ut.next();
+   if (&gwm::counter("unit::metrics","counted")!=
+       &gwm::counter("unit::metrics","counted")||
+       !gwm::read("unit::metrics::missing").name.empty())
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Unit tests histograms, printing, and exception counts.
+///
+/// This function unit tests the histogram(), quantile(), and print()
+/// functions of the Gwers::Metrics class along with the Histogram class. It
+/// performs these tests with three unit tests.
+///
+/// -# Records a spread of values into a histogram, making sure each lands in
+/// its power of 2 bucket, the sum and count are kept, and quantiles give the
+/// top of the right bucket.
+///
+/// -# Constructs an exception twice, making sure the counter named by its who
+/// and what goes up by two.
+///
+/// -# Prints every metric, making sure each kind is written on its own line.
+void histogram(UnitTest::Run& ut)
+{
+   gwm::Histogram& h {gwm::histogram("unit::metrics","latency")};
+   for (std::uint64_t i:{0,1,2,3,100,100,100,1000,1000,5000})
+   {
+      h.add(i);
+   }
+   gwm::Value v {gwm::read("unit::metrics::latency")};
+   if (v.kind!=gwm::Kind::histogram||v.value!=10||v.sum!=7306||
+       v.buckets.size()!=gwm::buckets||v.buckets[0]!=1||v.buckets[1]!=1||
+       v.buckets[2]!=2||v.buckets[7]!=3||v.buckets[10]!=2||
+       v.buckets[13]!=1||gwm::quantile(v,0.5)!=127||
+       gwm::quantile(v,0.99)!=8191||gwm::quantile(v,0.0)!=0)
+   {
+      throw fail();
+   }
+   ut.next();
+   std::int64_t raised {gwm::read("unit::metrics::Failed").value};
+   for (int i = 0;i<2;++i)
+   {
+      try
+      {
+         throw Failed(__LINE__);
+      }
+      catch (Gwers::Exception&)
+      {
+         Gwers::Trace::flush();
+      }
+   }
+   if (gwm::read("unit::metrics::Failed").value!=raised+2)
+   {
+      throw fail();
+   }
+   ut.next();
+   int fds[2];
+   if (pipe(fds)!=0)
+   {
+      throw fail();
+   }
+   gwm::print(fds[1]);
+   close(fds[1]);
+   string out;
+   char buffer[256];
+   ssize_t n;
+   while ((n = read(fds[0],buffer,sizeof(buffer)))>0)
+   {
+      out.append(buffer,n);
+   }
+   close(fds[0]);
+   if (out.find("unit::metrics::counted counter ")==string::npos||
+       out.find("unit::metrics::level gauge -5\n")==string::npos||
+       out.find("unit::metrics::latency histogram count=10 sum=7306 p50=127 "
+                "p99=8191\n")==string::npos)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Initialize all unit tests for Metrics class.
+void init(UnitTest& ut)
+{
+   UnitTest::Run& t = ut.add("Metrics",nullptr,nullptr);
+   t.add("basic",basic);
+   t.add("histogram",histogram);
+}
+
+
+
+}
+}
@@ -0,0 +1,382 @@
+#ifndef GWERS_METRICS_H
+#define GWERS_METRICS_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#define GWX_COUNTER(N) GWX__METRIC(counter,N)
+#define GWX_GAUGE(N) GWX__METRIC(gauge,N)
+#define GWX_HISTOGRAM(N) GWX__METRIC(histogram,N)
+#define GWX__METRIC(K,N) ([]() -> auto& {\
+                            static auto& GWX__tmp__metric\
+                               {::Gwers::Metrics::K(GWX__get__who(),N)};\
+                            return GWX__tmp__metric;\
+                         }())
+namespace Gwers {
+
+
+
+/// @ingroup exception
+/// @brief Registry of counters, gauges, and histograms that scale across
+/// threads.
+///
+/// A single counter incremented by every thread turns into one cache line
+/// bounced between every core. Instead each metric here is split into as many
+/// shards as the shards constant, each alone in a cache line, and every thread
+/// always changes the same shard, picked once per thread in turn. Changing a
+/// metric is then a relaxed atomic add into a cache line that is shared with
+/// few other threads, if any, and reading a metric sums its shards. A read
+/// made while other threads change the metric sees each shard either before or
+/// after each change, so it is exact once those threads are done.
+///
+/// Every metric has a name made of the scope it belongs to and a name within
+/// that scope, joined by ::. The GWX_COUNTER(N), GWX_GAUGE(N), and
+/// GWX_HISTOGRAM(N) macros use the name given to the GWX_DECLARE macro of the
+/// enclosing namespace or class as the scope, and look the metric up only the
+/// first time they are reached, so GWX_COUNTER("requests").add() inside a
+/// namespace declared as app::server counts app::server::requests. Metrics are
+/// never removed, so a reference to one stays good for the life of the
+/// program.
+///
+/// Every %Gwers exception constructed adds one to the counter named by its who
+/// and what, so the number of each kind of exception raised by a scope can be
+/// read back along with every other metric.
+class Metrics
+{
+public:
+   // *
+   // * DECLERATIONS
+   // *
+   class Counter;
+   class Gauge;
+   class Histogram;
+   /// @brief Kinds of metrics.
+   enum class Kind
+   {
+      counter,
+      gauge,
+      histogram
+   };
+   /// @brief The value of a single metric read from every shard.
+   struct Value
+   {
+      /// @brief Full name of metric.
+      std::string name;
+      /// @brief Kind of metric.
+      Kind kind;
+      /// @brief Sum of a counter or gauge, or number of values recorded by a
+      /// histogram.
+      std::int64_t value;
+      /// @brief Sum of values recorded by a histogram.
+      std::uint64_t sum;
+      /// @brief Number of values recorded by a histogram in each bucket.
+      std::vector<std::uint64_t> buckets;
+   };
+   /// @brief Type used for lists of values.
+   using list = std::vector<Value>;
+   // *
+   // * CONSTANTS
+   // *
+   /// @brief Number of shards of every metric.
+   static constexpr std::size_t shards {32};
+   /// @brief Number of buckets of a histogram. Bucket 0 holds the value 0 and
+   /// bucket i holds values from 2 to the power of i-1 up to 2 to the power of
+   /// i minus 1.
+   static constexpr std::size_t buckets {65};
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   /// @brief Get counter, adding it if it does not exist.
+   ///
+   /// @param scope Scope of the counter.
+   /// @param name Name of the counter within its scope.
+   ///
+   /// @warning A name used for one kind of metric must not be used for
+   /// another.
+   static Counter& counter(std::string_view scope, std::string_view name);
+   /// @brief Get gauge, adding it if it does not exist.
+   ///
+   /// @param scope Scope of the gauge.
+   /// @param name Name of the gauge within its scope.
+   static Gauge& gauge(std::string_view scope, std::string_view name);
+   /// @brief Get histogram, adding it if it does not exist.
+   ///
+   /// @param scope Scope of the histogram.
+   /// @param name Name of the histogram within its scope.
+   static Histogram& histogram(std::string_view scope, std::string_view name);
+   /// @brief Get values of every metric.
+   ///
+   /// @return Values sorted by full name.
+   static list read();
+   /// @brief Get value of a metric.
+   ///
+   /// @param name Full name of the metric.
+   ///
+   /// @return Value of the metric, or a value with an empty name if there is
+   /// no such metric.
+   static Value read(std::string_view name);
+   /// @brief Get value below which a fraction of the values recorded by a
+   /// histogram fall.
+   ///
+   /// @param value Value of a histogram.
+   /// @param q Fraction between 0 and 1.
+   ///
+   /// @return Highest value of the bucket holding the fraction, or 0 if the
+   /// histogram is empty.
+   static std::uint64_t quantile(const Value& value, double q);
+   /// @brief Writes the value of every metric as text, one per line.
+   ///
+   /// @param fd File descriptor the text is written to.
+   static void print(int fd);
+private:
+   // *
+   // * DECLERATIONS
+   // *
+   class Metric;
+   using registry_type = std::map<std::string,std::unique_ptr<Metric>,
+                                  std::less<>>;
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   static std::size_t shard();
+   static std::size_t attach();
+   static Metric& find(std::string_view scope, std::string_view name,
+                       Kind kind);
+   static registry_type& registry();
+   // *
+   // * STATIC VARIABLES
+   // *
+   thread_local static std::size_t _shard;
+};
+
+
+
+/// @ingroup exception
+/// @brief Base of every metric.
+class Metrics::Metric
+{
+public:
+   // *
+   // * BASIC METHODS
+   // *
+   Metric(Kind kind);
+   virtual ~Metric() = default;
+   // *
+   // * COPY METHODS
+   // *
+   Metric(const Metric&) = delete;
+   Metric& operator=(const Metric&) = delete;
+   // *
+   // * FUNCTIONS
+   // *
+   Kind kind() const;
+   virtual void read(Value& out) const = 0;
+private:
+   // *
+   // * VARIABLES
+   // *
+   const Kind _kind;
+};
+
+
+
+/// @ingroup exception
+/// @brief A count that only goes up.
+class Metrics::Counter : public Metric
+{
+public:
+   // *
+   // * BASIC METHODS
+   // *
+   Counter();
+   // *
+   // * FUNCTIONS
+   // *
+   /// @brief Adds to this counter.
+   ///
+   /// @param n Amount added.
+   void add(std::uint64_t n = 1);
+   /// @brief Get sum of every shard of this counter.
+   std::uint64_t value() const;
+   void read(Value& out) const override;
+private:
+   // *
+   // * DECLERATIONS
+   // *
+   struct alignas(64) Shard
+   {
+      std::atomic<std::uint64_t> value {0};
+   };
+   // *
+   // * VARIABLES
+   // *
+   Shard _shards[shards];
+};
+
+
+
+/// @ingroup exception
+/// @brief A level that goes up and down.
+class Metrics::Gauge : public Metric
+{
+public:
+   // *
+   // * BASIC METHODS
+   // *
+   Gauge();
+   // *
+   // * FUNCTIONS
+   // *
+   /// @brief Adds to this gauge.
+   ///
+   /// @param n Amount added, which is negative to lower the gauge.
+   void add(std::int64_t n);
+   /// @brief Sets this gauge.
+   ///
+   /// @param n New level.
+   ///
+   /// @warning This reads the gauge and then adds the difference, so it is
+   /// only exact while no other thread changes the gauge at the same time.
+   void set(std::int64_t n);
+   /// @brief Get sum of every shard of this gauge.
+   std::int64_t value() const;
+   void read(Value& out) const override;
+private:
+   // *
+   // * DECLERATIONS
+   // *
+   struct alignas(64) Shard
+   {
+      std::atomic<std::int64_t> value {0};
+   };
+   // *
+   // * VARIABLES
+   // *
+   Shard _shards[shards];
+};
+
+
+
+/// @ingroup exception
+/// @brief A distribution of values in buckets of powers of 2.
+class Metrics::Histogram : public Metric
+{
+public:
+   // *
+   // * BASIC METHODS
+   // *
+   Histogram();
+   // *
+   // * FUNCTIONS
+   // *
+   /// @brief Records a value in this histogram.
+   ///
+   /// @param value Value recorded, such as a latency in nanoseconds.
+   void add(std::uint64_t value);
+   void read(Value& out) const override;
+private:
+   // *
+   // * DECLERATIONS
+   // *
+   struct alignas(64) Shard
+   {
+      std::atomic<std::uint64_t> buckets[Metrics::buckets] {};
+      std::atomic<std::uint64_t> sum {0};
+   };
+   // *
+   // * VARIABLES
+   // *
+   Shard _shards[shards];
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | INLINE/TEMPLATE                                                          |
+// *==========================================================================*
+//
+//
+//
+
+
+
+inline std::size_t Metrics::shard()
+{
+   std::size_t ret {_shard};
+   return ret?ret-1:attach();
+}
+
+
+
+inline Metrics::Metric::Metric(Kind kind):
+   _kind {kind}
+{}
+
+
+
+inline Metrics::Kind Metrics::Metric::kind() const
+{
+   return _kind;
+}
+
+
+
+inline Metrics::Counter::Counter():
+   Metric(Kind::counter)
+{}
+
+
+
+inline void Metrics::Counter::add(std::uint64_t n)
+{
+   _shards[shard()].value.fetch_add(n,std::memory_order_relaxed);
+}
+
+
+
+inline Metrics::Gauge::Gauge():
+   Metric(Kind::gauge)
+{}
+
+
+
+inline void Metrics::Gauge::add(std::int64_t n)
+{
+   _shards[shard()].value.fetch_add(n,std::memory_order_relaxed);
+}
+
+
+
+inline void Metrics::Gauge::set(std::int64_t n)
+{
+   add(n-value());
+}
+
+
+
+inline Metrics::Histogram::Histogram():
+   Metric(Kind::histogram)
+{}
+
+
+
+inline void Metrics::Histogram::add(std::uint64_t value)
+{
+   Shard& s {_shards[shard()]};
+   std::size_t bucket {value?64-static_cast<std::size_t>(
+                                     __builtin_clzll(value)):0};
+   s.buckets[bucket].fetch_add(1,std::memory_order_relaxed);
+   s.sum.fetch_add(value,std::memory_order_relaxed);
+}
+
+
+
+}
+#endif
@@ -0,0 +1,89 @@
+#include "parallel.h"
+namespace Gwers {
+
+
+
+std::size_t Parallel::grain(const ThreadPool& pool, std::size_t size,
+                            std::size_t grain)
+{
+   if (grain==0)
+   {
+      grain = size/(4*(pool.size()+1));
+      if (grain==0)
+      {
+         grain = 1;
+      }
+   }
+   return grain;
+}
+
+
+
+void Parallel::run(ThreadPool& pool, std::size_t begin, std::size_t end,
+                   std::size_t grain, body b)
+{
+   std::shared_ptr<State> s {std::make_shared<State>()};
+   s->run = std::move(b);
+   s->begin = begin;
+   s->end = end;
+   s->grain = grain;
+   s->chunks = count(end-begin,grain);
+   std::size_t helpers {s->chunks-1};
+   if (helpers>pool.size())
+   {
+      helpers = pool.size();
+   }
+   for (std::size_t i = 0;i<helpers;++i)
+   {
+      pool.submit([s] { s->work(); });
+   }
+   s->work();
+   std::unique_lock<std::mutex> l(s->lock);
+   s->finished.wait(l,[&s] { return s->done.load()==s->chunks; });
+   if (!s->failures.empty())
+   {
+      throw Aggregate(std::move(s->failures),s->skipped,__LINE__);
+   }
+}
+
+
+
+void Parallel::State::work()
+{
+   std::size_t depth {Trace::depth()};
+   std::size_t chunk;
+   while ((chunk = next.fetch_add(1))<chunks)
+   {
+      if (cancel.load(std::memory_order_relaxed))
+      {
+         std::lock_guard<std::mutex> l(lock);
+         ++skipped;
+      }
+      else
+      {
+         std::size_t first {begin+chunk*grain};
+         std::size_t last {first+grain<end?first+grain:end};
+         try
+         {
+            run(chunk,first,last);
+         }
+         catch (...)
+         {
+            cancel.store(true,std::memory_order_relaxed);
+            Capture c {Capture::current()};
+            std::lock_guard<std::mutex> l(lock);
+            failures.push_back(std::move(c));
+         }
+         Trace::rewind(depth);
+      }
+      if (done.fetch_add(1)+1==chunks)
+      {
+         std::lock_guard<std::mutex> l(lock);
+         finished.notify_all();
+      }
+   }
+}
+
+
+
+}
@@ -0,0 +1,211 @@
+#include "unit.hh"
+#include "parallel.h"
+namespace unit {
+/// @ingroup utest
+/// @brief Tests parallel algorithms.
+///
+/// Tests the parallel algorithms, consisting of the parallel_for() and
+/// parallel_reduce() functions along with the Aggregate exception.
+namespace parallel {
+
+
+
+/// @brief Used for all strings.
+using string = std::string;
+/// @brief Used for throwing a unit test failure.
+using fail = UnitTest::Run::Fail;
+/// @brief Used as shorthand.
+using gwe = Gwers::Exception;
+/// @brief Used as shorthand.
+using gwtr = Gwers::Trace;
+/// @brief Used as shorthand.
+using pool = Gwers::ThreadPool;
+
+
+
+/// @brief Internal function that is used as the pool exception handler.
+void handler_func(gwe::Type, gwe*, std::exception*)
+{}
+
+
+
+/// @brief Unit tests parallel_for function.
+///
+/// This function unit tests the Gwers::parallel_for() function. It performs
+/// these tests with two unit tests.
+///
+/// -# Calls parallel_for over a large range with an automatic chunk size,
+/// writing to every index of a vector, then makes sure every index was written
+/// exactly once with the correct value.
+///
+/// -# Calls parallel_for over an empty range, making sure the function is
+/// never called.
+void for_(UnitTest::Run& ut)
+{
+   pool p(4,handler_func);
+   std::vector<int> v(100000,0);
+   Gwers::parallel_for(p,0,v.size(),0,[&v](std::size_t i) { v[i] += i*2; });
+   for (std::size_t i = 0;i<v.size();++i)
+   {
+      if (v[i]!=int(i*2))
+      {
+         throw fail();
+      }
+   }
+   ut.next();
+   bool called {false};
+   Gwers::parallel_for(p,10,10,0,[&called](std::size_t) { called = true; });
+   if (called)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Unit tests parallel_reduce function.
+///
+/// This function unit tests the Gwers::parallel_reduce() function. It performs
+/// these tests with three unit tests.
+///
+/// -# Sums a large range of indexes, making sure the result is correct.
+///
+/// -# Concatenates a letter for each index into a string, making sure the
+/// letters are in order of their indexes even though the combine function is
+/// not commutative.
+///
+/// -# Ands together whether each index is below a limit into a bool, one index
+/// per chunk, making sure the result is false only if one index is not below
+/// the limit.
+void reduce(UnitTest::Run& ut)
+{
+   pool p(4,handler_func);
+   long sum = Gwers::parallel_reduce(p,0,100000,0,0l,
+                                     [](std::size_t i) { return long(i); },
+                                     [](long a, long b) { return a+b; });
+   if (sum!=4999950000l)
+   {
+      throw fail();
+   }
+   ut.next();
+   string s = Gwers::parallel_reduce(p,0,260,7,string(),
+                                     [](std::size_t i) {
+                                        return string(1,'a'+i%26);
+                                     },
+                                     [](const string& a, const string& b) {
+                                        return a+b;
+                                     });
+   string expect;
+   for (int i = 0;i<260;++i)
+   {
+      expect += 'a'+i%26;
+   }
+   if (s!=expect)
+   {
+      throw fail();
+   }
+   ut.next();
+   auto below = [](std::size_t limit) {
+      return [limit](std::size_t i) { return i<limit; };
+   };
+   auto both = [](bool a, bool b) { return a&&b; };
+   if (!Gwers::parallel_reduce(p,0,4096,1,true,below(4096),both)||
+       Gwers::parallel_reduce(p,0,4096,1,true,below(4095),both))
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Unit tests aggregation of exceptions.
+///
+/// This function unit tests the Gwers::Aggregate exception thrown by the
+/// parallel algorithms. It performs these tests with two unit tests.
+///
+/// -# Calls parallel_for with a chunk size of one where every index throws a
+/// %Gwers exception within a Trace object, making sure an Aggregate exception
+/// is thrown, every chunk either failed or was cancelled, and every failure
+/// holds the correct exception information and function stack.
+///
+/// -# Calls parallel_reduce where a single index throws a standard exception,
+/// making sure the Aggregate exception thrown holds exactly one failure of the
+/// correct type.
+void aggregate(UnitTest::Run& ut)
+{
+   pool p(4,handler_func);
+   bool caught {false};
+   try
+   {
+      Gwers::parallel_for(p,0,64,1,[](std::size_t) {
+         gwtr t("chunk");
+         throw gwe("test_who","test_what",66);
+      });
+   }
+   catch (Gwers::Aggregate& e)
+   {
+      caught = true;
+      if (e.failures().empty()||e.failures().size()+e.skipped()!=64)
+      {
+         throw fail();
+      }
+      for (auto& i:e.failures())
+      {
+         if (i.type()!=gwe::Type::gwers||i.gwers()->who()!="test_who"||
+             i.gwers()->what()!="test_what"||i.gwers()->line()!=66||
+             i.trace().empty()||i.trace().back()!=string("chunk"))
+         {
+            throw fail();
+         }
+      }
+   }
+   gwtr::flush();
+   if (!caught)
+   {
+      throw fail();
+   }
+   ut.next();
+   caught = false;
+   try
+   {
+      Gwers::parallel_reduce(p,0,1000,10,0,
+                             [](std::size_t i) {
+                                if (i==500)
+                                {
+                                   throw std::exception();
+                                }
+                                return 1;
+                             },
+                             [](int a, int b) { return a+b; });
+   }
+   catch (Gwers::Aggregate& e)
+   {
+      caught = true;
+      if (e.failures().size()!=1||
+          e.failures().front().type()!=gwe::Type::std)
+      {
+         throw fail();
+      }
+   }
+   gwtr::flush();
+   if (!caught)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Initialize all unit tests for parallel algorithms.
+void init(UnitTest& ut)
+{
+   UnitTest::Run& t = ut.add("Parallel",nullptr,nullptr);
+   t.add("for",for_);
+   t.add("reduce",reduce);
+   t.add("aggregate",aggregate);
+}
+
+
+
+}
+}
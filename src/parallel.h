@@ -0,0 +1,298 @@
+#ifndef GWERS_PARALLEL_H
+#define GWERS_PARALLEL_H
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "capture.h"
+#include "threadpool.h"
+namespace Gwers {
+
+
+
+/// @ingroup parallel
+/// @brief Exception holding every failure of a parallel algorithm.
+///
+/// This is thrown by parallel_for() and parallel_reduce() once all of their
+/// chunks have finished or been cancelled, if one or more chunks failed with an
+/// exception. Each failure is a Capture token holding the exception that was
+/// caught along with a snapshot of the function stack of the thread the chunk
+/// failed on. Any single failure can be inspected or rethrown with the function
+/// stack of its own thread.
+class Aggregate : public Exception
+{
+public:
+   // *
+   // * DECLERATIONS
+   // *
+   /// @brief Used for the list of failures.
+   using list = std::vector<Capture>;
+   // *
+   // * BASIC METHODS
+   // *
+   /// @brief Initializes aggregate exception.
+   ///
+   /// @param failures List of all failures that were caught.
+   /// @param skipped Number of chunks that were cancelled and never ran.
+   /// @param line The line of code where this exception is being thrown.
+   ///
+   /// Initializes this aggregate exception, taking ownership of the given list
+   /// of failures.
+   ///
+   /// @warning This constructor should never be called by the user.
+   Aggregate(list&& failures, std::size_t skipped, int line);
+   // *
+   // * FUNCTIONS
+   // *
+   /// @brief Get list of all failures.
+   const list& failures() const;
+   /// @brief Get number of chunks cancelled after the first failure.
+   std::size_t skipped() const;
+private:
+   // *
+   // * VARIABLES
+   // *
+   list _failures;
+   std::size_t _skipped;
+};
+
+
+
+/// @ingroup parallel
+/// @brief Internal chunk scheduler of the parallel algorithms.
+///
+/// This splits an index range into chunks and runs them across the workers of
+/// a ThreadPool along with the calling thread. Chunks are handed out one at a
+/// time from a shared counter, so faster threads take more chunks. Once any
+/// chunk fails, all chunks that have not yet started are cancelled. The calling
+/// thread takes chunks itself until none remain, so calling a parallel
+/// algorithm from a worker of the same pool can never deadlock.
+///
+/// @warning This class should never be used directly by the user, instead use
+/// parallel_for() or parallel_reduce().
+class Parallel
+{
+public:
+   // *
+   // * DECLERATIONS
+   // *
+   /// @brief Used for the body ran for each chunk.
+   ///
+   /// The arguments are the index of the chunk followed by the first and one
+   /// past the last index of the chunk's range.
+   using body = std::function<void(std::size_t,std::size_t,std::size_t)>;
+   /// @brief Partial result of one chunk, kept on a cache line of its own so
+   /// chunks finishing at once on different threads never share one.
+   ///
+   /// @tparam T Type of result.
+   template<class T> struct alignas(64) Slot
+   {
+      /// @brief Result of the chunk.
+      T value;
+   };
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   /// @brief Get size of each chunk.
+   ///
+   /// @param pool Pool the chunks will be ran on.
+   /// @param size Size of the full index range.
+   /// @param grain Size of each chunk or 0 to pick one from the pool's size.
+   ///
+   /// @return Size of each chunk.
+   static std::size_t grain(const ThreadPool& pool, std::size_t size,
+                            std::size_t grain);
+   /// @brief Get number of chunks for an index range.
+   ///
+   /// @param size Size of the full index range.
+   /// @param grain Size of each chunk as returned by grain().
+   ///
+   /// @return Number of chunks.
+   static std::size_t count(std::size_t size, std::size_t grain);
+   /// @brief Runs all chunks of an index range.
+   ///
+   /// @param pool Pool whose workers will help run chunks.
+   /// @param begin First index of range.
+   /// @param end One past the last index of range.
+   /// @param grain Size of each chunk as returned by grain().
+   /// @param b Body that is ran for each chunk.
+   ///
+   /// Runs the body for every chunk of the given range, returning once all
+   /// chunks have finished or been cancelled.
+   ///
+   /// @throw Aggregate If any chunk failed with an exception.
+   static void run(ThreadPool& pool, std::size_t begin, std::size_t end,
+                   std::size_t grain, body b);
+private:
+   // *
+   // * DECLERATIONS
+   // *
+   struct State
+   {
+      void work();
+      body run;
+      std::size_t begin;
+      std::size_t end;
+      std::size_t grain;
+      std::size_t chunks;
+      std::atomic<std::size_t> next {0};
+      std::atomic<std::size_t> done {0};
+      std::atomic<bool> cancel {false};
+      std::size_t skipped {0};
+      Aggregate::list failures;
+      std::mutex lock;
+      std::condition_variable finished;
+   };
+};
+
+
+
+/// @ingroup parallel
+/// @brief Calls a function for every index of a range in parallel.
+///
+/// @tparam F Function type called with each index.
+///
+/// @param pool Pool whose workers will run the chunks.
+/// @param begin First index of range.
+/// @param end One past the last index of range.
+/// @param grain Number of indexes in each chunk, or 0 to pick one from the size
+/// of the pool.
+/// @param f Function called once for each index.
+///
+/// Splits the given range into chunks and calls the function for each index of
+/// every chunk across the workers of the pool and the calling thread. If a call
+/// throws an exception, the rest of its chunk and all chunks that have not yet
+/// started are cancelled.
+///
+/// @throw Aggregate If any chunk failed, holding the failures of all chunks
+/// that failed along with their function stacks.
+template<class F> void parallel_for(ThreadPool& pool, std::size_t begin,
+                                    std::size_t end, std::size_t grain, F f);
+/// @ingroup parallel
+/// @brief Reduces every index of a range into a single value in parallel.
+///
+/// @tparam T Type of value being reduced.
+/// @tparam M Function type mapping an index to a value.
+/// @tparam C Function type combining two values.
+///
+/// @param pool Pool whose workers will run the chunks.
+/// @param begin First index of range.
+/// @param end One past the last index of range.
+/// @param grain Number of indexes in each chunk, or 0 to pick one from the size
+/// of the pool.
+/// @param identity Identity value of the combine function.
+/// @param map Function mapping each index to a value.
+/// @param combine Function combining two values into one.
+///
+/// Splits the given range into chunks, mapping and combining every index of
+/// each chunk into a partial value across the workers of the pool and the
+/// calling thread. The partial values are then combined on the calling thread
+/// in order of their chunks, so the result does not depend on which thread ran
+/// which chunk.
+///
+/// @throw Aggregate If any chunk failed, holding the failures of all chunks
+/// that failed along with their function stacks.
+///
+/// @return Value of all indexes combined.
+template<class T, class M, class C>
+   T parallel_reduce(ThreadPool& pool, std::size_t begin, std::size_t end,
+                     std::size_t grain, T identity, M map, C combine);
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | INLINE/TEMPLATE                                                          |
+// *==========================================================================*
+//
+//
+//
+
+
+
+inline Aggregate::Aggregate(list&& failures, std::size_t skipped, int line):
+   Exception("Gwers","Aggregate",line,[]() -> Metrics::Counter& {
+      static Metrics::Counter& ret {Metrics::counter("Gwers","Aggregate")};
+      return ret;
+   }()),
+   _failures {std::move(failures)},
+   _skipped {skipped}
+{}
+
+
+
+inline const Aggregate::list& Aggregate::failures() const
+{
+   return _failures;
+}
+
+
+
+inline std::size_t Aggregate::skipped() const
+{
+   return _skipped;
+}
+
+
+
+inline std::size_t Parallel::count(std::size_t size, std::size_t grain)
+{
+   return (size+grain-1)/grain;
+}
+
+
+
+template<class F> void parallel_for(ThreadPool& pool, std::size_t begin,
+                                    std::size_t end, std::size_t grain, F f)
+{
+   if (end>begin)
+   {
+      grain = Parallel::grain(pool,end-begin,grain);
+      Parallel::run(pool,begin,end,grain,
+                    [&f](std::size_t, std::size_t first, std::size_t last) {
+         for (std::size_t i = first;i<last;++i)
+         {
+            f(i);
+         }
+      });
+   }
+}
+
+
+
+template<class T, class M, class C>
+   T parallel_reduce(ThreadPool& pool, std::size_t begin, std::size_t end,
+                     std::size_t grain, T identity, M map, C combine)
+{
+   T ret {identity};
+   if (end>begin)
+   {
+      grain = Parallel::grain(pool,end-begin,grain);
+      std::vector<Parallel::Slot<T>> partial(Parallel::count(end-begin,grain),
+                                             Parallel::Slot<T> {identity});
+      Parallel::run(pool,begin,end,grain,
+                    [&](std::size_t chunk, std::size_t first, std::size_t last) {
+         T value {identity};
+         for (std::size_t i = first;i<last;++i)
+         {
+            value = combine(value,map(i));
+         }
+         partial[chunk].value = value;
+      });
+      for (auto& i:partial)
+      {
+         ret = combine(ret,i.value);
+      }
+   }
+   return ret;
+}
+
+
+
+}
+#endif
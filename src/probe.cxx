@@ -0,0 +1,226 @@
+#define GWX_USDT
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include "unit.hh"
+#include "exception.h"
+#ifdef GWX__PROBES
+extern "C" const char gwx_stapsdt_base __asm__("_.stapsdt.base")
+   __attribute__((visibility("hidden")));
+#endif
+namespace unit {
+/// @ingroup utest
+/// @brief Tests probe points for external tracers.
+///
+/// Tests the USDT probes placed at sites and exceptions, consisting of the
+/// Probe class.
+namespace probe {
+GWX_POLICY(Full,2,1)
+
+
+
+/// @brief Used for all strings.
+using string = std::string;
+/// @brief Used for throwing a unit test failure.
+using fail = UnitTest::Run::Fail;
+/// @brief Used as shorthand.
+using gwp = Gwers::Probe;
+/// @brief Used as shorthand.
+using gwtr = Gwers::Trace;
+
+
+
+/// @brief Number of times counted() has been called.
+int g_count {0};
+
+
+
+/// @brief Internal function with a probed site taking one argument.
+int probed(int a)
+{
+   GWX_BEGIN("unit::probe::probed(int)",a);
+   return a+1;
+}
+
+
+
+/// @brief Internal function that counts how many times it is evaluated.
+///
+/// @return Value given.
+int counted(int value)
+{
+   ++g_count;
+   return value;
+}
+
+
+
+/// @brief Unit tests operands.
+///
+/// This function unit tests the operand() function of the Gwers::Probe class.
+/// It performs this test with one unit test.
+///
+/// -# Makes sure integers, enums, pointers, floating point values, strings,
+/// and other objects are each given as the operand they are documented to be.
+void operand(UnitTest::Run&)
+{
+   enum class Color { red, green };
+   const char* text {"text"};
+   string s {"string"};
+   std::string_view v {s};
+   double d {1.5};
+   std::uint64_t bits;
+   std::memcpy(&bits,&d,sizeof(bits));
+   struct Other { int x; } o {1};
+   if (gwp::operand(-1)!=~std::uint64_t(0)||gwp::operand(Color::green)!=1||
+       gwp::operand(text)!=reinterpret_cast<std::uintptr_t>(text)||
+       gwp::operand(d)!=bits||
+       gwp::operand(s)!=reinterpret_cast<std::uintptr_t>(s.data())||
+       gwp::operand(v)!=reinterpret_cast<std::uintptr_t>(s.data())||
+       gwp::operand(o)!=reinterpret_cast<std::uintptr_t>(&o))
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Unit tests evaluating argument values once.
+///
+/// This function unit tests the hold() function of the Gwers::Probe class
+/// along with the GWX_BEGIN macros. It performs these tests with three unit
+/// tests.
+///
+/// -# Uses GWX_BEGIN with an argument value that counts its evaluations,
+/// making sure it is evaluated once and still written to the function item.
+///
+/// -# Does the same with GWX_BEGIN_I.
+///
+/// -# Does the same with GWX_BEGIN_P and a policy of trace level 2.
+void once(UnitTest::Run& ut)
+{
+   g_count = 0;
+   {
+      GWX_BEGIN("once",counted(1));
+      if (g_count!=1||gwtr::depth()!=1||*(gwtr::begin())!=string("once[1]"))
+      {
+         throw fail();
+      }
+   }
+   ut.next();
+   g_count = 0;
+   {
+      GWX_BEGIN_I("once",counted(2));
+      if (g_count!=1||gwtr::depth()!=1||*(gwtr::begin())!=string("once[2]"))
+      {
+         throw fail();
+      }
+   }
+   ut.next();
+   g_count = 0;
+   {
+      GWX_BEGIN_P(Full,"once",counted(3));
+      if (g_count!=1||gwtr::depth()!=1||*(gwtr::begin())!=string("once[3]"))
+      {
+         throw fail();
+      }
+   }
+}
+
+
+
+/// @brief Unit tests the probe notes of the program.
+///
+/// This function unit tests the notes written by the GWX_BEGIN macros and the
+/// Exception class. It performs this test with one unit test.
+///
+/// -# Reads the notes of this program with readelf, making sure there is a
+/// begin probe with the site, name, and one argument as its operands, an end
+/// probe with the site, and a raise probe with the who, what, and line of the
+/// exception, all of provider gwers, and on x86-64 that the code at each of
+/// their locations is a NOP.
+void notes(UnitTest::Run&)
+{
+#ifdef GWX__PROBES
+   if (probed(1)!=2)
+   {
+      throw fail();
+   }
+   string command {"readelf -n /proc/"+std::to_string(::getpid())+
+                   "/exe 2>/dev/null"};
+   std::FILE* in {::popen(command.c_str(),"r")};
+   if (!in)
+   {
+      throw fail();
+   }
+   string provider;
+   string name;
+   std::uintptr_t location {0};
+   std::uintptr_t base {0};
+   bool begin {false};
+   bool end {false};
+   bool raise {false};
+   bool nops {true};
+   char line[1024];
+   while (std::fgets(line,sizeof(line),in))
+   {
+      std::string_view l {line};
+      l.remove_prefix(std::min(l.find_first_not_of(' '),l.size()));
+      if (l.substr(0,10)=="Provider: ")
+      {
+         provider = string(l.substr(10,l.size()-11));
+      }
+      else if (l.substr(0,6)=="Name: ")
+      {
+         name = string(l.substr(6,l.size()-7));
+      }
+      else if (l.substr(0,10)=="Location: ")
+      {
+         char* next;
+         location = std::strtoull(l.data()+10,&next,16);
+         const char* b {std::strstr(next,"Base: ")};
+         base = b?std::strtoull(b+6,nullptr,16):0;
+      }
+      else if (l.substr(0,11)=="Arguments: "&&provider=="gwers")
+      {
+         std::size_t args {1};
+         for (char c:l.substr(11))
+         {
+            args += c==' ';
+         }
+#ifdef __x86_64__
+         const char* code {&gwx_stapsdt_base+(location-base)};
+         nops = nops&&static_cast<unsigned char>(*code)==0x90;
+#endif
+         begin = begin||(name=="begin"&&args==3);
+         end = end||(name=="end"&&args==1);
+         raise = raise||(name=="raise"&&args==3);
+      }
+   }
+   ::pclose(in);
+   if (!begin||!end||!raise||!nops)
+   {
+      throw fail();
+   }
+#endif
+}
+
+
+
+/// @brief Initialize all unit tests for Probe class.
+void init(UnitTest& ut)
+{
+   UnitTest::Run& t = ut.add("Probe",nullptr,nullptr);
+   t.add("operand",operand);
+   t.add("once",once);
+   t.add("notes",notes);
+}
+
+
+
+}
+}
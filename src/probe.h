@@ -0,0 +1,346 @@
+#ifndef GWERS_PROBE_H
+#define GWERS_PROBE_H
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#if defined(__ELF__)&&(defined(__x86_64__)||defined(__aarch64__))
+#define GWX__PROBES
+#endif
+#if defined(GWX_USDT)&&defined(GWX__PROBES)
+#define GWX__HOLD(F,...) const auto GWX__tmp__held\
+                            {::Gwers::Probe::hold(F,##__VA_ARGS__)};
+#define GWX__PROBE() ::Gwers::Probe GWX__tmp__probe\
+                        {GWX__tmp__site,GWX__tmp__held};
+#else
+#define GWX__HOLD(F,...)
+#define GWX__PROBE()
+#endif
+#define GWX__NOTE(N,A) "990: nop\n"\
+                       ".pushsection .note.stapsdt,\"?\",\"note\"\n"\
+                       ".balign 4\n"\
+                       ".4byte 992f-991f,994f-993f,3\n"\
+                       "991: .asciz \"stapsdt\"\n"\
+                       "992: .balign 4\n"\
+                       "993: .8byte 990b\n"\
+                       ".8byte _.stapsdt.base\n"\
+                       ".8byte 0\n"\
+                       ".asciz \"gwers\"\n"\
+                       ".asciz \"" N "\"\n"\
+                       ".asciz \"" A "\"\n"\
+                       "994: .balign 4\n"\
+                       ".popsection\n"\
+                       ".ifndef _.stapsdt.base\n"\
+                       ".pushsection .stapsdt.base,\"aG\",\"progbits\","\
+                       ".stapsdt.base,comdat\n"\
+                       ".weak _.stapsdt.base\n"\
+                       ".hidden _.stapsdt.base\n"\
+                       "_.stapsdt.base: .space 1\n"\
+                       ".size _.stapsdt.base,1\n"\
+                       ".popsection\n"\
+                       ".endif\n"
+namespace Gwers {
+class Site;
+
+
+
+/// @ingroup exception
+/// @brief Probe points that external tracers can attach to.
+///
+/// Code compiled with GWX_USDT defined places a USDT probe, the kind of static
+/// probe read by SystemTap, perf, and bpftrace, at every GWX_BEGIN macro and
+/// every variant of it. This is done whether or not DTRACE is defined, so a
+/// build with no tracing compiled in still has every function it would trace
+/// marked for an external tracer. Every %Gwers exception constructed also fires
+/// a probe if the library itself was built with GWX_USDT defined, as the
+/// libgwers.d3.a variant is, since the probe is placed by the library and not
+/// by the code throwing the exception. Other builds of the library have no
+/// such probe.
+///
+/// A probe is a single NOP in the code along with a note in the
+/// .note.stapsdt section of the object file, giving the address of the NOP,
+/// the provider and name of the probe, and where each of its operands can be
+/// found at that address. A tracer attaching to the probe replaces the NOP with
+/// a breakpoint and reads the operands when it is hit; while no tracer is
+/// attached the NOP is all that runs, apart from moving operands that are not
+/// already in a register or on the stack. Every probe has the provider gwers,
+/// and every operand is 8 bytes wide:
+///
+/// - begin(site, name, arguments...) fires on entering the function, with the
+///   address of the Site as the id of the site, the address of the function
+///   name, and up to the first six argument values.
+/// - end(site) fires on leaving the function.
+/// - raise(who, what, line) fires on constructing an exception, with the
+///   addresses of its who and what strings and its line number.
+///
+/// The function name and argument values given to a GWX_BEGIN macro are
+/// evaluated exactly once, into locals that both the probe and, if DTRACE is
+/// defined, the function item read. Unlike a build with tracing alone, which
+/// only evaluates them when its site samples the call, a build with GWX_USDT
+/// therefore evaluates them on every call, since a tracer may be attached at
+/// any time.
+///
+/// Argument values are given as themselves if they are integers, enums, or
+/// pointers, as their bits if they are floating point, as the address of their
+/// characters if they are strings, and as their own address otherwise. Probes
+/// are only placed on ELF targets for x86-64 and AArch64; elsewhere GWX_USDT
+/// does nothing.
+///
+/// @warning Objects of this class should never be declared directly by the
+/// user, instead use the GWX_BEGIN macros.
+class Probe
+{
+public:
+   // *
+   // * BASIC METHODS
+   // *
+   /// @brief Fires the begin probe.
+   ///
+   /// @tparam F Type of function name.
+   /// @tparam Args List of argument values of function.
+   ///
+   /// @param site Site of the GWX_BEGIN macro.
+   /// @param held Name and argument values of function returned by hold().
+   template<class F, class... Args>
+      __attribute__((always_inline)) Probe(const Site& site,
+                                           const std::tuple<F,Args...>& held);
+   /// @brief Fires the end probe.
+   __attribute__((always_inline)) ~Probe();
+   // *
+   // * COPY METHODS
+   // *
+   Probe(const Probe&) = delete;
+   Probe& operator=(const Probe&) = delete;
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   /// @brief Fires the raise probe.
+   ///
+   /// @param who Who threw the exception.
+   /// @param what What exception was thrown.
+   /// @param line Line number the exception was thrown at.
+   __attribute__((always_inline)) static void raise(const char* who,
+                                                    const char* what,
+                                                    int line);
+   /// @brief Evaluates name and argument values of a function once.
+   ///
+   /// @tparam F Type of function name.
+   /// @tparam Args List of argument values of function.
+   ///
+   /// @param name Name of function.
+   /// @param args Variable list of argument values of function.
+   ///
+   /// @return Tuple referring to every value given as an lvalue and holding
+   /// every other value itself, so it lives as long as the tuple does.
+   template<class F, class... Args>
+      static std::tuple<F,Args...> hold(F&& name, Args&&... args);
+   /// @brief Get value a probe gives as the operand of a value.
+   ///
+   /// @tparam T Type of value.
+   ///
+   /// @param value Value given to a probe.
+   template<class T> static std::uint64_t operand(const T& value);
+private:
+   // *
+   // * DECLERATIONS
+   // *
+   using u64 = std::uint64_t;
+   // *
+   // * BASIC METHODS
+   // *
+   template<class T, std::size_t... I>
+      __attribute__((always_inline)) Probe(const Site& site, const T& held,
+                                           std::index_sequence<I...>);
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   __attribute__((always_inline)) static void enter(const Site* s, u64 n);
+   __attribute__((always_inline)) static void enter(const Site* s, u64 n,
+                                                    u64 a);
+   __attribute__((always_inline)) static void enter(const Site* s, u64 n,
+                                                    u64 a, u64 b);
+   __attribute__((always_inline)) static void enter(const Site* s, u64 n,
+                                                    u64 a, u64 b, u64 c);
+   __attribute__((always_inline)) static void enter(const Site* s, u64 n,
+                                                    u64 a, u64 b, u64 c,
+                                                    u64 d);
+   __attribute__((always_inline)) static void enter(const Site* s, u64 n,
+                                                    u64 a, u64 b, u64 c,
+                                                    u64 d, u64 e);
+   template<class... Rest>
+      __attribute__((always_inline)) static void enter(const Site* s, u64 n,
+                                                       u64 a, u64 b, u64 c,
+                                                       u64 d, u64 e, u64 f,
+                                                       Rest...);
+   // *
+   // * VARIABLES
+   // *
+   const Site* _site;
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | INLINE/TEMPLATE                                                          |
+// *==========================================================================*
+//
+//
+//
+
+
+
+template<class F, class... Args>
+   inline Probe::Probe(const Site& site, const std::tuple<F,Args...>& held):
+   Probe(site,held,std::index_sequence_for<F,Args...>())
+{}
+
+
+
+template<class T, std::size_t... I>
+   inline Probe::Probe(const Site& site, const T& held,
+                       std::index_sequence<I...>):
+   _site {&site}
+{
+   enter(_site,operand(std::get<I>(held))...);
+}
+
+
+
+inline Probe::~Probe()
+{
+#ifdef GWX__PROBES
+   __asm__ volatile(GWX__NOTE("end","8@%0")::"nor"(_site));
+#endif
+}
+
+
+
+inline void Probe::raise(const char* who, const char* what, int line)
+{
+#ifdef GWX__PROBES
+   __asm__ volatile(GWX__NOTE("raise","8@%0 8@%1 8@%2")
+                    ::"nor"(who),"nor"(what),
+                      "nor"(static_cast<u64>(line)));
+#else
+   (void)who;
+   (void)what;
+   (void)line;
+#endif
+}
+
+
+
+template<class F, class... Args>
+   inline std::tuple<F,Args...> Probe::hold(F&& name, Args&&... args)
+{
+   return std::tuple<F,Args...>(std::forward<F>(name),
+                                std::forward<Args>(args)...);
+}
+
+
+
+template<class T> inline std::uint64_t Probe::operand(const T& value)
+{
+   if constexpr (std::is_integral<T>::value||std::is_enum<T>::value)
+   {
+      return static_cast<u64>(value);
+   }
+   else if constexpr (std::is_floating_point<T>::value)
+   {
+      double d {static_cast<double>(value)};
+      u64 ret;
+      std::memcpy(&ret,&d,sizeof(ret));
+      return ret;
+   }
+   else if constexpr (std::is_pointer<T>::value)
+   {
+      return reinterpret_cast<std::uintptr_t>(value);
+   }
+   else if constexpr (std::is_array<T>::value)
+   {
+      return reinterpret_cast<std::uintptr_t>(&value[0]);
+   }
+   else if constexpr (std::is_convertible<const T&,std::string_view>::value)
+   {
+      return reinterpret_cast<std::uintptr_t>(
+                std::string_view(value).data());
+   }
+   else
+   {
+      return reinterpret_cast<std::uintptr_t>(&value);
+   }
+}
+
+
+
+#ifdef GWX__PROBES
+inline void Probe::enter(const Site* s, u64 n)
+{
+   __asm__ volatile(GWX__NOTE("begin","8@%0 8@%1")::"nor"(s),"nor"(n));
+}
+
+
+
+inline void Probe::enter(const Site* s, u64 n, u64 a)
+{
+   __asm__ volatile(GWX__NOTE("begin","8@%0 8@%1 8@%2")
+                    ::"nor"(s),"nor"(n),"nor"(a));
+}
+
+
+
+inline void Probe::enter(const Site* s, u64 n, u64 a, u64 b)
+{
+   __asm__ volatile(GWX__NOTE("begin","8@%0 8@%1 8@%2 8@%3")
+                    ::"nor"(s),"nor"(n),"nor"(a),"nor"(b));
+}
+
+
+
+inline void Probe::enter(const Site* s, u64 n, u64 a, u64 b, u64 c)
+{
+   __asm__ volatile(GWX__NOTE("begin","8@%0 8@%1 8@%2 8@%3 8@%4")
+                    ::"nor"(s),"nor"(n),"nor"(a),"nor"(b),"nor"(c));
+}
+
+
+
+inline void Probe::enter(const Site* s, u64 n, u64 a, u64 b, u64 c, u64 d)
+{
+   __asm__ volatile(GWX__NOTE("begin","8@%0 8@%1 8@%2 8@%3 8@%4 8@%5")
+                    ::"nor"(s),"nor"(n),"nor"(a),"nor"(b),"nor"(c),
+                      "nor"(d));
+}
+
+
+
+inline void Probe::enter(const Site* s, u64 n, u64 a, u64 b, u64 c, u64 d,
+                         u64 e)
+{
+   __asm__ volatile(GWX__NOTE("begin","8@%0 8@%1 8@%2 8@%3 8@%4 8@%5 8@%6")
+                    ::"nor"(s),"nor"(n),"nor"(a),"nor"(b),"nor"(c),
+                      "nor"(d),"nor"(e));
+}
+
+
+
+template<class... Rest>
+   inline void Probe::enter(const Site* s, u64 n, u64 a, u64 b, u64 c, u64 d,
+                            u64 e, u64 f, Rest...)
+{
+   __asm__ volatile(GWX__NOTE("begin",
+                              "8@%0 8@%1 8@%2 8@%3 8@%4 8@%5 8@%6 8@%7")
+                    ::"nor"(s),"nor"(n),"nor"(a),"nor"(b),"nor"(c),
+                      "nor"(d),"nor"(e),"nor"(f));
+}
+#endif
+
+
+
+}
+#endif
@@ -0,0 +1,285 @@
+#include "profile.h"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <time.h>
+#include <unordered_map>
+#include "format.h"
+#include "site.h"
+namespace Gwers {
+
+
+
+namespace
+{
+   struct Key
+   {
+      bool operator==(const Key& k) const
+      {
+         return tag==k.tag&&site==k.site;
+      }
+      std::uint32_t tag;
+      const Site* site;
+   };
+
+
+
+   struct Hash
+   {
+      std::size_t operator()(const Key& k) const
+      {
+         return std::hash<const Site*>()(k.site)^
+                (static_cast<std::size_t>(k.tag)*0x9E3779B97F4A7C15ull);
+      }
+   };
+
+
+
+   std::mutex g_mutex;
+}
+
+
+
+struct Profile::Table
+{
+   std::mutex mutex;
+   std::unordered_map<Key,Cost,Hash> costs;
+   std::uint64_t epoch {0};
+};
+
+
+
+std::atomic<bool> Profile::_profiling {false};
+std::atomic<bool> Profile::_timing {false};
+std::atomic<std::uint64_t> Profile::_epoch {0};
+Profile::Table Profile::_exited {};
+std::vector<Profile::Table*> Profile::_tables;
+thread_local Profile::Handle Profile::_handle {};
+thread_local bool Profile::_gone {false};
+
+
+
+Profile::Handle::~Handle()
+{
+   _gone = true;
+   if (table)
+   {
+      std::lock_guard<std::mutex> lock {g_mutex};
+      std::lock_guard<std::mutex> elock {_exited.mutex};
+      if (table->epoch==_exited.epoch)
+      {
+         for (auto& i:table->costs)
+         {
+            Cost& c {_exited.costs[i.first]};
+            c.calls += i.second.calls;
+            c.nanoseconds += i.second.nanoseconds;
+            c.cpu += i.second.cpu;
+            c.bytes += i.second.bytes;
+            c.exceptions += i.second.exceptions;
+         }
+      }
+      _tables.erase(std::find(_tables.begin(),_tables.end(),table));
+      delete table;
+      table = nullptr;
+   }
+}
+
+
+
+void Profile::start(bool cpu)
+{
+   std::lock_guard<std::mutex> lock {g_mutex};
+   std::uint64_t epoch {_epoch.load(std::memory_order_relaxed)+1};
+   {
+      std::lock_guard<std::mutex> elock {_exited.mutex};
+      _exited.costs.clear();
+      _exited.epoch = epoch;
+   }
+   _epoch.store(epoch,std::memory_order_release);
+   _timing.store(cpu,std::memory_order_relaxed);
+   _profiling.store(true,std::memory_order_release);
+}
+
+
+
+void Profile::stop()
+{
+   _profiling.store(false,std::memory_order_release);
+}
+
+
+
+Profile::list Profile::read()
+{
+   std::unordered_map<Key,Cost,Hash> merged;
+   {
+      std::lock_guard<std::mutex> lock {g_mutex};
+      std::uint64_t epoch {_epoch.load(std::memory_order_acquire)};
+      std::vector<Table*> tables {_tables};
+      tables.push_back(&_exited);
+      for (auto t:tables)
+      {
+         std::lock_guard<std::mutex> tlock {t->mutex};
+         if (t->epoch!=epoch)
+         {
+            continue;
+         }
+         for (auto& i:t->costs)
+         {
+            Cost& c {merged[i.first]};
+            c.calls += i.second.calls;
+            c.nanoseconds += i.second.nanoseconds;
+            c.cpu += i.second.cpu;
+            c.bytes += i.second.bytes;
+            c.exceptions += i.second.exceptions;
+         }
+      }
+   }
+   list ret;
+   ret.reserve(merged.size());
+   for (auto& i:merged)
+   {
+      ret.push_back(Entry {i.first.tag,i.first.site,i.second});
+   }
+   std::sort(ret.begin(),ret.end(),[](const Entry& a, const Entry& b) {
+      if (a.tag!=b.tag)
+      {
+         return a.tag<b.tag;
+      }
+      if (!a.site||!b.site)
+      {
+         return !a.site&&b.site;
+      }
+      int file {std::strcmp(a.site->file(),b.site->file())};
+      if (file!=0)
+      {
+         return file<0;
+      }
+      return a.site->line()<b.site->line();
+   });
+   return ret;
+}
+
+
+
+void Profile::print(int fd)
+{
+   list entries {read()};
+   bool timing {Profile::timing()};
+   Format::Fixed<512> str;
+   str << "PROFILE: " << entries.size() << " entries\n";
+   str.put(fd);
+   for (auto& i:entries)
+   {
+      str.clear();
+      str << i.tag << " ";
+      if (i.site)
+      {
+         str << i.site->file() << ":" << i.site->line() << " "
+             << i.site->function();
+      }
+      else
+      {
+         str << "-";
+      }
+      str << " calls=" << i.cost.calls << " ns=" << i.cost.nanoseconds;
+      if (timing)
+      {
+         std::uint64_t cpu {std::min(i.cost.cpu,i.cost.nanoseconds)};
+         str << " on_cpu=" << cpu << " off_cpu=" << i.cost.nanoseconds-cpu;
+      }
+      str << " bytes=" << i.cost.bytes << " exceptions=" << i.cost.exceptions
+          << "\n";
+      str.put(fd);
+   }
+}
+
+
+
+std::int64_t Profile::now()
+{
+   timespec t;
+   ::clock_gettime(CLOCK_MONOTONIC,&t);
+   return static_cast<std::int64_t>(t.tv_sec)*1000000000+t.tv_nsec;
+}
+
+
+
+std::int64_t Profile::cputime()
+{
+   timespec t;
+   ::clock_gettime(CLOCK_THREAD_CPUTIME_ID,&t);
+   return static_cast<std::int64_t>(t.tv_sec)*1000000000+t.tv_nsec;
+}
+
+
+
+void Profile::charge(std::uint32_t tag, const Site* site, unsigned weight,
+                     std::int64_t nanoseconds, std::int64_t cpu,
+                     std::int64_t bytes)
+{
+   add(tag,site,Cost {weight,
+                      static_cast<std::uint64_t>(nanoseconds>0?nanoseconds:0)*
+                      weight,
+                      static_cast<std::uint64_t>(cpu>0?cpu:0)*weight,
+                      static_cast<std::uint64_t>(bytes>0?bytes:0),0});
+}
+
+
+
+void Profile::raise(std::uint32_t tag, const Site* site, std::int64_t bytes)
+{
+   add(tag,site,Cost {0,0,0,static_cast<std::uint64_t>(bytes>0?bytes:0),1});
+}
+
+
+
+void Profile::add(std::uint32_t tag, const Site* site, const Cost& cost)
+{
+   std::uint64_t epoch {_epoch.load(std::memory_order_acquire)};
+   Table* t {_handle.table};
+   if (_gone)
+   {
+      t = &_exited;
+   }
+   else if (!t||_handle.epoch!=epoch)
+   {
+      t = attach(epoch);
+   }
+   std::lock_guard<std::mutex> lock {t->mutex};
+   if (t->epoch!=epoch)
+   {
+      return;
+   }
+   Cost& c {t->costs[Key {tag,site}]};
+   c.calls += cost.calls;
+   c.nanoseconds += cost.nanoseconds;
+   c.cpu += cost.cpu;
+   c.bytes += cost.bytes;
+   c.exceptions += cost.exceptions;
+}
+
+
+
+Profile::Table* Profile::attach(std::uint64_t epoch)
+{
+   Table* t {_handle.table};
+   if (!t)
+   {
+      t = new Table;
+      std::lock_guard<std::mutex> lock {g_mutex};
+      _tables.push_back(t);
+   }
+   {
+      std::lock_guard<std::mutex> lock {t->mutex};
+      t->costs.clear();
+      t->epoch = epoch;
+   }
+   _handle.table = t;
+   _handle.epoch = epoch;
+   return t;
+}
+
+
+
+}
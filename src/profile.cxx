@@ -0,0 +1,302 @@
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "unit.hh"
+#include "exception.h"
+namespace unit {
+/// @ingroup utest
+/// @brief Tests the profile of costs per tag and site.
+///
+/// Tests the charging of time, bytes, and exceptions to tags and sites,
+/// consisting of the Profile class.
+namespace profile {
+GWX_DECLARE(unit::profile)
+GWX_EXCEPTION(Failed)
+
+
+
+/// @brief Used for all strings.
+using string = std::string;
+/// @brief Used for throwing a unit test failure.
+using fail = UnitTest::Run::Fail;
+/// @brief Used for calling %Gwers exceptions.
+using gwe = Gwers::Exception;
+/// @brief Used as shorthand.
+using gwpf = Gwers::Profile;
+/// @brief Used as shorthand.
+using gwtg = Gwers::Tag;
+
+
+
+/// @brief Internal function traced by a site sampling every call.
+void work()
+{
+   GWX_BEGIN("unit::profile::work()");
+   std::this_thread::sleep_for(std::chrono::microseconds(100));
+}
+
+
+
+/// @brief Internal function traced by a site sampling one call in four.
+void sampled()
+{
+   GWX_BEGIN_S(4,"unit::profile::sampled()");
+}
+
+
+
+/// @brief Internal function traced by a site that keeps its thread busy.
+void spin()
+{
+   GWX_BEGIN("unit::profile::spin()");
+   std::int64_t end {gwpf::cputime()+2000000};
+   while (gwpf::cputime()<end);
+}
+
+
+
+/// @brief Internal function traced by a site that throws.
+void thrower()
+{
+   GWX_BEGIN("unit::profile::thrower()");
+   throw Failed(__LINE__);
+}
+
+
+
+/// @brief Internal function that finds the costs of a tag at a site.
+///
+/// @return Costs found, which are all 0 if there are none.
+gwpf::Cost find(const gwpf::list& entries, std::uint32_t tag,
+                const string& function)
+{
+   for (auto& i:entries)
+   {
+      if (i.tag==tag&&i.site&&function==i.site->function())
+      {
+         return i.cost;
+      }
+   }
+   return gwpf::Cost {0,0,0,0,0};
+}
+
+
+
+/// @brief Unit tests charging costs.
+///
+/// This function unit tests the start(), stop(), and read() functions of the
+/// Gwers::Profile class. It performs these tests with four unit tests.
+///
+/// -# Calls a traced function under two tags, making sure each tag is charged
+/// its own calls and at least the time they slept at the site of the function.
+///
+/// -# Calls a function whose site samples one call in four eight times, making
+/// sure it is charged eight calls.
+///
+/// -# Throws an exception from a traced function under a tag, making sure it
+/// is charged to that tag at the site of the function.
+///
+/// -# Calls a traced function after stopping and again after starting, making
+/// sure nothing is charged while stopped and that starting forgets the costs
+/// charged before.
+void charge(UnitTest::Run& ut)
+{
+   gwpf::start();
+   {
+      gwtg t(21);
+      work();
+      work();
+   }
+   {
+      gwtg t(22);
+      work();
+   }
+   gwpf::list entries {gwpf::read()};
+   gwpf::Cost a {find(entries,21,"unit::profile::work()")};
+   gwpf::Cost b {find(entries,22,"unit::profile::work()")};
+   if (!gwpf::profiling()||a.calls!=2||a.nanoseconds<200000||b.calls!=1||
+       b.nanoseconds<100000||a.exceptions!=0)
+   {
+      throw fail();
+   }
+   ut.next();
+   {
+      gwtg t(23);
+      for (int i = 0;i<8;++i)
+      {
+         sampled();
+      }
+   }
+   if (find(gwpf::read(),23,"unit::profile::sampled()").calls!=8)
+   {
+      throw fail();
+   }
+   ut.next();
+   try
+   {
+      gwtg t(24);
+      thrower();
+   }
+   catch (gwe&)
+   {}
+   Gwers::Trace::flush();
+   gwpf::Cost c {find(gwpf::read(),24,"unit::profile::thrower()")};
+   if (c.exceptions!=1||c.calls!=1||c.bytes<sizeof(gwe))
+   {
+      throw fail();
+   }
+   ut.next();
+   gwpf::stop();
+   {
+      gwtg t(21);
+      work();
+   }
+   if (find(gwpf::read(),21,"unit::profile::work()").calls!=2)
+   {
+      throw fail();
+   }
+   gwpf::start();
+   {
+      gwtg t(22);
+      work();
+   }
+   entries = gwpf::read();
+   gwpf::stop();
+   if (find(entries,21,"unit::profile::work()").calls!=0||
+       find(entries,22,"unit::profile::work()").calls!=1||
+       find(entries,22,"unit::profile::work()").cpu!=0)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Unit tests CPU timing.
+///
+/// This function unit tests the start() and timing() functions of the
+/// Gwers::Profile class when started with CPU timing. It performs these tests
+/// with two unit tests.
+///
+/// -# Calls a traced function that keeps its thread busy and one that sleeps,
+/// making sure the first is charged nearly all of its time as on-CPU time and
+/// the second nearly none of it.
+///
+/// -# Prints the costs, making sure the on-CPU and off-CPU time of the sleeping
+/// function are given side by side and add up to its time.
+void cpu(UnitTest::Run& ut)
+{
+   gwpf::start(true);
+   {
+      gwtg t(26);
+      spin();
+      work();
+   }
+   gwpf::stop();
+   gwpf::list entries {gwpf::read()};
+   gwpf::Cost busy {find(entries,26,"unit::profile::spin()")};
+   gwpf::Cost idle {find(entries,26,"unit::profile::work()")};
+   if (!gwpf::timing()||busy.cpu<2000000||busy.cpu>busy.nanoseconds||
+       idle.nanoseconds<100000||idle.cpu>idle.nanoseconds/2)
+   {
+      throw fail();
+   }
+   ut.next();
+   int fds[2];
+   if (pipe(fds)!=0)
+   {
+      throw fail();
+   }
+   std::thread reader([&] {
+      gwpf::print(fds[1]);
+      close(fds[1]);
+   });
+   string out;
+   char buffer[256];
+   ssize_t n;
+   while ((n = read(fds[0],buffer,sizeof(buffer)))>0)
+   {
+      out.append(buffer,n);
+   }
+   reader.join();
+   close(fds[0]);
+   string line {" unit::profile::work() calls=1 ns="+
+                std::to_string(idle.nanoseconds)+" on_cpu="+
+                std::to_string(idle.cpu)+" off_cpu="+
+                std::to_string(idle.nanoseconds-idle.cpu)+" "};
+   if (out.find(line)==string::npos)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Unit tests merging and printing costs.
+///
+/// This function unit tests the read() and print() functions of the
+/// Gwers::Profile class. It performs these tests with two unit tests.
+///
+/// -# Calls a traced function under a tag on a thread that then exits, making
+/// sure its costs are still read.
+///
+/// -# Prints the costs, making sure the number of entries comes first and the
+/// costs of the thread follow with their tag and site.
+void merge(UnitTest::Run& ut)
+{
+   gwpf::start();
+   std::thread t([] {
+      gwtg t(25);
+      work();
+   });
+   t.join();
+   gwpf::stop();
+   gwpf::list entries {gwpf::read()};
+   if (find(entries,25,"unit::profile::work()").calls!=1)
+   {
+      throw fail();
+   }
+   ut.next();
+   int fds[2];
+   if (pipe(fds)!=0)
+   {
+      throw fail();
+   }
+   std::thread reader([&] {
+      gwpf::print(fds[1]);
+      close(fds[1]);
+   });
+   string out;
+   char buffer[256];
+   ssize_t n;
+   while ((n = read(fds[0],buffer,sizeof(buffer)))>0)
+   {
+      out.append(buffer,n);
+   }
+   reader.join();
+   close(fds[0]);
+   std::size_t line {out.find("\n25 ")};
+   if (out.find("PROFILE: "+std::to_string(entries.size())+" entries\n")!=0||
+       line==string::npos||
+       out.find(" unit::profile::work() calls=1 ns=",line)>
+       out.find("\n",line+1))
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Initialize all unit tests for Profile class.
+void init(UnitTest& ut)
+{
+   UnitTest::Run& t = ut.add("Profile",nullptr,nullptr);
+   t.add("charge",charge);
+   t.add("cpu",cpu);
+   t.add("merge",merge);
+}
+
+
+
+}
+}
@@ -0,0 +1,194 @@
+#ifndef GWERS_PROFILE_H
+#define GWERS_PROFILE_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+namespace Gwers {
+class Site;
+
+
+
+/// @ingroup exception
+/// @brief Adds up what each tag costs at each site.
+///
+/// While profiling is on, every function item added by a GWX_BEGIN macro
+/// whose call was sampled is timed from when it is added until it is removed,
+/// and its time is charged to the site that added it and the Tag the thread
+/// had when it was removed, along with the bytes its name took beyond the
+/// string itself. Every %Gwers exception constructed is charged the same way,
+/// to the site on top of the stack and the tag of the thread, along with the
+/// bytes of the exception. Costs are therefore kept for each pair of tag and
+/// site, so the time, memory, and exceptions of a program can be split by the
+/// tenant or request each piece of work was done for.
+///
+/// A function item added by a site that samples one call in N stands for N
+/// calls, so it is charged as N calls taking N times its own time. A function
+/// item removed because an exception was thrown through it is charged as well.
+///
+/// Profiling can also be started with CPU timing, which reads the CPU time of
+/// the thread, the time it actually ran on a core, when each function item is
+/// added and removed. The time a function item was on the stack is then split
+/// into its on-CPU time and its off-CPU time, the time its thread was blocked,
+/// sleeping, or waiting for a core, which tells apart code that is slow from
+/// code that waits on locks or I/O. Reading the CPU time of a thread takes a
+/// system call, so it is only done for function items that are timed at all,
+/// which are those sampled by their site; lowering the sampling rate of a site
+/// lowers the cost of CPU timing it as well.
+///
+/// Each thread adds its costs into a table of its own behind a lock that only
+/// read() and print() ever contend for. The tables of all threads, including
+/// those that have exited, are merged whenever read() or print() is called.
+///
+/// @warning Only function items added by a site are timed, those of the
+/// GWX_BEGIN, GWX_BEGIN_S, GWX_BEGIN_I, and GWX_BEGIN_P macros. Function items
+/// added by -finstrument-functions, or by a Trace object constructed with a
+/// name alone, have no site and are not timed.
+class Profile
+{
+public:
+   // *
+   // * DECLERATIONS
+   // *
+   /// @brief Costs added up for one tag at one site.
+   struct Cost
+   {
+      /// @brief Number of calls.
+      std::uint64_t calls;
+      /// @brief Time taken by calls, from when each was added to the stack
+      /// until it was removed.
+      std::uint64_t nanoseconds;
+      /// @brief Part of nanoseconds the thread of each call ran on a core, or
+      /// 0 if profiling was started without CPU timing.
+      std::uint64_t cpu;
+      /// @brief Bytes taken by function item names and exceptions.
+      std::uint64_t bytes;
+      /// @brief Number of %Gwers exceptions constructed.
+      std::uint64_t exceptions;
+   };
+   /// @brief Costs of one tag at one site.
+   struct Entry
+   {
+      /// @brief Tag costs were charged to.
+      std::uint32_t tag;
+      /// @brief Site costs were charged to, or nullptr for exceptions
+      /// constructed with no site on the stack.
+      const Site* site;
+      /// @brief Costs added up.
+      Cost cost;
+   };
+   /// @brief Type used for lists of entries.
+   using list = std::vector<Entry>;
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   /// @brief Forgets every cost added so far and turns profiling on.
+   ///
+   /// @param cpu Whether function items are also timed in CPU time of their
+   /// thread.
+   static void start(bool cpu = false);
+   /// @brief Turns profiling off, keeping the costs added so far.
+   static void stop();
+   /// @brief Get whether profiling is on.
+   static bool profiling();
+   /// @brief Get whether profiling was started with CPU timing.
+   static bool timing();
+   /// @brief Get costs added since profiling was last started.
+   ///
+   /// @return Entries of every thread sorted by tag, then by file and line of
+   /// their site.
+   static list read();
+   /// @brief Writes costs added since profiling was last started as text.
+   ///
+   /// @param fd File descriptor the text is written to.
+   ///
+   /// A first line gives the number of entries, then each entry follows on its
+   /// own line with its tag, site, and costs, giving the on-CPU and off-CPU
+   /// time side by side if CPU timing was on.
+   static void print(int fd);
+   /// @brief Get time function items are timed with in nanoseconds.
+   static std::int64_t now();
+   /// @brief Get CPU time of the calling thread in nanoseconds.
+   static std::int64_t cputime();
+   /// @brief Charges calls of a site to a tag.
+   ///
+   /// @param tag Tag of the calling thread.
+   /// @param site Site of the function item.
+   /// @param weight Number of calls the function item stands for.
+   /// @param nanoseconds Time the function item was on the stack.
+   /// @param cpu CPU time the thread used while the function item was on the
+   /// stack, or 0 if it was not timed in CPU time.
+   /// @param bytes Bytes the name of the function item took.
+   ///
+   /// @warning This function should never be called directly by the user. It
+   /// is called by the Trace class.
+   static void charge(std::uint32_t tag, const Site* site, unsigned weight,
+                      std::int64_t nanoseconds, std::int64_t cpu,
+                      std::int64_t bytes);
+   /// @brief Charges exception to a tag.
+   ///
+   /// @param tag Tag of the calling thread.
+   /// @param site Site on top of the stack, or nullptr if there is none.
+   /// @param bytes Bytes of the exception.
+   ///
+   /// @warning This function should never be called directly by the user. It
+   /// is called by the Exception class.
+   static void raise(std::uint32_t tag, const Site* site, std::int64_t bytes);
+private:
+   // *
+   // * DECLERATIONS
+   // *
+   struct Table;
+   struct Handle
+   {
+      ~Handle();
+      Table* table {nullptr};
+      std::uint64_t epoch {0};
+   };
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   static void add(std::uint32_t tag, const Site* site, const Cost& cost);
+   static Table* attach(std::uint64_t epoch);
+   // *
+   // * STATIC VARIABLES
+   // *
+   static std::atomic<bool> _profiling;
+   static std::atomic<bool> _timing;
+   static std::atomic<std::uint64_t> _epoch;
+   static Table _exited;
+   static std::vector<Table*> _tables;
+   thread_local static Handle _handle;
+   thread_local static bool _gone;
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | INLINE/TEMPLATE                                                          |
+// *==========================================================================*
+//
+//
+//
+
+
+
+inline bool Profile::profiling()
+{
+   return _profiling.load(std::memory_order_relaxed);
+}
+
+
+
+inline bool Profile::timing()
+{
+   return _timing.load(std::memory_order_relaxed);
+}
+
+
+
+}
+#endif
@@ -0,0 +1,118 @@
+#include <thread>
+#include <vector>
+#include "unit.hh"
+#include "queue.h"
+namespace unit {
+/// @ingroup utest
+/// @brief Tests the bounded lock free queue.
+///
+/// Tests the bounded lock free queue of many producers and one consumer,
+/// consisting of the Queue class.
+namespace queue {
+
+
+
+/// @brief Used for throwing a unit test failure.
+using fail = UnitTest::Run::Fail;
+
+
+
+/// @brief Unit tests pushing and popping items.
+///
+/// This function unit tests the push(), pop(), and empty() functions of the
+/// Gwers::Queue class. It performs these tests with two unit tests.
+///
+/// -# Fills a queue of four items, making sure a fifth push fails, and that
+/// popping gives the items back in order, after which the queue is empty and
+/// accepts items again around the end of the ring.
+///
+/// -# Has four threads push numbers into a small queue while this thread pops
+/// them, making sure every number arrives exactly once and the numbers of each
+/// thread arrive in the order they were pushed.
+void basic(UnitTest::Run& ut)
+{
+   Gwers::Queue<int,4> q;
+   int item {0};
+   if (!q.empty()||q.pop(item))
+   {
+      throw fail();
+   }
+   for (int i = 0;i<4;++i)
+   {
+      if (!q.push(int(i)))
+      {
+         throw fail();
+      }
+   }
+   if (q.push(4)||q.empty())
+   {
+      throw fail();
+   }
+   for (int i = 0;i<4;++i)
+   {
+      if (!q.pop(item)||item!=i)
+      {
+         throw fail();
+      }
+   }
+   if (!q.empty()||!q.push(5)||!q.pop(item)||item!=5)
+   {
+      throw fail();
+   }
+   ut.next();
+   const int count {100000};
+   static Gwers::Queue<int,64> shared;
+   std::vector<std::thread> threads;
+   for (int t = 0;t<4;++t)
+   {
+      threads.emplace_back([t] {
+         for (int i = 0;i<count;++i)
+         {
+            while (!shared.push(t*count+i))
+            {
+               std::this_thread::yield();
+            }
+         }
+      });
+   }
+   int next[4] {0,0,0,0};
+   bool good {true};
+   for (int total = 0;total<4*count;)
+   {
+      if (shared.pop(item))
+      {
+         int t {item/count};
+         good = good&&item%count==next[t]++;
+         ++total;
+      }
+   }
+   for (auto& i:threads)
+   {
+      i.join();
+   }
+   if (!good)
+   {
+      throw fail();
+   }
+   for (auto i:next)
+   {
+      if (i!=count)
+      {
+         throw fail();
+      }
+   }
+}
+
+
+
+/// @brief Initialize all unit tests for Queue class.
+void init(UnitTest& ut)
+{
+   UnitTest::Run& t = ut.add("Queue",nullptr,nullptr);
+   t.add("basic",basic);
+}
+
+
+
+}
+}
@@ -0,0 +1,157 @@
+#ifndef GWERS_QUEUE_H
+#define GWERS_QUEUE_H
+#include <atomic>
+#include <cstddef>
+#include <utility>
+namespace Gwers {
+
+
+
+/// @ingroup exception
+/// @brief Bounded lock free queue of many producers and one consumer.
+///
+/// @tparam T Type of item queued, which must be default constructible and move
+/// assignable.
+/// @tparam N Number of items the queue holds, which must be a power of two.
+///
+/// This is a fixed ring of cells that each hold an item and a sequence number,
+/// after the bounded queue of Dmitry Vyukov. A producer claims a cell by
+/// advancing the tail with a single compare and swap, moves its item into the
+/// cell, and then publishes it by storing the next sequence number. The one
+/// consumer reads the cell at the head once its sequence number says it was
+/// published, moves the item out, and hands the cell back to producers by
+/// storing the sequence number of the next lap around the ring. Producers never
+/// wait on the consumer or on each other; if the ring is full push() fails at
+/// once and the caller decides what to do with the item.
+///
+/// @warning Only one thread at a time may call pop().
+template<class T, std::size_t N> class Queue
+{
+   static_assert(N>=2&&(N&(N-1))==0,"Queue size must be a power of two.");
+public:
+   // *
+   // * BASIC METHODS
+   // *
+   /// @brief Initializes empty queue.
+   Queue();
+   // *
+   // * COPY METHODS
+   // *
+   Queue(const Queue&) = delete;
+   Queue& operator=(const Queue&) = delete;
+   // *
+   // * FUNCTIONS
+   // *
+   /// @brief Adds item to tail of queue unless it is full.
+   ///
+   /// @param item Item moved into queue if there is room for it.
+   ///
+   /// @return True if the item was added, false if the queue was full.
+   bool push(T&& item);
+   /// @brief Takes item from head of queue unless it is empty.
+   ///
+   /// @param item Item moved out of queue if there was one.
+   ///
+   /// @return True if an item was taken, false if the queue was empty.
+   bool pop(T& item);
+   /// @brief Get whether the queue is empty, as seen by the consumer.
+   bool empty() const;
+private:
+   // *
+   // * DECLERATIONS
+   // *
+   struct Cell
+   {
+      std::atomic<std::size_t> sequence;
+      T item;
+   };
+   // *
+   // * VARIABLES
+   // *
+   Cell _cells[N];
+   alignas(64) std::atomic<std::size_t> _tail {0};
+   alignas(64) std::atomic<std::size_t> _head {0};
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | INLINE/TEMPLATE                                                          |
+// *==========================================================================*
+//
+//
+//
+
+
+
+template<class T, std::size_t N> Queue<T,N>::Queue()
+{
+   for (std::size_t i = 0;i<N;++i)
+   {
+      _cells[i].sequence.store(i,std::memory_order_relaxed);
+   }
+}
+
+
+
+template<class T, std::size_t N> bool Queue<T,N>::push(T&& item)
+{
+   std::size_t pos {_tail.load(std::memory_order_relaxed)};
+   Cell* cell;
+   while (true)
+   {
+      cell = &_cells[pos&(N-1)];
+      std::size_t sequence {cell->sequence.load(std::memory_order_acquire)};
+      auto diff = static_cast<std::ptrdiff_t>(sequence-pos);
+      if (diff==0)
+      {
+         if (_tail.compare_exchange_weak(pos,pos+1,std::memory_order_relaxed))
+         {
+            break;
+         }
+      }
+      else if (diff<0)
+      {
+         return false;
+      }
+      else
+      {
+         pos = _tail.load(std::memory_order_relaxed);
+      }
+   }
+   cell->item = std::move(item);
+   cell->sequence.store(pos+1,std::memory_order_release);
+   return true;
+}
+
+
+
+template<class T, std::size_t N> bool Queue<T,N>::pop(T& item)
+{
+   std::size_t pos {_head.load(std::memory_order_relaxed)};
+   Cell& cell {_cells[pos&(N-1)]};
+   if (cell.sequence.load(std::memory_order_acquire)!=pos+1)
+   {
+      return false;
+   }
+   item = std::move(cell.item);
+   _head.store(pos+1,std::memory_order_relaxed);
+   cell.sequence.store(pos+N,std::memory_order_release);
+   return true;
+}
+
+
+
+template<class T, std::size_t N> bool Queue<T,N>::empty() const
+{
+   std::size_t pos {_head.load(std::memory_order_relaxed)};
+   return _cells[pos&(N-1)].sequence.load(std::memory_order_acquire)!=pos+1;
+}
+
+
+
+}
+#endif
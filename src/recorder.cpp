@@ -0,0 +1,316 @@
+#include "recorder.h"
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "format.h"
+#include "trace.h"
+namespace Gwers {
+
+
+
+struct Recorder::Header
+{
+   char magic[8];
+   std::uint32_t version;
+   std::uint32_t threads;
+   std::uint32_t events;
+   std::uint32_t name_size;
+   std::uint64_t pid;
+   char pad[32];
+};
+
+
+
+struct Recorder::Ring
+{
+   std::atomic<std::uint32_t> owner;
+   std::uint32_t tid;
+   std::atomic<std::uint64_t> head;
+   char pad[48];
+};
+
+
+
+struct Recorder::Slot
+{
+   std::int64_t time;
+   std::uint32_t kind;
+   std::uint32_t depth;
+   char name[name_size];
+};
+
+
+
+namespace
+{
+   constexpr char g_magic[8] {'G','W','X','R','E','C','\0','\0'};
+   constexpr std::uint32_t g_version {1};
+   constexpr std::uint32_t g_depth {65536};
+
+
+
+   std::size_t stride(std::size_t events)
+   {
+      return 64+events*64;
+   }
+}
+
+
+
+std::atomic<bool> Recorder::_recording {false};
+std::atomic<std::uint64_t> Recorder::_epoch {0};
+Recorder::Header* Recorder::_header {nullptr};
+std::size_t Recorder::_size {0};
+thread_local Recorder::Handle Recorder::_handle {};
+
+
+
+Recorder::Handle::~Handle()
+{
+   if (ring&&epoch==_epoch.load(std::memory_order_acquire))
+   {
+      ring->owner.store(0,std::memory_order_release);
+   }
+}
+
+
+
+bool Recorder::open(const char* path, std::size_t threads, std::size_t events)
+{
+   static_assert(sizeof(Header)==64&&sizeof(Ring)==64&&sizeof(Slot)==64,
+                 "Recorder file layout must be in blocks of 64 bytes.");
+   close();
+   if (threads==0||events==0)
+   {
+      return false;
+   }
+   std::size_t size {sizeof(Header)+threads*stride(events)};
+   int fd {::open(path,O_RDWR|O_CREAT|O_TRUNC,0644)};
+   if (fd<0)
+   {
+      return false;
+   }
+   void* map {MAP_FAILED};
+   if (::ftruncate(fd,size)==0)
+   {
+      map = ::mmap(nullptr,size,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+   }
+   ::close(fd);
+   if (map==MAP_FAILED)
+   {
+      return false;
+   }
+   Header* header {static_cast<Header*>(map)};
+   std::memcpy(header->magic,g_magic,sizeof(g_magic));
+   header->version = g_version;
+   header->threads = threads;
+   header->events = events;
+   header->name_size = name_size;
+   header->pid = ::getpid();
+   _header = header;
+   _size = size;
+   _epoch.fetch_add(1,std::memory_order_release);
+   _recording.store(true,std::memory_order_release);
+   return true;
+}
+
+
+
+void Recorder::close()
+{
+   if (_header)
+   {
+      _recording.store(false,std::memory_order_release);
+      _epoch.fetch_add(1,std::memory_order_release);
+      ::munmap(_header,_size);
+      _header = nullptr;
+      _size = 0;
+   }
+}
+
+
+
+Recorder::list Recorder::load(const char* path)
+{
+   list ret;
+   int fd {::open(path,O_RDONLY)};
+   if (fd<0)
+   {
+      return ret;
+   }
+   struct stat st;
+   void* map {MAP_FAILED};
+   if (::fstat(fd,&st)==0&&st.st_size>=static_cast<off_t>(sizeof(Header)))
+   {
+      map = ::mmap(nullptr,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+   }
+   ::close(fd);
+   if (map==MAP_FAILED)
+   {
+      return ret;
+   }
+   const Header& h {*static_cast<const Header*>(map)};
+   const char* base {static_cast<const char*>(map)};
+   std::size_t size {static_cast<std::size_t>(st.st_size)};
+   if (std::memcmp(h.magic,g_magic,sizeof(g_magic))==0&&h.version==g_version&&
+       h.name_size==name_size&&h.events>0&&
+       (size-sizeof(Header))/stride(h.events)>=h.threads)
+   {
+      for (std::uint32_t i = 0;i<h.threads;++i)
+      {
+         const char* r {base+sizeof(Header)+i*stride(h.events)};
+         const Ring& ring {*reinterpret_cast<const Ring*>(r)};
+         const Slot* slots {reinterpret_cast<const Slot*>(r+sizeof(Ring))};
+         std::uint64_t head {ring.head.load(std::memory_order_acquire)};
+         if (head==0)
+         {
+            continue;
+         }
+         Thread t {ring.tid,head,{}};
+         std::uint64_t begin {head>=h.events?head-h.events+1:0};
+         std::vector<std::string> names;
+         for (std::uint64_t j = begin;j<head;++j)
+         {
+            const Slot& s {slots[j%h.events]};
+            if (s.depth>g_depth)
+            {
+               continue;
+            }
+            Event e {static_cast<Kind>(s.kind),s.depth,s.time,
+                     std::string(s.name,strnlen(s.name,name_size))};
+            if (names.size()<=e.depth)
+            {
+               names.resize(e.depth+1);
+            }
+            if (e.kind==Kind::enter)
+            {
+               names[e.depth] = e.name;
+            }
+            else if (e.kind==Kind::leave)
+            {
+               e.name = names[e.depth];
+               names[e.depth].clear();
+            }
+            t.events.push_back(std::move(e));
+         }
+         ret.push_back(std::move(t));
+      }
+   }
+   ::munmap(map,size);
+   return ret;
+}
+
+
+
+void Recorder::print(const list& threads, int fd)
+{
+   Format::Fixed<256> str;
+   for (auto& t:threads)
+   {
+      str.clear();
+      str << "THREAD " << t.tid << " (" << t.total << " events)\n";
+      str.put(fd);
+      for (auto& e:t.events)
+      {
+         str.clear();
+         str << e.time << " ";
+         for (std::uint32_t i = 1;i<e.depth&&i<32;++i)
+         {
+            str << "  ";
+         }
+         switch (e.kind)
+         {
+         case Kind::enter:
+            str << "> ";
+            break;
+         case Kind::leave:
+            str << "< ";
+            break;
+         default:
+            str << "! ";
+            break;
+         }
+         str << e.name << "\n";
+         str.put(fd);
+      }
+   }
+}
+
+
+
+void Recorder::write(Kind kind, std::string_view name)
+{
+   Ring* ring {_handle.ring};
+   if (!ring||_handle.epoch!=_epoch.load(std::memory_order_acquire))
+   {
+      ring = attach();
+      if (!ring)
+      {
+         return;
+      }
+   }
+   std::uint64_t head {ring->head.load(std::memory_order_relaxed)};
+   Slot& s {*slot(ring,head)};
+   std::size_t size {name.size()<name_size?name.size():name_size-1};
+   s.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count();
+   s.kind = static_cast<std::uint32_t>(kind);
+   s.depth = Trace::depth();
+   if (size>0)
+   {
+      std::memcpy(s.name,name.data(),size);
+   }
+   s.name[size] = '\0';
+   ring->head.store(head+1,std::memory_order_release);
+}
+
+
+
+Recorder::Ring* Recorder::attach()
+{
+   std::uint64_t epoch {_epoch.load(std::memory_order_acquire)};
+   if (_handle.epoch==epoch)
+   {
+      return nullptr;
+   }
+   _handle.epoch = epoch;
+   _handle.ring = nullptr;
+   Header* header {_header};
+   if (!header||!_recording.load(std::memory_order_acquire))
+   {
+      return nullptr;
+   }
+   std::uint32_t tid {static_cast<std::uint32_t>(::syscall(SYS_gettid))};
+   char* base {reinterpret_cast<char*>(header)+sizeof(Header)};
+   for (std::uint32_t i = 0;i<header->threads;++i)
+   {
+      Ring* ring {reinterpret_cast<Ring*>(base+i*stride(header->events))};
+      std::uint32_t free {0};
+      if (ring->owner.load(std::memory_order_relaxed)==0&&
+          ring->owner.compare_exchange_strong(free,tid,
+                                              std::memory_order_acquire))
+      {
+         ring->tid = tid;
+         ring->head.store(0,std::memory_order_relaxed);
+         _handle.ring = ring;
+         return ring;
+      }
+   }
+   return nullptr;
+}
+
+
+
+Recorder::Slot* Recorder::slot(Ring* ring, std::uint64_t index)
+{
+   Slot* slots {reinterpret_cast<Slot*>(ring+1)};
+   return slots+index%_header->events;
+}
+
+
+
+}
@@ -0,0 +1,263 @@
+#include <csignal>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "unit.hh"
+#include "exception.h"
+namespace unit {
+/// @ingroup utest
+/// @brief Tests the crash persistent flight recorder.
+///
+/// Tests the recording of trace events into a shared file, consisting of the
+/// Recorder class.
+namespace recorder {
+
+
+
+/// @brief Used for all strings.
+using string = std::string;
+/// @brief Used for throwing a unit test failure.
+using fail = UnitTest::Run::Fail;
+/// @brief Used as shorthand.
+using gwe = Gwers::Exception;
+/// @brief Used as shorthand.
+using gwtr = Gwers::Trace;
+/// @brief Used as shorthand.
+using gwrc = Gwers::Recorder;
+/// @brief Used as shorthand.
+using kind = Gwers::Recorder::Kind;
+
+
+
+/// @brief Internal function that makes a unique path for a recorder file.
+string path(const char* name)
+{
+   return string("/tmp/gwx_")+name+"_"+std::to_string(getpid());
+}
+
+
+
+/// @brief Internal function that finds the thread whose first event has the
+/// given name.
+const gwrc::Thread* find(const gwrc::list& threads, const string& name)
+{
+   for (auto& i:threads)
+   {
+      if (!i.events.empty()&&i.events.front().name==name)
+      {
+         return &i;
+      }
+   }
+   return nullptr;
+}
+
+
+
+/// @brief Internal function that makes sure an event has the given kind,
+/// depth relative to base, and name.
+bool is(const gwrc::Event& e, kind k, std::size_t depth, const string& name)
+{
+   return e.kind==k&&e.depth==depth&&e.name==name;
+}
+
+
+
+/// @brief Unit tests recording and loading events.
+///
+/// This function unit tests the open(), close(), load(), and print() functions
+/// of the Gwers::Recorder class. It performs these tests with three unit
+/// tests.
+///
+/// -# Records nested function items and an exception on this thread and on
+/// another thread, making sure each thread is loaded back from the file with
+/// its own events in order, including the names of removed function items.
+///
+/// -# Records more events than a ring holds, making sure only the last events
+/// are loaded back, leaving out the slot the next event would be written into,
+/// along with the total number recorded, and that a removed function item whose
+/// added event was left out is loaded back without a name.
+///
+/// -# Records nested function items in a child process that then kills itself
+/// with SIGKILL, making sure the events are still loaded back from the file
+/// afterwards and printed with the last function item the child had entered.
+void basic(UnitTest::Run& ut)
+{
+   string file {path("recorder")};
+   std::size_t base {gwtr::depth()};
+   if (!gwrc::open(file.c_str(),4,64)||!gwrc::recording())
+   {
+      throw fail();
+   }
+   {
+      gwtr t1("outer");
+      gwtr t2("inner");
+   }
+   std::thread t([] {
+      try
+      {
+         gwtr t1("other");
+         throw gwe("test_who","test_what",66);
+      }
+      catch (gwe&)
+      {
+         gwtr::flush();
+      }
+   });
+   t.join();
+   gwrc::close();
+   gwrc::list threads {gwrc::load(file.c_str())};
+   const gwrc::Thread* self {find(threads,"outer")};
+   const gwrc::Thread* other {find(threads,"other")};
+   if (gwrc::recording()||threads.size()!=2||!self||!other||
+       self->total!=4||self->events.size()!=4||
+       !is(self->events[0],kind::enter,base+1,"outer")||
+       !is(self->events[1],kind::enter,base+2,"inner")||
+       !is(self->events[2],kind::leave,base+2,"inner")||
+       !is(self->events[3],kind::leave,base+1,"outer")||
+       other->events.size()!=2||
+       !is(other->events[0],kind::enter,1,"other")||
+       !is(other->events[1],kind::raise,1,"test_what")||
+       self->events[0].time>self->events[3].time)
+   {
+      throw fail();
+   }
+   ut.next();
+   if (!gwrc::open(file.c_str(),1,8))
+   {
+      throw fail();
+   }
+   for (int i = 0;i<10;++i)
+   {
+      gwtr t1(std::to_string(i));
+   }
+   gwrc::close();
+   threads = gwrc::load(file.c_str());
+   if (threads.size()!=1||threads[0].total!=20||
+       threads[0].events.size()!=7||
+       !is(threads[0].events[0],kind::leave,base+1,"")||
+       !is(threads[0].events[1],kind::enter,base+1,"7")||
+       !is(threads[0].events[6],kind::leave,base+1,"9"))
+   {
+      throw fail();
+   }
+   ut.next();
+   pid_t pid {fork()};
+   if (pid==0)
+   {
+      gwrc::open(file.c_str());
+      gwtr t1("victim::outer");
+      gwtr t2("victim::inner");
+      raise(SIGKILL);
+      _exit(2);
+   }
+   int status;
+   waitpid(pid,&status,0);
+   threads = gwrc::load(file.c_str());
+   int fds[2];
+   if (pipe(fds)!=0)
+   {
+      throw fail();
+   }
+   gwrc::print(threads,fds[1]);
+   close(fds[1]);
+   string out;
+   char buffer[256];
+   ssize_t n;
+   while ((n = read(fds[0],buffer,sizeof(buffer)))>0)
+   {
+      out.append(buffer,n);
+   }
+   close(fds[0]);
+   unlink(file.c_str());
+   if (!WIFSIGNALED(status)||WTERMSIG(status)!=SIGKILL||threads.size()!=1||
+       threads[0].events.size()!=2||
+       threads[0].events.back().name!="victim::inner"||
+       out.find("> victim::inner\n")==string::npos)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Internal function that overwrites a 32 bit value in a file.
+bool poke(const string& file, off_t offset, std::uint32_t value)
+{
+   int fd {open(file.c_str(),O_WRONLY)};
+   if (fd<0)
+   {
+      return false;
+   }
+   bool ret {pwrite(fd,&value,sizeof(value),offset)==sizeof(value)};
+   close(fd);
+   return ret;
+}
+
+
+
+/// @brief Unit tests loading corrupt files.
+///
+/// This function unit tests the load() function of the Gwers::Recorder class
+/// with files that were damaged after being written. It performs these tests
+/// with two unit tests.
+///
+/// -# Overwrites the depth of the first recorded event with a huge value,
+/// making sure that event is left out and the others are still loaded back,
+/// the removed function item whose added event was left out without a name.
+///
+/// -# Overwrites the number of rings and events of the header with values whose
+/// product overflows, making sure nothing is loaded back.
+void corrupt(UnitTest::Run& ut)
+{
+   string file {path("corrupt")};
+   std::size_t base {gwtr::depth()};
+   if (!gwrc::open(file.c_str(),1,8))
+   {
+      throw fail();
+   }
+   {
+      gwtr t1("first");
+      gwtr t2("second");
+   }
+   gwrc::close();
+   if (!poke(file,64+64+12,0xFFFFFFFF))
+   {
+      unlink(file.c_str());
+      throw fail();
+   }
+   gwrc::list threads {gwrc::load(file.c_str())};
+   if (threads.size()!=1||threads[0].events.size()!=3||
+       !is(threads[0].events[0],kind::enter,base+2,"second")||
+       !is(threads[0].events[1],kind::leave,base+2,"second")||
+       !is(threads[0].events[2],kind::leave,base+1,""))
+   {
+      unlink(file.c_str());
+      throw fail();
+   }
+   ut.next();
+   bool poked {poke(file,12,1u<<27)&&poke(file,16,(1u<<31)-1)};
+   threads = gwrc::load(file.c_str());
+   unlink(file.c_str());
+   if (!poked||!threads.empty())
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Initialize all unit tests for Recorder class.
+void init(UnitTest& ut)
+{
+   UnitTest::Run& t = ut.add("Recorder",nullptr,nullptr);
+   t.add("basic",basic);
+   t.add("corrupt",corrupt);
+}
+
+
+
+}
+}
@@ -0,0 +1,223 @@
+#ifndef GWERS_RECORDER_H
+#define GWERS_RECORDER_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+namespace Gwers {
+
+
+
+/// @ingroup exception
+/// @brief Records recent trace events of every thread into a shared file.
+///
+/// Once open() is called, every function item added to or removed from the
+/// stack of any thread, and every %Gwers exception constructed, is written as
+/// a fixed size event into a ring of events belonging to that thread. All
+/// rings live in one file mapped into memory with MAP_SHARED, so writing an
+/// event is nothing but plain stores into memory; there are no system calls
+/// and no locks. Because the pages belong to the file, the kernel keeps them
+/// even if the process dies in a way no signal handler can see, such as being
+/// killed with SIGKILL or by the out of memory killer, and the last events of
+/// every thread can be read back from the file afterwards with load().
+///
+/// Each event holds the time it happened, its kind, the depth of the stack
+/// and up to name_size-1 characters of the function item or exception name.
+/// A thread takes a free ring the first time it records an event and gives it
+/// back when it exits, so the file holds the events of as many threads as it
+/// has rings at once; threads beyond that record nothing. Each ring keeps the
+/// last events of its thread, overwriting the oldest. An event only counts
+/// once the write index of its ring is advanced past it, and once a ring has
+/// wrapped the slot of the oldest event is not read back either, since it is
+/// the slot the next event is written into, so an event torn by the death of
+/// the process is never read back. A ring of N events therefore gives back at
+/// most N-1 of them.
+///
+/// @warning The file is laid out in the byte order and alignment of the
+/// machine that wrote it, so it should be read on the same kind of machine.
+/// close() must only be called while no other thread is tracing.
+class Recorder
+{
+public:
+   // *
+   // * DECLERATIONS
+   // *
+   /// @brief Kinds of events.
+   enum class Kind: std::uint32_t
+   {
+      enter, ///< Function item added to stack.
+      leave, ///< Function item removed from stack.
+      raise ///< %Gwers exception constructed.
+   };
+   /// @brief A single event read back from a file.
+   struct Event
+   {
+      /// @brief Kind of event.
+      Kind kind;
+      /// @brief Depth of the stack after a function item was added, before it
+      /// was removed, or when an exception was constructed.
+      std::uint32_t depth;
+      /// @brief Nanoseconds since the epoch of the system clock.
+      std::int64_t time;
+      /// @brief Name of function item or exception, possibly cut off.
+      std::string name;
+   };
+   /// @brief The last events of a single thread read back from a file.
+   struct Thread
+   {
+      /// @brief Id of the thread given by the kernel.
+      std::uint32_t tid;
+      /// @brief Number of events the thread recorded, including those that
+      /// were overwritten.
+      std::uint64_t total;
+      /// @brief Events still held, oldest first.
+      std::vector<Event> events;
+   };
+   /// @brief Type used for the threads of a file.
+   using list = std::vector<Thread>;
+   // *
+   // * CONSTANTS
+   // *
+   /// @brief Size of the name held by each event, including the null
+   /// character.
+   static constexpr std::size_t name_size {48};
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   /// @brief Creates file and starts recording into it.
+   ///
+   /// @param path Path of the file, which is replaced if it exists.
+   /// @param threads Number of rings, which is how many threads can record at
+   /// once.
+   /// @param events Number of events each ring holds.
+   ///
+   /// @return True if the file was created and mapped, false otherwise.
+   static bool open(const char* path, std::size_t threads = 64,
+                    std::size_t events = 1024);
+   /// @brief Stops recording and unmaps file, keeping it on disk.
+   static void close();
+   /// @brief Get whether recording is on.
+   static bool recording();
+   /// @brief Reads back the last events of every thread from a file.
+   ///
+   /// @param path Path of the file written by open().
+   ///
+   /// @return Every thread that recorded at least one event, or an empty list
+   /// if the file cannot be read or is not a recorder file.
+   ///
+   /// A file whose header claims more rings than the file holds is not read,
+   /// and an event deeper than 65536 function items, which can only come from
+   /// a torn or corrupt file, is left out.
+   static list load(const char* path);
+   /// @brief Writes the last events of every thread as text.
+   ///
+   /// @param threads Threads read back with load().
+   /// @param fd File descriptor the text is written to.
+   ///
+   /// Each thread is written as its id followed by one line per event, with
+   /// added function items indented by their depth, so the last lines of each
+   /// thread show what it was doing when the process died.
+   static void print(const list& threads, int fd);
+   /// @brief Records function item added to stack.
+   ///
+   /// @param name Name of function item.
+   ///
+   /// @warning This function should never be called directly by the user. It
+   /// is called by the Trace class.
+   static void enter(std::string_view name);
+   /// @brief Records function item about to be removed from stack.
+   ///
+   /// @warning This function should never be called directly by the user. It
+   /// is called by the Trace class.
+   static void leave();
+   /// @brief Records %Gwers exception constructed.
+   ///
+   /// @param name Name of exception type.
+   ///
+   /// @warning This function should never be called directly by the user. It
+   /// is called by the Exception class.
+   static void raise(std::string_view name);
+private:
+   // *
+   // * DECLERATIONS
+   // *
+   struct Header;
+   struct Ring;
+   struct Slot;
+   struct Handle
+   {
+      ~Handle();
+      Ring* ring {nullptr};
+      std::uint64_t epoch {0};
+   };
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   static void write(Kind kind, std::string_view name);
+   static Ring* attach();
+   static Slot* slot(Ring* ring, std::uint64_t index);
+   // *
+   // * STATIC VARIABLES
+   // *
+   static std::atomic<bool> _recording;
+   static std::atomic<std::uint64_t> _epoch;
+   static Header* _header;
+   static std::size_t _size;
+   thread_local static Handle _handle;
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | INLINE/TEMPLATE                                                          |
+// *==========================================================================*
+//
+//
+//
+
+
+
+inline bool Recorder::recording()
+{
+   return _recording.load(std::memory_order_relaxed);
+}
+
+
+
+inline void Recorder::enter(std::string_view name)
+{
+   if (recording())
+   {
+      write(Kind::enter,name);
+   }
+}
+
+
+
+inline void Recorder::leave()
+{
+   if (recording())
+   {
+      write(Kind::leave,std::string_view());
+   }
+}
+
+
+
+inline void Recorder::raise(std::string_view name)
+{
+   if (recording())
+   {
+      write(Kind::raise,name);
+   }
+}
+
+
+
+}
+#endif
@@ -0,0 +1,116 @@
+#include <thread>
+#include <vector>
+#include "unit.hh"
+#include "recycler.h"
+namespace unit {
+/// @ingroup utest
+/// @brief Tests lock free buffer recycling.
+///
+/// Tests the lock free buffer recycling, consisting of the Recycler class.
+namespace recycler {
+
+
+
+/// @brief Used for throwing a unit test failure.
+using fail = UnitTest::Run::Fail;
+
+
+
+/// @brief Internal variable counting live Buffer objects.
+std::atomic<int> alive;
+
+
+
+/// @brief Internal buffer type that counts how many of itself are alive.
+struct Buffer
+{
+   Buffer() { ++alive; }
+   ~Buffer() { --alive; }
+   std::atomic<bool> used {false};
+};
+
+
+
+/// @brief Unit tests acquiring and releasing buffers.
+///
+/// This function unit tests the acquire(), release(), and size() functions of
+/// the Gwers::Recycler class. It performs these tests with three unit tests.
+///
+/// -# Acquires a buffer from an empty recycler, making sure a new one is
+/// allocated, then releases it and makes sure the same buffer is given back by
+/// the next acquire.
+///
+/// -# Releases more buffers than the recycler has slots, making sure the
+/// recycler keeps exactly as many as it has slots and deletes the rest.
+///
+/// -# Has many threads acquire and release buffers at the same time, making
+/// sure no buffer is ever handed to two threads at once and none are lost.
+void basic(UnitTest::Run& ut)
+{
+   static Gwers::Recycler<Buffer,4> r;
+   alive = 0;
+   Buffer* b {r.acquire()};
+   if (alive!=1||r.size()!=0)
+   {
+      throw fail();
+   }
+   r.release(b);
+   if (r.size()!=1||r.acquire()!=b||r.size()!=0)
+   {
+      throw fail();
+   }
+   ut.next();
+   std::vector<Buffer*> list {b};
+   for (int i = 0;i<5;++i)
+   {
+      list.push_back(r.acquire());
+   }
+   for (auto i:list)
+   {
+      r.release(i);
+   }
+   if (r.size()!=4||alive!=4)
+   {
+      throw fail();
+   }
+   ut.next();
+   std::atomic<bool> good {true};
+   std::vector<std::thread> threads;
+   for (int i = 0;i<8;++i)
+   {
+      threads.emplace_back([&good] {
+         for (int j = 0;j<10000;++j)
+         {
+            Buffer* b {r.acquire()};
+            if (b->used.exchange(true))
+            {
+               good = false;
+            }
+            b->used.store(false);
+            r.release(b);
+         }
+      });
+   }
+   for (auto& i:threads)
+   {
+      i.join();
+   }
+   if (!good||r.size()>4||alive!=int(r.size()))
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Initialize all unit tests for Recycler class.
+void init(UnitTest& ut)
+{
+   UnitTest::Run& t = ut.add("Recycler",nullptr,nullptr);
+   t.add("basic",basic);
+}
+
+
+
+}
+}
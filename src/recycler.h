@@ -0,0 +1,119 @@
+#ifndef GWERS_RECYCLER_H
+#define GWERS_RECYCLER_H
+#include <atomic>
+#include <cstddef>
+namespace Gwers {
+
+
+
+/// @ingroup exception
+/// @brief Lock free free list of per-thread buffers.
+///
+/// @tparam T Type of buffer being recycled, which must be default
+/// constructible.
+/// @tparam N Maximum number of buffers kept on the free list.
+///
+/// This keeps buffers that were released by threads that have exited so that
+/// threads started later can take them instead of allocating and growing new
+/// buffers from nothing. The free list is a fixed array of slots that each hold
+/// a pointer to a buffer or nullptr. Taking a buffer exchanges a full slot with
+/// nullptr and returning one swaps it into an empty slot, so the free list is
+/// lock free and can never suffer from the ABA problem. If no buffer is free, a
+/// new one is allocated; if every slot is full, the buffer returned is deleted.
+///
+/// Objects of this class have no constructor or destructor that runs code, so a
+/// recycler with static storage duration is initialized before any thread uses
+/// it and is never destroyed while threads may still be exiting. Buffers left
+/// on the free list when the program exits are not freed.
+///
+/// @warning Buffers are given back as they were released; clearing a buffer
+/// before releasing it is the responsibility of the user of this class.
+template<class T, std::size_t N> class Recycler
+{
+public:
+   // *
+   // * FUNCTIONS
+   // *
+   /// @brief Takes a buffer from the free list or allocates a new one.
+   ///
+   /// @return Buffer owned by the caller until it is released.
+   T* acquire();
+   /// @brief Returns a buffer to the free list or deletes it if full.
+   ///
+   /// @param buffer Buffer that was returned by acquire().
+   void release(T* buffer);
+   /// @brief Get number of buffers currently on the free list.
+   std::size_t size() const;
+private:
+   // *
+   // * VARIABLES
+   // *
+   std::atomic<T*> _slots[N];
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | INLINE/TEMPLATE                                                          |
+// *==========================================================================*
+//
+//
+//
+
+
+
+template<class T, std::size_t N> T* Recycler<T,N>::acquire()
+{
+   for (auto& i:_slots)
+   {
+      if (i.load(std::memory_order_relaxed))
+      {
+         T* ret {i.exchange(nullptr,std::memory_order_acquire)};
+         if (ret)
+         {
+            return ret;
+         }
+      }
+   }
+   return new T;
+}
+
+
+
+template<class T, std::size_t N> void Recycler<T,N>::release(T* buffer)
+{
+   for (auto& i:_slots)
+   {
+      T* empty {nullptr};
+      if (!i.load(std::memory_order_relaxed)&&
+          i.compare_exchange_strong(empty,buffer,std::memory_order_release,
+                                    std::memory_order_relaxed))
+      {
+         return;
+      }
+   }
+   delete buffer;
+}
+
+
+
+template<class T, std::size_t N> std::size_t Recycler<T,N>::size() const
+{
+   std::size_t ret {0};
+   for (auto& i:_slots)
+   {
+      if (i.load(std::memory_order_relaxed))
+      {
+         ++ret;
+      }
+   }
+   return ret;
+}
+
+
+
+}
+#endif
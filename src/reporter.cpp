@@ -0,0 +1,160 @@
+#include "reporter.h"
+namespace Gwers {
+
+
+
+std::atomic<Reporter*> Reporter::_current {nullptr};
+
+
+
+Reporter::Reporter(int fd, std::chrono::milliseconds interval):
+   _fd {fd},
+   _interval {interval},
+   _thread {&Reporter::run,this},
+   _previous {_current.exchange(this)}
+{}
+
+
+
+Reporter::~Reporter()
+{
+   Reporter* self {this};
+   _current.compare_exchange_strong(self,_previous);
+   {
+      std::lock_guard<std::mutex> lock {_mutex};
+      _stop = true;
+   }
+   _wake.notify_all();
+   _thread.join();
+}
+
+
+
+bool Reporter::push()
+{
+   Record r {record()};
+   if (r.capture.empty())
+   {
+      return false;
+   }
+   if (!_queue.push(std::move(r)))
+   {
+      _dropped.fetch_add(1,std::memory_order_relaxed);
+      return false;
+   }
+   _pushed.fetch_add(1,std::memory_order_release);
+   return true;
+}
+
+
+
+void Reporter::flush()
+{
+   std::uint64_t target {_pushed.load(std::memory_order_acquire)};
+   std::unique_lock<std::mutex> lock {_mutex};
+   _flush = true;
+   _wake.notify_all();
+   _done.wait(lock,[this,target] {
+      return _reported.load(std::memory_order_relaxed)>=target;
+   });
+}
+
+
+
+void Reporter::handler(Exception::Type, Exception*, std::exception*)
+{
+   Reporter* r {_current.load()};
+   if (r)
+   {
+      r->push();
+   }
+   else
+   {
+      write(2,record());
+   }
+}
+
+
+
+void Reporter::write(int fd, const Record& r)
+{
+   Format::Fixed<512> str;
+   switch (r.type)
+   {
+   case Exception::Type::gwers:
+   {
+      const Exception& e {*r.capture.gwers()};
+      str << "Gwers: " << e.who() << ":" << e.what() << " line " << e.line();
+      if (!e.context().empty())
+      {
+         str << "\nCONTEXT: " << e.context();
+      }
+      break;
+   }
+   case Exception::Type::std:
+      str << "std::exception: " << r.capture.standard()->what();
+      break;
+   default:
+      str << "unknown exception";
+      break;
+   }
+   str << "\n";
+   if (r.site)
+   {
+      str << "SITE: " << r.site->file() << ":" << r.site->line() << "\n";
+   }
+   str << "TRACE:\n";
+   str.put(fd);
+   for (auto& i:r.capture.trace())
+   {
+      str.clear();
+      str << i << "\n";
+      str.put(fd);
+   }
+}
+
+
+
+void Reporter::run()
+{
+   Record r;
+   std::unique_lock<std::mutex> lock {_mutex};
+   while (true)
+   {
+      _wake.wait_for(lock,_interval,[this] { return _stop||_flush; });
+      bool stop {_stop};
+      _flush = false;
+      lock.unlock();
+      while (_queue.pop(r))
+      {
+         write(_fd,r);
+         r = Record();
+         _reported.fetch_add(1,std::memory_order_relaxed);
+      }
+      lock.lock();
+      _done.notify_all();
+      if (stop)
+      {
+         break;
+      }
+   }
+}
+
+
+
+Reporter::Record Reporter::record()
+{
+   Record ret;
+   if (Trace::locked()&&Trace::depth()>0)
+   {
+      auto i = Trace::end();
+      ret.site = (--i).site();
+   }
+   ret.capture = Capture::current();
+   ret.type = ret.capture.type();
+   return ret;
+}
+
+
+
+}
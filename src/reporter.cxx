@@ -0,0 +1,131 @@
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include "unit.hh"
+#include "reporter.h"
+namespace unit {
+/// @ingroup utest
+/// @brief Tests asynchronous exception reporting.
+///
+/// Tests the reporting of caught exceptions on a thread of its own, consisting
+/// of the Reporter class.
+namespace reporter {
+
+
+
+/// @brief Used for all strings.
+using string = std::string;
+/// @brief Used for throwing a unit test failure.
+using fail = UnitTest::Run::Fail;
+/// @brief Used as shorthand.
+using gwe = Gwers::Exception;
+/// @brief Used as shorthand.
+using gwtr = Gwers::Trace;
+/// @brief Used as shorthand.
+using gwrp = Gwers::Reporter;
+
+
+
+/// @brief Internal base function that throws a %Gwers exception.
+void throw_gwers()
+{
+   gwtr t1("unit::reporter::outer");
+   gwtr t2("unit::reporter::inner");
+   throw gwe("test_who","test_what",66);
+}
+
+
+
+/// @brief Internal base function that throws a standard exception.
+void throw_std()
+{
+   throw std::runtime_error("test_std");
+}
+
+
+
+/// @brief Internal function that reads everything written to a pipe.
+string drain(int fd)
+{
+   string ret;
+   char buffer[4096];
+   ssize_t n;
+   while ((n = ::read(fd,buffer,sizeof(buffer)))>0)
+   {
+      ret.append(buffer,n);
+   }
+   return ret;
+}
+
+
+
+/// @brief Unit tests reporting and dropping exceptions.
+///
+/// This function unit tests the Gwers::Reporter class. It performs these tests
+/// with two unit tests.
+///
+/// -# Reports a %Gwers and a standard exception through base_catch() with the
+/// reporter handler, making sure both are written by the reporter thread to a
+/// pipe with their information and the function stack of the %Gwers exception.
+///
+/// -# Reports more exceptions than the queue holds to a reporter that only
+/// wakes up once a minute, making sure the excess is counted as dropped and
+/// every exception is either written or dropped.
+void basic(UnitTest::Run& ut)
+{
+   int fds[2];
+   if (::pipe(fds)!=0)
+   {
+      throw fail();
+   }
+   ::fcntl(fds[0],F_SETFL,O_NONBLOCK);
+   {
+      gwrp r(fds[1]);
+      gwe::base_catch(throw_gwers,gwrp::handler);
+      gwe::base_catch(throw_std,gwrp::handler);
+      gwtr::flush();
+      r.flush();
+      string out {drain(fds[0])};
+      if (r.reported()!=2||r.dropped()!=0||
+          out.find("Gwers: test_who:test_what line 66\n")==string::npos||
+          out.find("unit::reporter::outer\nunit::reporter::inner\n")==
+          string::npos||
+          out.find("std::exception: test_std\n")==string::npos)
+      {
+         throw fail();
+      }
+   }
+   ::close(fds[0]);
+   ::close(fds[1]);
+   ut.next();
+   int null {::open("/dev/null",O_WRONLY)};
+   const std::size_t count {gwrp::capacity+100};
+   {
+      gwrp r(null,std::chrono::minutes(1));
+      for (std::size_t i = 0;i<count;++i)
+      {
+         gwe::base_catch(throw_gwers,gwrp::handler);
+      }
+      gwtr::flush();
+      r.flush();
+      if (r.dropped()!=count-gwrp::capacity||r.reported()!=gwrp::capacity)
+      {
+         throw fail();
+      }
+   }
+   ::close(null);
+}
+
+
+
+/// @brief Initialize all unit tests for Reporter class.
+void init(UnitTest& ut)
+{
+   UnitTest::Run& t = ut.add("Reporter",nullptr,nullptr);
+   t.add("basic",basic);
+}
+
+
+
+}
+}
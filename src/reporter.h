@@ -0,0 +1,161 @@
+#ifndef GWERS_REPORTER_H
+#define GWERS_REPORTER_H
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include "capture.h"
+#include "queue.h"
+namespace Gwers {
+
+
+
+/// @ingroup exception
+/// @brief Reports caught exceptions on a thread of its own.
+///
+/// This takes the formatting and writing of caught exceptions off the threads
+/// that caught them. A thread reporting an exception only captures it, along
+/// with the site of the function item it was thrown in, and pushes that record
+/// onto a bounded lock free queue. A reporter thread running in the background
+/// wakes up once every interval, takes every record off the queue, and writes
+/// each one to a file descriptor in the same form as Exception::dump(). If the
+/// queue is full the record is thrown away and counted as dropped, so reporting
+/// an exception never waits on the reporter thread or on any input or output.
+///
+/// The static function handler() matches Exception::efp, so it can be given
+/// directly to Exception::base_catch() to report every exception that reaches
+/// the base of a thread. It reports to the reporter most recently constructed,
+/// or writes the exception at once on the calling thread if there is none.
+///
+/// @warning Only one reporter should exist at a time.
+class Reporter
+{
+public:
+   // *
+   // * DECLERATIONS
+   // *
+   /// @brief A caught exception waiting to be written.
+   struct Record
+   {
+      /// @brief Type of exception.
+      Exception::Type type {Exception::Type::unknown};
+      /// @brief Site of the function item the exception was thrown in, or
+      /// nullptr if not known.
+      const Site* site {nullptr};
+      /// @brief The exception and its function stack.
+      Capture capture;
+   };
+   // *
+   // * CONSTANTS
+   // *
+   /// @brief Number of records the queue holds.
+   static constexpr std::size_t capacity {1024};
+   // *
+   // * BASIC METHODS
+   // *
+   /// @brief Starts reporter thread and makes this the current reporter.
+   ///
+   /// @param fd File descriptor reports are written to.
+   /// @param interval Time between each time the reporter thread empties the
+   /// queue.
+   Reporter(int fd = 2,
+            std::chrono::milliseconds interval = std::chrono::milliseconds(10));
+   /// @brief Writes every record left on the queue and stops reporter thread.
+   ~Reporter();
+   // *
+   // * COPY METHODS
+   // *
+   Reporter(const Reporter&) = delete;
+   Reporter& operator=(const Reporter&) = delete;
+   // *
+   // * FUNCTIONS
+   // *
+   /// @brief Queues the exception currently being handled.
+   ///
+   /// This must be called from within a catch block.
+   ///
+   /// @return True if the exception was queued, false if it was dropped because
+   /// the queue was full or no exception is being handled.
+   bool push();
+   /// @brief Waits until every record queued before this call is written.
+   void flush();
+   /// @brief Get number of records written.
+   std::uint64_t reported() const;
+   /// @brief Get number of records dropped because the queue was full.
+   std::uint64_t dropped() const;
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   /// @brief Reports the exception currently being handled to the current
+   /// reporter.
+   ///
+   /// This must be called from within a catch block. See Exception::efp.
+   static void handler(Exception::Type t, Exception* e, std::exception* std);
+   /// @brief Writes record to file descriptor.
+   ///
+   /// @param fd File descriptor record is written to.
+   /// @param r Record to write.
+   static void write(int fd, const Record& r);
+private:
+   // *
+   // * FUNCTIONS
+   // *
+   void run();
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   static Record record();
+   // *
+   // * VARIABLES
+   // *
+   int _fd;
+   std::chrono::milliseconds _interval;
+   Queue<Record,capacity> _queue;
+   std::atomic<std::uint64_t> _pushed {0};
+   std::atomic<std::uint64_t> _reported {0};
+   std::atomic<std::uint64_t> _dropped {0};
+   std::mutex _mutex;
+   std::condition_variable _wake;
+   std::condition_variable _done;
+   bool _stop {false};
+   bool _flush {false};
+   std::thread _thread;
+   Reporter* _previous;
+   // *
+   // * STATIC VARIABLES
+   // *
+   static std::atomic<Reporter*> _current;
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | INLINE/TEMPLATE                                                          |
+// *==========================================================================*
+//
+//
+//
+
+
+
+inline std::uint64_t Reporter::reported() const
+{
+   return _reported.load(std::memory_order_relaxed);
+}
+
+
+
+inline std::uint64_t Reporter::dropped() const
+{
+   return _dropped.load(std::memory_order_relaxed);
+}
+
+
+
+}
+#endif
@@ -0,0 +1,149 @@
+#include "request.h"
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include "trace.h"
+namespace Gwers {
+
+
+
+namespace
+{
+   std::mutex g_mutex;
+   Request::list g_kept;
+   std::size_t g_overflow {0};
+}
+
+
+
+Recycler<Request::Scratch,64> Request::_scratches;
+thread_local Request::Handle Request::_handle {};
+thread_local Request* Request::_current {nullptr};
+
+
+
+Request::Handle::~Handle()
+{
+   if (scratch)
+   {
+      scratch->count = 0;
+      scratch->used = 0;
+      scratch->dropped = 0;
+      _scratches.release(scratch);
+   }
+}
+
+
+
+Request::Request(std::string_view name, nanoseconds threshold):
+   _name(name),
+   _threshold {threshold},
+   _parent {_current},
+   _uncaught {std::uncaught_exceptions()}
+{
+   if (!_handle.scratch)
+   {
+      _handle.scratch = _scratches.acquire();
+   }
+   _scratch = _handle.scratch;
+   _count = _scratch->count;
+   _used = _scratch->used;
+   _dropped = _scratch->dropped;
+   _current = this;
+   _start = clock::now();
+}
+
+
+
+Request::~Request()
+{
+   nanoseconds latency {clock::now()-_start};
+   bool failed {_failed||
+                (std::uncaught_exceptions()>_uncaught&&Trace::locked())};
+   bool kept {failed||latency>=_threshold};
+   if (kept)
+   {
+      keep(latency,failed);
+   }
+   if (!kept||!_parent)
+   {
+      _scratch->count = _count;
+      _scratch->used = _used;
+      _scratch->dropped = _dropped;
+   }
+   _current = _parent;
+}
+
+
+
+Request::list Request::drain()
+{
+   list ret;
+   std::lock_guard<std::mutex> lock {g_mutex};
+   ret.swap(g_kept);
+   return ret;
+}
+
+
+
+std::size_t Request::overflow()
+{
+   std::lock_guard<std::mutex> lock {g_mutex};
+   return g_overflow;
+}
+
+
+
+void Request::write(bool enter, std::string_view name)
+{
+   Scratch& s {*_scratch};
+   if (s.count==events||name.size()>bytes-s.used)
+   {
+      ++s.dropped;
+      return;
+   }
+   Entry& e {s.entries[s.count++]};
+   e.offset = static_cast<std::uint32_t>(s.used);
+   e.size = static_cast<std::uint32_t>(name.size());
+   e.time = clock::now().time_since_epoch().count();
+   e.enter = enter;
+   if (!name.empty())
+   {
+      std::memcpy(s.text+s.used,name.data(),name.size());
+      s.used += name.size();
+   }
+}
+
+
+
+void Request::keep(nanoseconds latency, bool failed)
+{
+   {
+      std::lock_guard<std::mutex> lock {g_mutex};
+      if (g_kept.size()>=capacity)
+      {
+         ++g_overflow;
+         return;
+      }
+   }
+   Record r {_name,latency,failed,{},_scratch->dropped-_dropped};
+   r.events.reserve(_scratch->count-_count);
+   for (std::size_t i = _count;i<_scratch->count;++i)
+   {
+      const Entry& e {_scratch->entries[i]};
+      auto time = std::chrono::duration_cast<nanoseconds>(
+                     clock::time_point(clock::duration(e.time))-_start);
+      r.events.push_back({e.enter,string(_scratch->text+e.offset,e.size),time});
+   }
+   std::lock_guard<std::mutex> lock {g_mutex};
+   if (g_kept.size()>=capacity)
+   {
+      ++g_overflow;
+      return;
+   }
+   g_kept.push_back(std::move(r));
+}
+
+
+
+}
@@ -0,0 +1,179 @@
+#include <thread>
+#include "unit.hh"
+#include "exception.h"
+#include "request.h"
+namespace unit {
+/// @ingroup utest
+/// @brief Tests tail based request capture.
+///
+/// Tests the capture of function stacks of slow or failed requests, consisting
+/// of the Request class.
+namespace request {
+
+
+
+/// @brief Used for throwing a unit test failure.
+using fail = UnitTest::Run::Fail;
+/// @brief Used as shorthand.
+using gwe = Gwers::Exception;
+/// @brief Used as shorthand.
+using gwtr = Gwers::Trace;
+/// @brief Used as shorthand.
+using gwr = Gwers::Request;
+/// @brief Used for all time durations.
+using ms = std::chrono::milliseconds;
+
+
+
+/// @brief Internal function that makes sure a record holds exactly the events
+/// of entering and leaving an outer and inner function item.
+bool nested(const gwr::Record& r)
+{
+   const auto& e = r.events;
+   return e.size()==4&&e[0].enter&&e[0].name=="outer"&&e[1].enter&&
+          e[1].name=="inner"&&!e[2].enter&&!e[3].enter&&
+          e[0].time<=e[1].time&&e[1].time<=e[2].time&&
+          e[2].time<=e[3].time&&e[3].time<=r.latency&&r.dropped==0;
+}
+
+
+
+/// @brief Unit tests keeping and throwing away requests.
+///
+/// This function unit tests the Gwers::Request class. It performs these tests
+/// with four unit tests.
+///
+/// -# Runs a request far under its threshold, making sure it is thrown away.
+///
+/// -# Runs a request that sleeps past its threshold, making sure it is kept
+/// with the events of entering and leaving its function items in order.
+///
+/// -# Throws a %Gwers exception through a fast request, making sure it is kept
+/// and marked as failed with the function items it had entered.
+///
+/// -# Runs a fast request nested inside a slow one, making sure only the outer
+/// request is kept, and that an explicitly failed fast request is kept.
+void basic(UnitTest::Run& ut)
+{
+   gwr::drain();
+   {
+      gwr r("fast",ms(1000));
+      gwtr t1("outer");
+      gwtr t2("inner");
+   }
+   if (!gwr::drain().empty())
+   {
+      throw fail();
+   }
+   ut.next();
+   {
+      gwr r("slow",ms(5));
+      gwtr t1("outer");
+      gwtr t2("inner");
+      std::this_thread::sleep_for(ms(10));
+   }
+   auto kept = gwr::drain();
+   if (kept.size()!=1||kept[0].name!="slow"||kept[0].failed||
+       kept[0].latency<ms(5)||!nested(kept[0]))
+   {
+      throw fail();
+   }
+   ut.next();
+   try
+   {
+      gwr r("throw",ms(1000));
+      gwtr t1("outer");
+      gwtr t2("inner");
+      throw gwe("test_who","test_what",66);
+   }
+   catch (gwe&)
+   {
+      gwtr::flush();
+   }
+   kept = gwr::drain();
+   if (kept.size()!=1||kept[0].name!="throw"||!kept[0].failed||
+       !nested(kept[0]))
+   {
+      throw fail();
+   }
+   ut.next();
+   {
+      gwr outer("outer",ms(5));
+      {
+         gwr inner("inner",ms(1000));
+         gwtr t1("skipped");
+      }
+      {
+         gwr inner("failed",ms(1000));
+         inner.fail();
+      }
+      gwtr t1("outer");
+      gwtr t2("inner");
+      std::this_thread::sleep_for(ms(10));
+   }
+   kept = gwr::drain();
+   if (kept.size()!=2||kept[0].name!="failed"||!kept[0].failed||
+       !kept[0].events.empty()||kept[1].name!="outer"||!nested(kept[1]))
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Unit tests events of nested requests.
+///
+/// This function unit tests which events of inner requests the outer request
+/// keeps. It performs these tests with two unit tests.
+///
+/// -# Runs a slow request around a fast inner request that is thrown away and a
+/// failed inner request that is kept, each adding one function item, making
+/// sure only the failed inner request is kept on its own with its events.
+///
+/// -# Makes sure the outer request kept the events of the failed inner request
+/// and not those of the inner request that was thrown away.
+void nest(UnitTest::Run& ut)
+{
+   gwr::drain();
+   {
+      gwr outer("outer",ms(5));
+      {
+         gwr inner("inner",ms(1000));
+         gwtr t("skipped");
+      }
+      {
+         gwr inner("failed",ms(1000));
+         gwtr t("kept");
+         inner.fail();
+      }
+      std::this_thread::sleep_for(ms(10));
+   }
+   auto kept = gwr::drain();
+   if (kept.size()!=2||kept[0].name!="failed"||kept[0].events.size()!=2||
+       kept[0].events[0].name!="kept"||kept[1].name!="outer")
+   {
+      throw fail();
+   }
+   ut.next();
+   const auto& e = kept[1].events;
+   if (e.size()!=2||!e[0].enter||e[0].name!="kept"||e[1].enter||
+       kept[1].dropped!=0)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Initialize all unit tests for Request class.
+void init(UnitTest& ut)
+{
+   UnitTest::Run& t = ut.add("Request",nullptr,nullptr);
+   t.add("basic",basic);
+   t.add("nest",nest);
+}
+
+
+
+}
+}
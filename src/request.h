@@ -0,0 +1,224 @@
+#ifndef GWERS_REQUEST_H
+#define GWERS_REQUEST_H
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "recycler.h"
+namespace Gwers {
+
+
+
+/// @ingroup exception
+/// @brief Captures the trace of one request, keeping it only if it was slow or
+/// failed.
+///
+/// An object of this class is a scope around the handling of one request on
+/// one thread. While it exists, every function item added to or removed from
+/// the stack of that thread by a GWX_BEGIN macro is also written as an event
+/// into a scratch area of the thread, with the time since the request began.
+/// When the object is destroyed, the events are kept only if the request took
+/// at least its latency threshold, failed was called, or the scope is being
+/// left because a %Gwers exception was thrown through it. Otherwise they are
+/// thrown away by moving the end of the scratch area back to where the request
+/// began, which takes the same time no matter how many events were written.
+/// Kept requests are copied out of the scratch area into a process wide list,
+/// which is taken with drain().
+///
+/// Requests can be nested on the same thread, each inner request writing its
+/// events after those of the outer request and deciding on its own whether
+/// they are kept. Events of an inner request that is kept are left in the
+/// scratch area, so the outer request keeps them as well if it is kept, while
+/// events of an inner request that is thrown away are also thrown away for the
+/// outer request. The scratch area of each thread holds a
+/// fixed number of events and bytes of function names; events that do not fit
+/// are counted as dropped. Scratch areas are taken from a lock free free list
+/// when a thread first begins a request, and given back when the thread exits.
+///
+/// @warning Objects of this class must be destroyed on the thread that
+/// constructed them, in the reverse order they were constructed.
+class Request
+{
+public:
+   // *
+   // * DECLERATIONS
+   // *
+   /// @brief Used for all strings.
+   using string = std::string;
+   /// @brief Used for all time durations.
+   using nanoseconds = std::chrono::nanoseconds;
+   /// @brief A function item added to or removed from the stack.
+   struct Event
+   {
+      /// @brief True if the function item was added, false if removed.
+      bool enter;
+      /// @brief Name of the function item if it was added.
+      string name;
+      /// @brief Time since the request began.
+      nanoseconds time;
+   };
+   /// @brief A request that was kept.
+   struct Record
+   {
+      /// @brief Name given to the request.
+      string name;
+      /// @brief Time the request took.
+      nanoseconds latency;
+      /// @brief True if the request failed.
+      bool failed;
+      /// @brief Events of the request in the order they happened.
+      std::vector<Event> events;
+      /// @brief Number of events that did not fit in the scratch area.
+      std::size_t dropped;
+   };
+   /// @brief Type used for lists of kept requests.
+   using list = std::vector<Record>;
+   // *
+   // * CONSTANTS
+   // *
+   /// @brief Number of events the scratch area of each thread holds.
+   static constexpr std::size_t events {4096};
+   /// @brief Number of bytes of function names the scratch area of each thread
+   /// holds.
+   static constexpr std::size_t bytes {65536};
+   /// @brief Number of kept requests held until drained, beyond which new ones
+   /// are thrown away.
+   static constexpr std::size_t capacity {256};
+   // *
+   // * BASIC METHODS
+   // *
+   /// @brief Begins request on the calling thread.
+   ///
+   /// @param name Name of the request, such as its kind or id.
+   /// @param threshold Latency at or above which the request is kept.
+   Request(std::string_view name, nanoseconds threshold);
+   /// @brief Ends request, keeping or throwing away its events.
+   ~Request();
+   // *
+   // * COPY METHODS
+   // *
+   Request(const Request&) = delete;
+   Request& operator=(const Request&) = delete;
+   // *
+   // * FUNCTIONS
+   // *
+   /// @brief Marks request as failed so it is kept.
+   void fail();
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   /// @brief Takes all kept requests.
+   ///
+   /// @return List of all requests kept since the last call, oldest first.
+   static list drain();
+   /// @brief Get number of kept requests thrown away because the list of kept
+   /// requests was full.
+   static std::size_t overflow();
+   /// @brief Writes event of function item added to stack.
+   ///
+   /// @param name Name of function item.
+   ///
+   /// @warning This function should never be called directly by the user. It
+   /// is called by the Trace class.
+   static void enter(std::string_view name);
+   /// @brief Writes event of function item removed from stack.
+   ///
+   /// @warning This function should never be called directly by the user. It
+   /// is called by the Trace class.
+   static void leave();
+private:
+   // *
+   // * DECLERATIONS
+   // *
+   using clock = std::chrono::steady_clock;
+   struct Entry
+   {
+      std::uint32_t offset;
+      std::uint32_t size;
+      std::int64_t time;
+      bool enter;
+   };
+   struct Scratch
+   {
+      Entry entries[events];
+      char text[bytes];
+      std::size_t count {0};
+      std::size_t used {0};
+      std::size_t dropped {0};
+   };
+   struct Handle
+   {
+      ~Handle();
+      Scratch* scratch {nullptr};
+   };
+   // *
+   // * FUNCTIONS
+   // *
+   void write(bool enter, std::string_view name);
+   void keep(nanoseconds latency, bool failed);
+   // *
+   // * VARIABLES
+   // *
+   string _name;
+   nanoseconds _threshold;
+   clock::time_point _start;
+   Request* _parent;
+   Scratch* _scratch;
+   std::size_t _count;
+   std::size_t _used;
+   std::size_t _dropped;
+   int _uncaught;
+   bool _failed {false};
+   // *
+   // * STATIC VARIABLES
+   // *
+   static Recycler<Scratch,64> _scratches;
+   thread_local static Handle _handle;
+   thread_local static Request* _current;
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | INLINE/TEMPLATE                                                          |
+// *==========================================================================*
+//
+//
+//
+
+
+
+inline void Request::fail()
+{
+   _failed = true;
+}
+
+
+
+inline void Request::enter(std::string_view name)
+{
+   if (_current)
+   {
+      _current->write(true,name);
+   }
+}
+
+
+
+inline void Request::leave()
+{
+   if (_current)
+   {
+      _current->write(false,std::string_view());
+   }
+}
+
+
+
+}
+#endif
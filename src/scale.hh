@@ -0,0 +1,19 @@
+#ifndef SCALE_HH
+#define SCALE_HH
+#include "sweep.hh"
+
+
+/// @brief Scalability sweeps for entire code base.
+///
+/// This encompasses all scalability code which is not part of the library
+/// itself. All scalability code for the entire code base is part of this name
+/// space.
+namespace scale {
+namespace key { void init(Sweep&); }
+namespace metrics { void init(Sweep&); }
+namespace trace { void init(Sweep&); }
+}
+
+
+
+#endif
@@ -0,0 +1,58 @@
+#include "site.h"
+#include <algorithm>
+#include <cstring>
+extern "C" {
+extern Gwers::Site* __start_gwx_sites[] __attribute__((weak));
+extern Gwers::Site* __stop_gwx_sites[] __attribute__((weak));
+}
+namespace Gwers {
+
+
+
+std::atomic<Site*> Site::_head {nullptr};
+
+
+
+Site::list Site::all()
+{
+   list ret;
+   if (__start_gwx_sites)
+   {
+      ret.assign(__start_gwx_sites,__stop_gwx_sites);
+   }
+   for (Site* i = _head.load(std::memory_order_acquire);i;i = i->_next)
+   {
+      ret.push_back(i);
+   }
+   std::sort(ret.begin(),ret.end(),[](const Site* a, const Site* b) {
+      int c {std::strcmp(a->_file,b->_file)};
+      if (c!=0)
+      {
+         return c<0;
+      }
+      return a->_line!=b->_line?a->_line<b->_line:a<b;
+   });
+   ret.erase(std::unique(ret.begin(),ret.end()),ret.end());
+   return ret;
+}
+
+
+
+void Site::join(Site* site)
+{
+   if (site->_enrolled.exchange(true))
+   {
+      return;
+   }
+   Site* head {_head.load(std::memory_order_relaxed)};
+   do
+   {
+      site->_next = head;
+   }
+   while (!_head.compare_exchange_weak(head,site,std::memory_order_release,
+                                       std::memory_order_relaxed));
+}
+
+
+
+}
@@ -0,0 +1,197 @@
+#include <cstring>
+#include <thread>
+#include "unit.hh"
+#include "trace.h"
+namespace unit {
+/// @ingroup utest
+/// @brief Tests sites of trace macros.
+///
+/// Tests the sites of the GWX_BEGIN macros and their sampling, consisting of
+/// the Site class.
+namespace site {
+
+
+
+/// @brief Used for throwing a unit test failure.
+using fail = UnitTest::Run::Fail;
+/// @brief Used as shorthand.
+using gws = Gwers::Site;
+/// @brief Used as shorthand.
+using gwtr = Gwers::Trace;
+
+
+
+/// @brief Internal variable holding line number of site in sampled().
+int line {0};
+
+
+
+/// @brief Internal function traced once every four calls.
+///
+/// @return Weight of the function item added, or 0 if none was added.
+unsigned sampled()
+{
+   std::size_t depth {gwtr::depth()};
+   GWX_BEGIN_S(4,"unit::site::sampled()"); line = __LINE__;
+   if (gwtr::depth()==depth)
+   {
+      return 0;
+   }
+   auto i = gwtr::end();
+   return (--i).weight();
+}
+
+
+
+/// @brief Internal function traced on every call.
+void every()
+{
+   GWX_BEGIN("unit::site::every()");
+}
+
+
+
+/// @brief Internal function that is never called.
+void never()
+{
+   GWX_BEGIN("unit::site::never()");
+}
+
+
+
+/// @brief Internal function that finds a site by the name of its function.
+gws* find(const char* function)
+{
+   for (auto i:gws::all())
+   {
+      if (std::strcmp(i->function(),function)==0)
+      {
+         return i;
+      }
+   }
+   return nullptr;
+}
+
+
+
+/// @brief Unit tests sampling and the list of all sites.
+///
+/// This function unit tests the sampling of calls by the GWX_BEGIN_S macro and
+/// the all() and set_rate() functions of the Gwers::Site class. It performs
+/// these tests with three unit tests.
+///
+/// -# Calls a function sampled once every four calls eight times, making sure
+/// only the first and fifth calls add a function item and both have a weight
+/// of four.
+///
+/// -# Finds the site of the sampled function and of a function that is never
+/// called in the list of all sites, making sure both are there with the right
+/// file and line.
+///
+/// -# Sets the rate of the site of the sampled function to 1 through the list
+/// of all sites, making sure every call then adds a function item with a
+/// weight of 1.
+void basic(UnitTest::Run& ut)
+{
+   unsigned weights[8];
+   for (auto& i:weights)
+   {
+      i = sampled();
+   }
+   if (weights[0]!=4||weights[1]!=0||weights[2]!=0||weights[3]!=0||
+       weights[4]!=4||weights[5]!=0||weights[6]!=0||weights[7]!=0)
+   {
+      throw fail();
+   }
+   ut.next();
+   gws* s {find("unit::site::sampled()")};
+   gws* n {find("unit::site::never()")};
+   if (!s||!n||s->line()!=line||s->rate()!=4||
+       std::strstr(s->file(),"site.cxx")==nullptr||
+       std::strcmp(n->file(),s->file())!=0||n->line()<=line)
+   {
+      throw fail();
+   }
+   ut.next();
+   s->set_rate(1);
+   for (int i = 0;i<8;++i)
+   {
+      if (sampled()!=1)
+      {
+         throw fail();
+      }
+   }
+   s->set_rate(4);
+}
+
+
+
+/// @brief Unit tests the countdown and count of calls of each thread.
+///
+/// This function unit tests the sample() and calls() functions of the
+/// Gwers::Site class. It performs these tests with two unit tests.
+///
+/// -# Calls a function sampled once every four calls three times, then calls
+/// it once on a new thread, making sure that call is traced since the new
+/// thread starts its own countdown.
+///
+/// -# Calls a function traced on every call one time less than flush_calls on
+/// a new thread and then flush_calls times on another, making sure the count of
+/// its site is unchanged by the first thread and grows by flush_calls with the
+/// second.
+void local(UnitTest::Run& ut)
+{
+   for (int i = 0;i<3;++i)
+   {
+      sampled();
+   }
+   unsigned weight {0};
+   std::thread t([&weight] { weight = sampled(); });
+   t.join();
+   if (weight!=4)
+   {
+      throw fail();
+   }
+   ut.next();
+   every();
+   gws* s {find("unit::site::every()")};
+   if (!s)
+   {
+      throw fail();
+   }
+   std::uint64_t before {s->calls()};
+   std::thread few([] {
+      for (unsigned i = 1;i<gws::flush_calls;++i)
+      {
+         every();
+      }
+   });
+   few.join();
+   std::uint64_t middle {s->calls()};
+   std::thread many([] {
+      for (unsigned i = 0;i<gws::flush_calls;++i)
+      {
+         every();
+      }
+   });
+   many.join();
+   if (middle!=before||s->calls()!=before+gws::flush_calls)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Initialize all unit tests for Site class.
+void init(UnitTest& ut)
+{
+   UnitTest::Run& t = ut.add("Site",nullptr,nullptr);
+   t.add("basic",basic);
+   t.add("local",local);
+}
+
+
+
+}
+}
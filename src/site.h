@@ -0,0 +1,359 @@
+#ifndef GWERS_SITE_H
+#define GWERS_SITE_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "coverage.h"
+#include "memory.h"
+#if defined(__PIC__)&&!defined(__PIE__)
+#define GWX__ENROLL(S) S.enroll();
+#else
+#define GWX__ENROLL(S) __asm__ volatile(".pushsection gwx_sites,\"aw\"\n"\
+                                        ".balign %c1\n"\
+                                        ".dc.a %c0\n"\
+                                        ".popsection"\
+                                        ::"i"(&S),"i"(sizeof(void*)));
+#endif
+namespace Gwers {
+
+
+
+/// @ingroup exception
+/// @brief A single place in the source code that adds function items.
+///
+/// Every GWX_BEGIN macro, and every variant of it, declares one static object
+/// of this class for the place it is written. It holds where that place is in
+/// the source code and how often calls passing through it are traced. All
+/// sites of the program can be listed at runtime through all(), including the
+/// ones that have never been reached, which is how settings are changed for a
+/// single site without rebuilding.
+///
+/// A site traces only one of every N calls passing through it, N being its
+/// sampling rate. The rate is given to GWX_BEGIN_S(N,F,...) and can be changed
+/// at any time with set_rate(); a rate of 0 or 1 traces every call, which is
+/// what GWX_BEGIN does. Each thread counts down the calls of a site on its own,
+/// in a thread local variable the GWX_BEGIN macro declares next to the site,
+/// so a call that is not traced costs only a decrement of memory the thread
+/// owns, and the rate holds exactly for each thread however many threads pass
+/// through the site. Changing the rate or level of a site restarts the
+/// countdown of every thread. Each function item added by a sampled call
+/// records the rate it was sampled at as its weight, the number of calls it
+/// stands for, so anything that adds up function items can account for the
+/// calls that were skipped.
+///
+/// Each site also has a level of detail, which is full unless lowered with
+/// set_level(), usually by a Governor. At the full level a traced call adds
+/// the function name with all argument values, at the name level it adds only
+/// the function name, at the sampled level it adds only the function name and
+/// traces at most one of every sampled_rate calls, and at the off level it adds
+/// nothing. Every site counts the calls passing through it, adding the weight
+/// of each call that ends its countdown, so the count is only an estimate but
+/// costs nothing for calls that are not traced. A site that is off still
+/// counts its calls this way, at a rate of one of every off_rate calls. Each
+/// thread adds these weights up on its own as well, and only adds them to the
+/// count of the site once they reach flush_calls, so even at a rate of 1 a call
+/// stores nothing to the site itself. The count therefore lags behind by up to
+/// flush_calls calls for each thread, and the calls a thread has not added yet
+/// when it exits are lost. A
+/// budget set with Memory::set_budget() can hold every site below its own
+/// level while tracing holds too much memory; level() still returns the level
+/// the site was set to.
+///
+/// While coverage is on, every call through a site also marks the site as
+/// reached by the calling thread, whatever its rate or level; see Coverage.
+///
+/// The list of all sites is built by each GWX_BEGIN macro writing the address
+/// of its site into the gwx_sites section of the object file, which the linker
+/// gathers into one array for the whole program. Code compiled as position
+/// independent code for a shared library cannot do this, so there a site is
+/// only added to the list the first time it is reached.
+///
+/// @warning Objects of this class should never be declared directly by the
+/// user, instead use the GWX_BEGIN macros.
+class alignas(64) Site
+{
+public:
+   // *
+   // * DECLERATIONS
+   // *
+   /// @brief Type used for lists of sites.
+   using list = std::vector<Site*>;
+   /// @brief Countdown of the calls of a site by a single thread.
+   ///
+   /// @warning Objects of this struct should never be declared directly by the
+   /// user. The GWX_BEGIN macros declare one thread local object of it next to
+   /// each site.
+   struct Local
+   {
+      /// @brief Calls left until the next call that is traced.
+      unsigned count {0};
+      /// @brief Generation of the site the countdown was started at.
+      unsigned generation {0};
+      /// @brief Weights of calls not yet added to the count of the site.
+      unsigned pending {0};
+   };
+   /// @brief Levels of detail of function items added by a site.
+   enum class Level: int
+   {
+      off,
+      sampled,
+      name,
+      full
+   };
+   // *
+   // * CONSTANTS
+   // *
+   /// @brief Lowest sampling rate at the sampled level.
+   static constexpr unsigned sampled_rate {64};
+   /// @brief Rate at which calls are counted at the off level.
+   static constexpr unsigned off_rate {1024};
+   /// @brief Number of calls a thread adds up before adding them to the count
+   /// of a site.
+   static constexpr unsigned flush_calls {64};
+   // *
+   // * BASIC METHODS
+   // *
+   /// @brief Initializes site.
+   ///
+   /// @param file Name of the source file of the site.
+   /// @param line Line number of the site.
+   /// @param function Name of the function the site is in.
+   /// @param rate Initial sampling rate.
+   constexpr Site(const char* file, int line, const char* function,
+                  unsigned rate);
+   // *
+   // * COPY METHODS
+   // *
+   Site(const Site&) = delete;
+   Site& operator=(const Site&) = delete;
+   // *
+   // * FUNCTIONS
+   // *
+   /// @brief Get name of source file of this site.
+   const char* file() const;
+   /// @brief Get line number of this site.
+   int line() const;
+   /// @brief Get name of function this site is in.
+   const char* function() const;
+   /// @brief Get sampling rate of this site.
+   unsigned rate() const;
+   /// @brief Sets sampling rate of this site.
+   ///
+   /// @param rate New sampling rate, tracing one of every rate calls. A rate of
+   /// 0 or 1 traces every call.
+   void set_rate(unsigned rate);
+   /// @brief Get level of detail of this site.
+   Level level() const;
+   /// @brief Sets level of detail of this site.
+   ///
+   /// @param level New level of detail.
+   void set_level(Level level);
+   /// @brief Get number of calls a traced call through this site stands for
+   /// at its current rate and level.
+   unsigned weight() const;
+   /// @brief Get estimated number of calls that have passed through this site.
+   std::uint64_t calls() const;
+   /// @brief Decides if and how the current call through this site is traced.
+   ///
+   /// @param local Countdown of this site for the calling thread.
+   ///
+   /// @return 0 if the call is not traced, 1 if only the function name is
+   /// added, or 2 if the function name and all argument values are added.
+   int sample(Local& local);
+   /// @brief Adds this site to the list of all sites if it is not already.
+   ///
+   /// @warning This function should never be called directly by the user. It
+   /// is called by the GWX_BEGIN macros in position independent code for
+   /// shared libraries.
+   void enroll();
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   /// @brief Get list of all sites of the program.
+   ///
+   /// @return List of all sites, sorted by file name and line number.
+   static list all();
+private:
+   friend class Coverage;
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   static void join(Site* site);
+   // *
+   // * FUNCTIONS
+   // *
+   Level effective() const;
+   // *
+   // * VARIABLES
+   // *
+   const char* _file;
+   const int _line;
+   const char* _function;
+   std::atomic<unsigned> _rate;
+   std::atomic<unsigned> _generation {1};
+   std::atomic<Level> _level {Level::full};
+   std::atomic<std::uint64_t> _calls {0};
+   std::atomic<bool> _enrolled {false};
+   std::atomic<std::uint32_t> _index {0};
+   Site* _next {nullptr};
+   // *
+   // * STATIC VARIABLES
+   // *
+   static std::atomic<Site*> _head;
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | INLINE/TEMPLATE                                                          |
+// *==========================================================================*
+//
+//
+//
+
+
+
+constexpr Site::Site(const char* file, int line, const char* function,
+                     unsigned rate):
+   _file {file},
+   _line {line},
+   _function {function},
+   _rate {rate}
+{}
+
+
+
+inline const char* Site::file() const
+{
+   return _file;
+}
+
+
+
+inline int Site::line() const
+{
+   return _line;
+}
+
+
+
+inline const char* Site::function() const
+{
+   return _function;
+}
+
+
+
+inline unsigned Site::rate() const
+{
+   unsigned ret {_rate.load(std::memory_order_relaxed)};
+   return ret?ret:1;
+}
+
+
+
+inline void Site::set_rate(unsigned rate)
+{
+   _rate.store(rate,std::memory_order_relaxed);
+   _generation.fetch_add(1,std::memory_order_relaxed);
+}
+
+
+
+inline Site::Level Site::level() const
+{
+   return _level.load(std::memory_order_relaxed);
+}
+
+
+
+inline void Site::set_level(Level level)
+{
+   _level.store(level,std::memory_order_relaxed);
+   _generation.fetch_add(1,std::memory_order_relaxed);
+}
+
+
+
+inline unsigned Site::weight() const
+{
+   unsigned ret {rate()};
+   switch (effective())
+   {
+   case Level::off:
+      return off_rate;
+   case Level::sampled:
+      return ret>sampled_rate?ret:sampled_rate;
+   default:
+      return ret;
+   }
+}
+
+
+
+inline std::uint64_t Site::calls() const
+{
+   return _calls.load(std::memory_order_relaxed);
+}
+
+
+
+inline int Site::sample(Local& local)
+{
+   if (Coverage::covering())
+   {
+      Coverage::hit(this);
+   }
+   unsigned generation {_generation.load(std::memory_order_relaxed)};
+   if (local.count>1&&local.generation==generation)
+   {
+      --local.count;
+      return 0;
+   }
+   unsigned weight {this->weight()};
+   local.count = weight;
+   local.generation = generation;
+   local.pending += weight;
+   if (local.pending>=flush_calls)
+   {
+      _calls.fetch_add(local.pending,std::memory_order_relaxed);
+      local.pending = 0;
+   }
+   switch (effective())
+   {
+   case Level::off:
+      return 0;
+   case Level::full:
+      return 2;
+   default:
+      return 1;
+   }
+}
+
+
+
+inline Site::Level Site::effective() const
+{
+   Level ret {level()};
+   Level allowed {static_cast<Level>(Memory::allowed())};
+   return allowed<ret?allowed:ret;
+}
+
+
+
+inline void Site::enroll()
+{
+   if (!_enrolled.load(std::memory_order_relaxed))
+   {
+      join(this);
+   }
+}
+
+
+
+}
+#endif
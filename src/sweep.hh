@@ -0,0 +1,267 @@
+#ifndef SWEEP_HH
+#define SWEEP_HH
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+
+/// @defgroup stest Scalability
+/// @brief Framework where all scalability sweeps and supporting classes reside.
+///
+/// A benchmark timed on a single thread cannot show two threads fighting over
+/// the same cache line, so anything in the library that keeps state shared by
+/// threads is also measured here on more and more threads at once. Sweeps are
+/// divided into their own namespaces based off the name of the class or
+/// hierarchy being measured, and those namespaces are encompassed into another
+/// namespace called scale. The sweeps are built into their own program,
+/// separate from the unit tests and benchmarks, with the scale target.
+///
+/// All sweeps are ran through a single instance of the Sweep class, adding
+/// workloads to it and then executing all workloads that were added. Every
+/// scalability namespace will have a function called init(Sweep&) which will
+/// add all of its workloads to the Sweep object. A workload function is given
+/// a number of iterations to run, just like a benchmarking function, and must
+/// be safe to call from many threads at once.
+///
+/// Each workload is ran on 1, 2, 4, and so on up to the largest number of
+/// threads, each thread pinned to its own processor in turn. Every thread calls
+/// the workload over and over in batches for the same length of time, timing
+/// each batch. For each number of threads this prints the number of
+/// iterations done per second by all threads together, the 50th, 90th and 99th
+/// percentiles of the time of one iteration over all batches of all threads,
+/// and the efficiency, which is the throughput divided by the number of
+/// threads times the throughput of one thread. A workload that scales
+/// perfectly keeps an efficiency of 100%, while one bouncing a shared cache
+/// line between processors falls quickly as threads are added.
+///
+/// Each thread keeps its timings in its own locals while it is measured and
+/// only hands them over once it is done, so the sweep shares no cache line
+/// between threads of its own. The sweeps and the library objects they link
+/// are both compiled with optimizations, so what is measured is the sharing
+/// in the library rather than unoptimized code.
+
+
+
+/// @ingroup stest
+/// @brief Stores a list of Sweep::Run objects that will be measured.
+///
+/// This stores a list of Sweep::Run objects, each one coinciding with the
+/// namespace of a separate collection of workloads. Objects can only be added,
+/// not removed. Once all objects are added, they can be executed.
+class Sweep
+{
+public:
+   // *
+   // * DECLERATIONS
+   // *
+   class Run;
+   /// @brief Used for all strings.
+   using string = std::string;
+   /// @brief Used for workload functions.
+   using wfp = void(*)(std::size_t);
+   /// @brief The measurements of one workload on one number of threads.
+   struct Result
+   {
+      /// @brief Number of threads.
+      std::size_t threads;
+      /// @brief Iterations per second by all threads together.
+      double rate;
+      /// @brief 50th percentile of nanoseconds per iteration.
+      double p50;
+      /// @brief 90th percentile of nanoseconds per iteration.
+      double p90;
+      /// @brief 99th percentile of nanoseconds per iteration.
+      double p99;
+      /// @brief Rate divided by threads times the rate of one thread.
+      double efficiency;
+   };
+   // *
+   // * BASIC METHODS
+   // *
+   /// @brief Initializes sweep settings.
+   ///
+   /// @param threads Largest number of threads, which is always measured even
+   /// if it is not a power of 2.
+   /// @param duration Time each number of threads is measured for.
+   /// @param csv File every result is also written to as comma separated
+   /// values, or nullptr for none.
+   Sweep(std::size_t threads, std::chrono::milliseconds duration,
+         std::FILE* csv);
+   // *
+   // * COPY METHODS
+   // *
+   Sweep(const Sweep&) = delete;
+   Sweep& operator=(const Sweep&) = delete;
+   // *
+   // * MOVE METHODS
+   // *
+   Sweep(Sweep&&) = delete;
+   Sweep& operator=(Sweep&&) = delete;
+   // *
+   // * FUNCTIONS
+   // *
+   /// @brief Creates a new Sweep::Run object and returns a reference.
+   ///
+   /// @param name The name for this sweep object that is the namespace of the
+   /// collected workloads.
+   ///
+   /// @return The new Sweep::Run object that was just created.
+   Run& add(const string& name);
+   /// @brief Executes all stored Sweep::Run objects.
+   void execute();
+   /// @brief Measures a single workload on every number of threads.
+   ///
+   /// @param workload Workload function to measure.
+   ///
+   /// @return One result for each number of threads measured.
+   std::vector<Result> measure(wfp workload) const;
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   /// @brief Prevents the compiler from optimizing away a value.
+   ///
+   /// @param p Pointer to value that must be treated as used.
+   static void keep(const void* p);
+private:
+   // *
+   // * DECLERATIONS
+   // *
+   using list = std::vector<Run>;
+   // *
+   // * FUNCTIONS
+   // *
+   Result measure(wfp workload, std::size_t threads, std::size_t batch) const;
+   // *
+   // * VARIABLES
+   // *
+   std::size_t _threads;
+   std::chrono::milliseconds _duration;
+   std::FILE* _csv;
+   std::vector<int> _cpus;
+   list _runs;
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | RUN                                                                      |
+// *==========================================================================*
+//
+//
+//
+
+
+
+/// @brief Stores a list of workload function pointers that will be measured.
+///
+/// This stores a list of name and function pointer pairs. Each function runs
+/// the code being measured the number of iterations it is given.
+///
+/// @warning The execution of these objects are not meant to be called directly,
+/// it is called through the main Sweep object's execution task.
+class Sweep::Run
+{
+public:
+   // *
+   // * DECLERATIONS
+   // *
+   /// @brief Used for all strings.
+   using string = Sweep::string;
+   /// @brief Used for workload functions.
+   using wfp = Sweep::wfp;
+   // *
+   // * BASIC METHODS
+   // *
+   /// @brief Initializes object with empty workload list.
+   ///
+   /// @param name The namespace for all workloads added to this object.
+   Run(const string& name);
+   // *
+   // * COPY METHODS
+   // *
+   Run(const Run&) = delete;
+   Run& operator=(const Run&) = delete;
+   // *
+   // * MOVE METHODS
+   // *
+   /// @brief Default move constructor.
+   Run(Run&&) = default;
+   /// @brief Default move operator.
+   Run& operator=(Run&&) = default;
+   // *
+   // * FUNCTIONS
+   // *
+   /// @brief Add a new workload function.
+   ///
+   /// @param name Name for specific workload.
+   /// @param workload Pointer to workload function.
+   void add(const string& name, wfp workload);
+   /// @brief Run list of all workloads, printing the results of each.
+   ///
+   /// @param sweep Sweep object holding settings.
+   /// @param csv File results are also written to, or nullptr for none.
+   void execute(const Sweep& sweep, std::FILE* csv);
+private:
+   // *
+   // * DECLERATIONS
+   // *
+   using list = std::vector<std::pair<string,wfp>>;
+   // *
+   // * VARIABLES
+   // *
+   string _name;
+   list _workloads;
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | INLINE/TEMPLATE                                                          |
+// *==========================================================================*
+//
+//
+//
+
+
+
+inline void Sweep::keep(const void* p)
+{
+   asm volatile("" : : "g"(p) : "memory");
+}
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | RUN INLINE/TEMPLATE                                                      |
+// *==========================================================================*
+//
+//
+//
+
+
+
+inline Sweep::Run::Run(const string& name):
+   _name {name}
+{}
+
+
+
+inline void Sweep::Run::add(const string& name, wfp workload)
+{
+   _workloads.emplace_back(name,workload);
+}
+
+
+
+#endif
@@ -0,0 +1,164 @@
+#include <atomic>
+#include <thread>
+#include "unit.hh"
+#include "capture.h"
+#include "threadpool.h"
+#include "trace.h"
+namespace unit {
+/// @ingroup utest
+/// @brief Tests tags of threads.
+///
+/// Tests the tags naming who a thread is working for and how they follow work
+/// handed to other threads, consisting of the Tag class.
+namespace tag {
+GWX_DECLARE(unit::tag)
+GWX_EXCEPTION(Failed)
+
+
+
+/// @brief Used for throwing a unit test failure.
+using fail = UnitTest::Run::Fail;
+/// @brief Used for calling %Gwers exceptions.
+using gwe = Gwers::Exception;
+/// @brief Used as shorthand.
+using gwtg = Gwers::Tag;
+
+
+
+/// @brief Internal function that is used as the pool exception handler.
+void handler(gwe::Type, gwe*, std::exception*)
+{}
+
+
+
+/// @brief Unit tests scopes.
+///
+/// This function unit tests the constructor, destructor, current(), and set()
+/// functions of the Gwers::Tag class. It performs these tests with two unit
+/// tests.
+///
+/// -# Nests two tags, making sure the inner one is current while it exists and
+/// the outer one is put back once it is destroyed, and that the tag is back to
+/// what it was once both are destroyed.
+///
+/// -# Sets a tag without a scope, making sure it is current on this thread only
+/// and that a new thread starts with the tag 0.
+void scope(UnitTest::Run& ut)
+{
+   std::uint32_t before {gwtg::current()};
+   {
+      gwtg outer(7);
+      {
+         gwtg inner(8);
+         if (gwtg::current()!=8)
+         {
+            throw fail();
+         }
+      }
+      if (gwtg::current()!=7)
+      {
+         throw fail();
+      }
+   }
+   if (gwtg::current()!=before)
+   {
+      throw fail();
+   }
+   ut.next();
+   gwtg::set(9);
+   std::uint32_t other {1};
+   std::thread t([&other] { other = gwtg::current(); });
+   t.join();
+   bool current {gwtg::current()==9};
+   gwtg::set(before);
+   if (!current||other!=0)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Unit tests tags following work.
+///
+/// This function unit tests the tags kept by the Gwers::ThreadPool,
+/// Gwers::Capture, and Gwers::Exception classes. It performs these tests with
+/// three unit tests.
+///
+/// -# Submits tasks to a pool under two different tags, making sure each task
+/// runs under the tag it was submitted under and that the workers are back to
+/// the tag 0 once the tasks are done.
+///
+/// -# Throws an exception under a tag and catches it under another, making sure
+/// the exception keeps the tag it was thrown under.
+///
+/// -# Captures an exception under a tag, making sure the capture keeps it.
+void follow(UnitTest::Run& ut)
+{
+   std::atomic<std::uint32_t> first {0};
+   std::atomic<std::uint32_t> second {0};
+   std::atomic<std::uint32_t> after {1};
+   {
+      Gwers::ThreadPool p(1,handler);
+      {
+         gwtg t(11);
+         p.submit([&first] { first = gwtg::current(); });
+      }
+      {
+         gwtg t(12);
+         p.submit([&second] { second = gwtg::current(); });
+      }
+      p.wait();
+      p.submit([&after] { after = gwtg::current(); });
+   }
+   if (first!=11||second!=12||after!=0)
+   {
+      throw fail();
+   }
+   ut.next();
+   try
+   {
+      gwtg t(13);
+      throw Failed(__LINE__);
+   }
+   catch (gwe& e)
+   {
+      gwtg t(14);
+      if (e.tag()!=13)
+      {
+         throw fail();
+      }
+   }
+   Gwers::Trace::flush();
+   ut.next();
+   Gwers::Capture c;
+   try
+   {
+      throw Failed(__LINE__);
+   }
+   catch (...)
+   {
+      gwtg t(15);
+      c = Gwers::Capture::current();
+   }
+   Gwers::Trace::flush();
+   if (c.tag()!=15)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Initialize all unit tests for Tag class.
+void init(UnitTest& ut)
+{
+   UnitTest::Run& t = ut.add("Tag",nullptr,nullptr);
+   t.add("scope",scope);
+   t.add("follow",follow);
+}
+
+
+
+}
+}
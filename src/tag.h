@@ -0,0 +1,107 @@
+#ifndef GWERS_TAG_H
+#define GWERS_TAG_H
+#include <cstdint>
+namespace Gwers {
+
+
+
+/// @ingroup exception
+/// @brief Small integer naming who the work of a thread is being done for.
+///
+/// An object of this class is a scope that sets the tag of the calling thread,
+/// such as the id of a tenant or request, for as long as it exists, and puts
+/// back the tag the thread had before once it is destroyed. Tags are read by
+/// Profile, which adds up time and bytes per tag and site, and by every
+/// %Gwers exception, which keeps the tag it was constructed under. Setting a
+/// tag is a single store to a thread local variable, and reading it a single
+/// load, so a tag can be set for every request a service handles.
+///
+/// A task submitted to a ThreadPool runs under the tag of the thread that
+/// submitted it, and a Capture keeps the tag of the thread that captured it,
+/// so tags follow work that is handed from one thread to another. A thread
+/// that never set a tag has the tag 0.
+///
+/// @warning Objects of this class must be destroyed on the thread that
+/// constructed them, in the reverse order they were constructed.
+class Tag
+{
+public:
+   // *
+   // * BASIC METHODS
+   // *
+   /// @brief Sets tag of the calling thread.
+   ///
+   /// @param tag New tag.
+   explicit Tag(std::uint32_t tag);
+   /// @brief Puts back tag the calling thread had before.
+   ~Tag();
+   // *
+   // * COPY METHODS
+   // *
+   Tag(const Tag&) = delete;
+   Tag& operator=(const Tag&) = delete;
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   /// @brief Get tag of the calling thread.
+   static std::uint32_t current();
+   /// @brief Sets tag of the calling thread without a scope.
+   ///
+   /// @param tag New tag.
+   static void set(std::uint32_t tag);
+private:
+   // *
+   // * VARIABLES
+   // *
+   const std::uint32_t _previous;
+   // *
+   // * STATIC VARIABLES
+   // *
+   inline thread_local static std::uint32_t _current {0};
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | INLINE/TEMPLATE                                                          |
+// *==========================================================================*
+//
+//
+//
+
+
+
+inline Tag::Tag(std::uint32_t tag):
+   _previous {_current}
+{
+   _current = tag;
+}
+
+
+
+inline Tag::~Tag()
+{
+   _current = _previous;
+}
+
+
+
+inline std::uint32_t Tag::current()
+{
+   return _current;
+}
+
+
+
+inline void Tag::set(std::uint32_t tag)
+{
+   _current = tag;
+}
+
+
+
+}
+#endif
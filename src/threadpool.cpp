@@ -0,0 +1,326 @@
+#include "threadpool.h"
+namespace Gwers {
+
+
+
+thread_local ThreadPool* ThreadPool::_current {nullptr};
+thread_local unsigned int ThreadPool::_index {0};
+thread_local ThreadPool::Task* ThreadPool::_task {nullptr};
+
+
+
+ThreadPool::ThreadPool(unsigned int size, efp handler):
+   _handler {handler}
+{
+   if (size==0)
+   {
+      size = std::thread::hardware_concurrency();
+      if (size==0)
+      {
+         size = 1;
+      }
+   }
+   for (unsigned int i = 0;i<size;++i)
+   {
+      _deques.push_back(new Deque);
+   }
+   for (unsigned int i = 0;i<size;++i)
+   {
+      _threads.emplace_back(main,this,i);
+   }
+}
+
+
+
+ThreadPool::~ThreadPool()
+{
+   wait();
+   {
+      std::lock_guard<std::mutex> l(_sleepLock);
+      _stop.store(true);
+   }
+   _wake.notify_all();
+   for (auto& i:_threads)
+   {
+      i.join();
+   }
+   for (auto i:_deques)
+   {
+      delete i;
+   }
+}
+
+
+
+void ThreadPool::submit(task t)
+{
+   Task* n {new Task(std::move(t))};
+   _pending.fetch_add(1);
+   if (_current==this)
+   {
+      _deques[_index]->push(n);
+   }
+   else
+   {
+      std::lock_guard<std::mutex> l(_injectLock);
+      _inject.push_back(n);
+   }
+   _queued.fetch_add(1);
+   if (_sleeping.load()>0)
+   {
+      std::lock_guard<std::mutex> l(_sleepLock);
+      _wake.notify_one();
+   }
+}
+
+
+
+void ThreadPool::wait()
+{
+   std::unique_lock<std::mutex> l(_idleLock);
+   _idle.wait(l,[this] { return _pending.load()==0; });
+}
+
+
+
+ThreadPool::Task* ThreadPool::find(unsigned int index)
+{
+   Task* ret {_deques[index]->take()};
+   if (!ret&&_queued.load(std::memory_order_relaxed)>0)
+   {
+      {
+         std::lock_guard<std::mutex> l(_injectLock);
+         if (!_inject.empty())
+         {
+            ret = _inject.front();
+            _inject.pop_front();
+         }
+      }
+      unsigned int size = _deques.size();
+      for (unsigned int i = 1;!ret&&i<size;++i)
+      {
+         ret = _deques[(index+i)%size]->steal();
+      }
+   }
+   if (ret)
+   {
+      _queued.fetch_sub(1);
+   }
+   return ret;
+}
+
+
+
+void ThreadPool::finish(Task* t)
+{
+   delete t;
+   if (_pending.fetch_sub(1)==1)
+   {
+      std::lock_guard<std::mutex> l(_idleLock);
+      _idle.notify_all();
+   }
+}
+
+
+
+void ThreadPool::main(ThreadPool* pool, unsigned int index)
+{
+   _current = pool;
+   _index = index;
+   while (!pool->_stop.load())
+   {
+      Exception::base_catch(loop,dispatch);
+   }
+   _current = nullptr;
+}
+
+
+
+void ThreadPool::loop()
+{
+   ThreadPool& p {*_current};
+   std::size_t depth {Trace::depth()};
+   while (true)
+   {
+      _task = p.find(_index);
+      if (_task)
+      {
+         Tag::set(_task->tag);
+         _task->run();
+         Tag::set(0);
+         Trace::rewind(depth);
+         p.finish(_task);
+         _task = nullptr;
+      }
+      else
+      {
+         std::unique_lock<std::mutex> l(p._sleepLock);
+         p._sleeping.fetch_add(1);
+         p._wake.wait(l,[&p] {
+            return p._queued.load()>0||p._stop.load();
+         });
+         p._sleeping.fetch_sub(1);
+         if (p._queued.load()==0&&p._stop.load())
+         {
+            return;
+         }
+      }
+   }
+}
+
+
+
+void ThreadPool::dispatch(Exception::Type t, Exception* e, std::exception* std)
+{
+   ThreadPool& p {*_current};
+   p._handler(t,e,std);
+   Tag::set(0);
+   if (_task)
+   {
+      p.finish(_task);
+      _task = nullptr;
+   }
+}
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | DEQUE                                                                    |
+// *==========================================================================*
+//
+//
+//
+
+
+
+ThreadPool::Deque::Deque():
+   _array {new Array(64)}
+{}
+
+
+
+ThreadPool::Deque::~Deque()
+{
+   delete _array.load();
+   for (auto i:_retired)
+   {
+      delete i;
+   }
+}
+
+
+
+void ThreadPool::Deque::push(Task* t)
+{
+   long b {_bottom.load(std::memory_order_relaxed)};
+   long top {_top.load(std::memory_order_acquire)};
+   Array* a {_array.load(std::memory_order_relaxed)};
+   if (b-top>a->size-1)
+   {
+      a = grow(a,b,top);
+   }
+   a->put(b,t);
+   std::atomic_thread_fence(std::memory_order_release);
+   _bottom.store(b+1,std::memory_order_relaxed);
+}
+
+
+
+ThreadPool::Task* ThreadPool::Deque::take()
+{
+   long b {_bottom.load(std::memory_order_relaxed)-1};
+   Array* a {_array.load(std::memory_order_relaxed)};
+   _bottom.store(b,std::memory_order_relaxed);
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   long t {_top.load(std::memory_order_relaxed)};
+   Task* ret {nullptr};
+   if (t<=b)
+   {
+      ret = a->get(b);
+      if (t==b)
+      {
+         if (!_top.compare_exchange_strong(t,t+1,std::memory_order_seq_cst,
+                                           std::memory_order_relaxed))
+         {
+            ret = nullptr;
+         }
+         _bottom.store(b+1,std::memory_order_relaxed);
+      }
+   }
+   else
+   {
+      _bottom.store(b+1,std::memory_order_relaxed);
+   }
+   return ret;
+}
+
+
+
+ThreadPool::Task* ThreadPool::Deque::steal()
+{
+   long t {_top.load(std::memory_order_acquire)};
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   long b {_bottom.load(std::memory_order_acquire)};
+   Task* ret {nullptr};
+   if (t<b)
+   {
+      Array* a {_array.load(std::memory_order_acquire)};
+      ret = a->get(t);
+      if (!_top.compare_exchange_strong(t,t+1,std::memory_order_seq_cst,
+                                        std::memory_order_relaxed))
+      {
+         ret = nullptr;
+      }
+   }
+   return ret;
+}
+
+
+
+ThreadPool::Deque::Array* ThreadPool::Deque::grow(Array* a, long bottom,
+                                                  long top)
+{
+   Array* n {new Array(a->size*2)};
+   for (long i = top;i<bottom;++i)
+   {
+      n->put(i,a->get(i));
+   }
+   _retired.push_back(a);
+   _array.store(n,std::memory_order_release);
+   return n;
+}
+
+
+
+ThreadPool::Deque::Array::Array(long s):
+   size {s},
+   buffer {new std::atomic<Task*>[s]}
+{}
+
+
+
+ThreadPool::Deque::Array::~Array()
+{
+   delete[] buffer;
+}
+
+
+
+inline ThreadPool::Task* ThreadPool::Deque::Array::get(long i) const
+{
+   return buffer[i%size].load(std::memory_order_relaxed);
+}
+
+
+
+inline void ThreadPool::Deque::Array::put(long i, Task* t)
+{
+   buffer[i%size].store(t,std::memory_order_relaxed);
+}
+
+
+
+}
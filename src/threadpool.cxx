@@ -0,0 +1,195 @@
+#include "unit.hh"
+#include "threadpool.h"
+namespace unit {
+/// @ingroup utest
+/// @brief Tests work stealing thread pool.
+///
+/// Tests the work stealing thread pool, consisting of the ThreadPool class.
+namespace threadpool {
+
+
+
+/// @brief Used for all strings.
+using string = std::string;
+/// @brief Used for throwing a unit test failure.
+using fail = UnitTest::Run::Fail;
+/// @brief Used as shorthand.
+using gwe = Gwers::Exception;
+/// @brief Used as shorthand.
+using gwtr = Gwers::Trace;
+/// @brief Used as shorthand.
+using pool = Gwers::ThreadPool;
+
+
+
+/// @brief Internal variable that is used with handler unit testing.
+std::atomic<int> gwers_count;
+/// @brief Internal variable that is used with handler unit testing.
+std::atomic<int> std_count;
+/// @brief Internal variable that is used with handler unit testing.
+std::atomic<int> unknown_count;
+/// @brief Internal variable that is used with handler unit testing.
+std::atomic<bool> trace_good;
+
+
+
+/// @brief Internal function that is used as the pool exception handler.
+void handler_func(gwe::Type t, gwe* e, std::exception*)
+{
+   switch (t)
+   {
+   case gwe::Type::gwers:
+      if (e->what()!=string("test_what")||gwtr::depth()!=1||
+          *(gwtr::begin())!=string("task"))
+      {
+         trace_good = false;
+      }
+      ++gwers_count;
+      break;
+   case gwe::Type::std:
+      ++std_count;
+      break;
+   case gwe::Type::unknown:
+      ++unknown_count;
+      break;
+   }
+}
+
+
+
+/// @brief Internal function that is used with nested unit testing.
+void spawn(pool& p, std::atomic<int>& count, int depth)
+{
+   ++count;
+   if (depth>0)
+   {
+      for (int i = 0;i<4;++i)
+      {
+         p.submit([&p,&count,depth] { spawn(p,count,depth-1); });
+      }
+   }
+}
+
+
+
+/// @brief Unit tests submitting and waiting on tasks.
+///
+/// This function unit tests the constructor, submit(), and wait() functions of
+/// the Gwers::ThreadPool class. It performs these tests with two unit tests.
+///
+/// -# Constructs a pool of four workers, submitting a large number of tasks
+/// from outside of the pool and waiting on them, making sure every task was
+/// ran exactly once.
+///
+/// -# Submits a single task to a pool of four workers that recursively submits
+/// more tasks from within the pool, exercising the deque of each worker and
+/// stealing between workers, making sure every task was ran exactly once.
+void basic(UnitTest::Run& ut)
+{
+   pool p(4,handler_func);
+   if (p.size()!=4)
+   {
+      throw fail();
+   }
+   std::atomic<int> count {0};
+   for (int i = 0;i<10000;++i)
+   {
+      p.submit([&count] { ++count; });
+   }
+   p.wait();
+   if (count!=10000)
+   {
+      throw fail();
+   }
+   ut.next();
+   count = 0;
+   p.submit([&p,&count] { spawn(p,count,6); });
+   p.wait();
+   if (count!=5461)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Unit tests exceptions thrown by tasks.
+///
+/// This function unit tests the handling of exceptions thrown by tasks run
+/// within the Gwers::ThreadPool class. It performs these tests with two unit
+/// tests.
+///
+/// -# Submits tasks that throw all three types of exceptions along with tasks
+/// that do not, to a pool of two workers. Makes sure the handler was called
+/// for every failing task with the correct exception type and the function
+/// stack of the failing task intact, and that all tasks submitted after the
+/// failing ones were still ran.
+///
+/// -# Submits a task to a pool of one worker that catches its own %Gwers
+/// exception, leaving the function stack locked, followed by a second task that
+/// makes sure the function stack has been rewound and unlocked.
+void exception(UnitTest::Run& ut)
+{
+   gwers_count = 0;
+   std_count = 0;
+   unknown_count = 0;
+   trace_good = true;
+   std::atomic<int> count {0};
+   {
+      pool p(2,handler_func);
+      for (int i = 0;i<100;++i)
+      {
+         p.submit([] {
+            gwtr t("task");
+            throw gwe("test_who","test_what",66);
+         });
+         p.submit([] { throw std::exception(); });
+         p.submit([] { throw int(66); });
+         p.submit([&count] { ++count; });
+      }
+   }
+   if (gwers_count!=100||std_count!=100||unknown_count!=100||!trace_good||
+       count!=100)
+   {
+      throw fail();
+   }
+   ut.next();
+   bool good {false};
+   {
+      pool p(1,handler_func);
+      p.submit([] {
+         try
+         {
+            gwtr t("first");
+            throw gwe("test_who","test_what",66);
+         }
+         catch (const gwe&)
+         {}
+      });
+      p.submit([&good] {
+         {
+            gwtr t("second");
+         }
+         good = gwtr::depth()==0;
+      });
+   }
+   if (!good)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Initialize all unit tests for ThreadPool class.
+void init(UnitTest& ut)
+{
+   UnitTest::Run& t = ut.add("ThreadPool",nullptr,nullptr);
+   t.add("basic",basic);
+   t.add("exception",exception);
+}
+
+
+
+}
+}
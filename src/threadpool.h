@@ -0,0 +1,278 @@
+#ifndef GWERS_THREADPOOL_H
+#define GWERS_THREADPOOL_H
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "exception.h"
+namespace Gwers {
+
+
+
+/// @defgroup parallel Parallel Execution
+/// @brief Executes work concurrently across a set of worker threads.
+///
+/// This collection of classes and functions gives a single executor for
+/// running small units of work, or tasks, across all cores of a machine. Every
+/// worker thread runs inside its own Exception::base_catch() call and every
+/// task is given a checkpoint of the Trace stack, so a task that fails can
+/// never kill the worker running it or leave a corrupted function stack behind
+/// for the next task.
+
+
+
+/// @ingroup parallel
+/// @brief Work stealing pool of worker threads.
+///
+/// This holds a fixed number of worker threads that execute tasks submitted to
+/// it. Each worker owns a Chase-Lev deque of tasks. A task submitted from a
+/// worker of this pool is pushed onto the bottom of that worker's own deque
+/// without any locking, and is popped back off the bottom by the same worker.
+/// Workers that run out of tasks steal from the top of the deques of other
+/// workers. Tasks submitted from threads outside of the pool are placed on a
+/// shared injection queue that all workers take from.
+///
+/// Each worker thread runs its loop within Exception::base_catch(), so any
+/// exception escaping a task is caught and passed to the handler given to the
+/// pool, just as it would be for base_catch(). The function stack of the Trace
+/// class is intact while the handler is called, showing where in the task the
+/// exception was thrown. Once the handler returns, the worker enters a new
+/// base_catch() and carries on with the next task. Before each task is ran, the
+/// depth of the function stack is checkpointed and it is rewound to that depth
+/// once the task returns, so a task that catches a %Gwers exception on its own
+/// cannot leave the stack locked. Each task runs under the Tag of the thread
+/// that submitted it, and the worker is given back the tag 0 once it returns.
+///
+/// @warning The exception handler given to the pool is called on the worker
+/// thread that ran the failing task. It must not throw any exception itself.
+class ThreadPool
+{
+public:
+   // *
+   // * DECLERATIONS
+   // *
+   /// @brief Used for all tasks submitted to the pool.
+   using task = std::function<void()>;
+   /// @brief Used for the exception handling function of the pool.
+   using efp = Exception::efp;
+   // *
+   // * BASIC METHODS
+   // *
+   /// @brief Initializes pool and starts all worker threads.
+   ///
+   /// @param size Number of worker threads, if 0 then the number of hardware
+   /// threads is used.
+   /// @param handler Function that will be called if any exception escapes a
+   /// task, see Exception::efp for more information.
+   ///
+   /// Initializes this pool, creating the deque of each worker and starting all
+   /// worker threads.
+   ThreadPool(unsigned int size, efp handler);
+   /// @brief Waits for all tasks and joins all worker threads.
+   ///
+   /// Waits until all tasks submitted to this pool have finished, then stops
+   /// and joins all worker threads.
+   ~ThreadPool();
+   // *
+   // * COPY METHODS
+   // *
+   ThreadPool(const ThreadPool&) = delete;
+   ThreadPool& operator=(const ThreadPool&) = delete;
+   // *
+   // * MOVE METHODS
+   // *
+   ThreadPool(ThreadPool&&) = delete;
+   ThreadPool& operator=(ThreadPool&&) = delete;
+   // *
+   // * FUNCTIONS
+   // *
+   /// @brief Submits a new task to the pool.
+   ///
+   /// @param t Task that will be executed by one of the worker threads.
+   ///
+   /// Adds a new task to this pool. If this is called from one of this pool's
+   /// worker threads the task is pushed onto that worker's own deque, else it
+   /// is placed on the shared injection queue.
+   void submit(task t);
+   /// @brief Waits until all submitted tasks have finished.
+   ///
+   /// Blocks the calling thread until every task submitted to this pool has
+   /// either returned or failed with an exception.
+   ///
+   /// @warning This must never be called from one of this pool's own worker
+   /// threads.
+   void wait();
+   /// @brief Get number of worker threads.
+   unsigned int size() const;
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   /// @brief Get pool of calling thread.
+   ///
+   /// @return Pool the calling thread is a worker of, or nullptr if the
+   /// calling thread is not a worker of any pool.
+   static ThreadPool* current();
+private:
+   // *
+   // * DECLERATIONS
+   // *
+   class Deque;
+   struct Task
+   {
+      Task(task&& t): run {std::move(t)}, tag {Tag::current()} {}
+      task run;
+      std::uint32_t tag;
+   };
+   // *
+   // * FUNCTIONS
+   // *
+   Task* find(unsigned int index);
+   void finish(Task* t);
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   static void main(ThreadPool* pool, unsigned int index);
+   static void loop();
+   static void dispatch(Exception::Type t, Exception* e, std::exception* std);
+   // *
+   // * VARIABLES
+   // *
+   efp _handler;
+   std::vector<Deque*> _deques;
+   std::vector<std::thread> _threads;
+   std::deque<Task*> _inject;
+   std::mutex _injectLock;
+   std::atomic<long> _queued {0};
+   std::atomic<long> _pending {0};
+   std::atomic<int> _sleeping {0};
+   std::atomic<bool> _stop {false};
+   std::mutex _sleepLock;
+   std::condition_variable _wake;
+   std::mutex _idleLock;
+   std::condition_variable _idle;
+   // *
+   // * STATIC VARIABLES
+   // *
+   thread_local static ThreadPool* _current;
+   thread_local static unsigned int _index;
+   thread_local static Task* _task;
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | DEQUE                                                                    |
+// *==========================================================================*
+//
+//
+//
+
+
+
+/// @brief Chase-Lev work stealing deque of tasks.
+///
+/// This is a lock free deque where a single owner thread pushes and takes tasks
+/// from the bottom while any number of other threads steal tasks from the top.
+/// The circular array backing the deque grows when full. Arrays that have been
+/// replaced are kept until the deque is destroyed, because a thief may still be
+/// reading from one.
+///
+/// @warning This is internal to the ThreadPool class and should never be used
+/// directly by the user.
+class ThreadPool::Deque
+{
+public:
+   // *
+   // * BASIC METHODS
+   // *
+   /// @brief Initializes empty deque with a small array.
+   Deque();
+   /// @brief Frees all arrays this deque has ever used.
+   ~Deque();
+   // *
+   // * COPY METHODS
+   // *
+   Deque(const Deque&) = delete;
+   Deque& operator=(const Deque&) = delete;
+   // *
+   // * MOVE METHODS
+   // *
+   Deque(Deque&&) = delete;
+   Deque& operator=(Deque&&) = delete;
+   // *
+   // * FUNCTIONS
+   // *
+   /// @brief Push task onto bottom of deque, owner thread only.
+   void push(Task* t);
+   /// @brief Take task from bottom of deque, owner thread only.
+   ///
+   /// @return Task taken or nullptr if deque is empty.
+   Task* take();
+   /// @brief Steal task from top of deque, any thread.
+   ///
+   /// @return Task stolen or nullptr if deque is empty or another thread won
+   /// the race for the top task.
+   Task* steal();
+private:
+   // *
+   // * DECLERATIONS
+   // *
+   struct Array
+   {
+      Array(long s);
+      ~Array();
+      Task* get(long i) const;
+      void put(long i, Task* t);
+      long size;
+      std::atomic<Task*>* buffer;
+   };
+   // *
+   // * FUNCTIONS
+   // *
+   Array* grow(Array* a, long bottom, long top);
+   // *
+   // * VARIABLES
+   // *
+   std::atomic<long> _top {0};
+   char _pad[64];
+   std::atomic<long> _bottom {0};
+   std::atomic<Array*> _array;
+   std::vector<Array*> _retired;
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | INLINE/TEMPLATE                                                          |
+// *==========================================================================*
+//
+//
+//
+
+
+
+inline unsigned int ThreadPool::size() const
+{
+   return _threads.size();
+}
+
+
+
+inline ThreadPool* ThreadPool::current()
+{
+   return _current;
+}
+
+
+
+}
+#endif
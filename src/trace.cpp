@@ -1,29 +1,235 @@
 #include "trace.h"
+#include <cstdlib>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include "config.h"
+#include "profile.h"
+#include "tag.h"
 namespace Gwers {
 
 
 
-thread_local Trace::list Trace::_stack {};
+namespace
+{
+   // Links config.cpp into every traced program, whose initialization then
+   // publishes the rules of the GWX_CONFIG environment variable at startup.
+   __attribute__((used)) const Config::Snapshot& (*const g_config)()
+      {Config::get};
+}
+
+
+
+Recycler<Trace::stack,64> Trace::_stacks;
+const std::size_t Trace::_local {string().capacity()};
+thread_local Trace::Buffer Trace::_stack {};
 thread_local bool Trace::_lock {false};
 
 
 
-Trace::~Trace()
+Trace::Buffer::Buffer():
+   frames {_stacks.acquire()}
+{}
+
+
+
+Trace::Buffer::~Buffer()
 {
+   frames->clear();
+   _stacks.release(frames);
+}
+
+
+
+void Trace::pop()
+{
+   if (_start)
+   {
+      std::int64_t cpu {_cpu?Profile::cputime()-_cpu:0};
+      Profile::charge(Tag::current(),_site,_weight,Profile::now()-_start,cpu,
+                      _bytes);
+   }
+   Request::leave();
    if (!_lock)
    {
-      _stack.pop_back();
+      Recorder::leave();
+      if (_bytes)
+      {
+         account(-_bytes);
+      }
+      _stack->pop_back();
+   }
+}
+
+
+
+void Trace::observe(std::string_view name)
+{
+   Buffer& b {_stack};
+   Frame& f {b->back()};
+   _bytes = bytes(f);
+   if (f.site&&Profile::profiling())
+   {
+      _site = f.site;
+      _weight = f.weight;
+      _start = Profile::now();
+      if (Profile::timing())
+      {
+         _cpu = Profile::cputime();
+      }
+   }
+   if (_bytes||b.grown())
+   {
+      account(_bytes);
    }
+   Request::enter(name);
+   Recorder::enter(name);
 }
 
 
 
 void Trace::flush()
 {
-   _stack.clear();
+   std::int64_t n {0};
+   for (auto& i:*_stack)
+   {
+      n += bytes(i);
+   }
+   account(-n);
+   _stack->clear();
    _lock = false;
 }
 
 
 
+void Trace::rewind(std::size_t depth)
+{
+   if (depth<_stack->size())
+   {
+      std::int64_t n {0};
+      for (auto i = _stack->begin()+depth;i!=_stack->end();++i)
+      {
+         n += bytes(*i);
+      }
+      account(-n);
+      _stack->erase(_stack->begin()+depth,_stack->end());
+   }
+   _lock = false;
+}
+
+
+
+Trace::list Trace::snapshot()
+{
+   list ret;
+   ret.reserve(_stack->size());
+   for (auto& i:*_stack)
+   {
+      if (_lock&&!i.text)
+      {
+         name(i);
+         account(-bytes(i));
+         ret.emplace_back(std::move(i.name));
+      }
+      else
+      {
+         ret.emplace_back(name(i));
+      }
+   }
+   return ret;
+}
+
+
+
+void Trace::restore(list&& snapshot)
+{
+   std::int64_t n {0};
+   for (auto& i:snapshot)
+   {
+      _stack->emplace_back(std::move(i));
+      n += bytes(_stack->back());
+   }
+   account(n);
+   snapshot.clear();
+   _lock = true;
+}
+
+
+
+void Trace::symbolize(Frame& f)
+{
+   Dl_info info;
+   if (dladdr(f.address,&info)&&info.dli_sname)
+   {
+      int status;
+      char* n {abi::__cxa_demangle(info.dli_sname,nullptr,nullptr,&status)};
+      if (n)
+      {
+         f.name = n;
+         std::free(n);
+      }
+      else
+      {
+         f.name = info.dli_sname;
+      }
+   }
+   else
+   {
+      Format::Fixed<32> str;
+      str << f.address;
+      f.name = str.str();
+   }
+   f.address = nullptr;
+   account(bytes(f));
+}
+
+
+
+void Trace::account(std::int64_t bytes)
+{
+   Buffer& b {_stack};
+   std::size_t capacity {b->capacity()};
+   if (capacity!=b.capacity)
+   {
+      bytes += (static_cast<std::int64_t>(capacity)-
+                static_cast<std::int64_t>(b.capacity))*sizeof(Frame);
+      b.capacity = capacity;
+   }
+   b.pending += bytes;
+   if (b.pending>=Memory::slack||b.pending<=-Memory::slack)
+   {
+      Memory::add(Memory::Kind::trace,b.pending);
+      b.pending = 0;
+   }
+}
+
+
+
+}
+
+
+
+#ifdef ATRACE
+extern "C" {
+
+
+
+/// @brief Called by -finstrument-functions on entry of every function.
+__attribute__((no_instrument_function))
+   void __cyg_profile_func_enter(void* function, void*)
+{
+   Gwers::Trace::enter(function);
+}
+
+
+
+/// @brief Called by -finstrument-functions on exit of every function.
+__attribute__((no_instrument_function))
+   void __cyg_profile_func_exit(void*, void*)
+{
+   Gwers::Trace::leave();
+}
+
+
+
 }
+#endif
@@ -1,5 +1,6 @@
 #include "unit.hh"
-#include "trace.h"
+#include <thread>
+#include "exception.h"
 #include <iostream>
 namespace unit {
 /// @ingroup utest
@@ -7,6 +8,32 @@ namespace unit {
 ///
 /// Tests the stack tracing system, consisting of the Trace class.
 namespace trace {
+/// @brief Policy adding nothing to the stack.
+GWX_POLICY(Off,0,1)
+/// @brief Policy adding only function names to the stack.
+GWX_POLICY(Names,1,1)
+/// @brief Policy adding function names and arguments to the stack.
+GWX_POLICY(Full,2,1)
+
+
+
+/// @brief Internal class template used to test GWX_FUNCTION.
+template<class T> struct Named
+{
+   /// @brief Get shortened name of this function.
+   template<class U> static std::string get(const std::vector<U>&)
+   {
+      return GWX_FUNCTION;
+   }
+};
+
+
+
+/// @brief Internal function that shortens a function signature at runtime.
+template<std::size_t N> std::string shorten(const char (&pretty)[N])
+{
+   return Gwers::Trace::Name<N>(pretty).c_str();
+}
 
 
 
@@ -130,6 +157,298 @@ void flush(UnitTest::Run&)
 
 
 
+/// @brief Unit tests static depth and rewind functions.
+///
+/// This function unit tests the static Gwers::Trace::depth() and
+/// Gwers::Trace::rewind() functions. It makes sure the depth of the static
+/// stack is correctly reported and that rewinding the stack removes all function
+/// items above the given depth and unlocks the stack. It performs these tests
+/// with two unit tests.
+///
+/// -# Instantiates two nested Trace objects, making sure the depth reported
+/// matches the number of objects at each level.
+///
+/// -# Takes a checkpoint of the depth with one Trace object on the stack, then
+/// adds two more Trace objects and locks the stack. The stack is then rewound
+/// to the checkpoint, verifying only the first function item remains and that
+/// the stack is no longer locked.
+void rewind(UnitTest::Run& ut)
+{
+   using string = std::string;
+   using fail = UnitTest::Run::Fail;
+   using tr = Gwers::Trace;
+   {
+      tr t("first");
+      {
+         tr t("second");
+         if (tr::depth()!=2)
+         {
+            throw fail();
+         }
+      }
+      if (tr::depth()!=1)
+      {
+         throw fail();
+      }
+   }
+   ut.next();
+   {
+      tr t("first");
+      auto mark = tr::depth();
+      {
+         tr t("second");
+         {
+            tr t("third");
+            tr::lock();
+         }
+      }
+      tr::rewind(mark);
+      if (tr::depth()!=1||*(tr::begin())!=string("first"))
+      {
+         throw fail();
+      }
+   }
+   if (tr::depth()!=0)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Unit tests static snapshot and restore functions.
+///
+/// This function unit tests the static Gwers::Trace::snapshot(),
+/// Gwers::Trace::restore(), and Gwers::Trace::locked() functions. It performs
+/// these tests with three unit tests.
+///
+/// -# Takes a snapshot of an unlocked stack of two Trace objects, making sure
+/// the snapshot holds both function items and the stack is left untouched.
+///
+/// -# Takes a snapshot of a locked stack of two function items, making sure
+/// the snapshot holds both function items, the depth of the stack is unchanged,
+/// and the function items left behind are empty.
+///
+/// -# Restores a snapshot on top of a stack with one Trace object, making sure
+/// the stack holds all three function items in order and is locked.
+void snapshot(UnitTest::Run& ut)
+{
+   using string = std::string;
+   using fail = UnitTest::Run::Fail;
+   using tr = Gwers::Trace;
+   {
+      tr t1("first");
+      tr t2("second");
+      auto s = tr::snapshot();
+      if (tr::locked()||s.size()!=2||s[0]!=string("first")||
+          s[1]!=string("second")||*(tr::begin())!=string("first"))
+      {
+         throw fail();
+      }
+   }
+   ut.next();
+   tr::list s;
+   {
+      tr t1("first");
+      tr t2("second");
+      tr::lock();
+      s = tr::snapshot();
+   }
+   if (!tr::locked()||s.size()!=2||s[0]!=string("first")||
+       s[1]!=string("second")||tr::depth()!=2||!tr::begin()->empty())
+   {
+      throw fail();
+   }
+   tr::flush();
+   ut.next();
+   {
+      tr t("base");
+      tr::restore(std::move(s));
+      auto i = tr::begin();
+      if (!tr::locked()||*(i++)!=string("base")||*(i++)!=string("first")||
+          *(i++)!=string("second")||i!=tr::end())
+      {
+         throw fail();
+      }
+   }
+   tr::flush();
+}
+
+
+
+/// @brief Unit tests the GWX_BEGIN_P macro.
+///
+/// This function unit tests the GWX_BEGIN_P macro along with the
+/// Gwers::Trace::Policed class for all three trace levels of a policy. It
+/// performs these tests with three unit tests.
+///
+/// -# Uses GWX_BEGIN_P with a policy of trace level 2, making sure the function
+/// item added holds the function name and all argument values.
+///
+/// -# Uses GWX_BEGIN_P with a policy of trace level 1, making sure the function
+/// item added holds only the function name.
+///
+/// -# Uses GWX_BEGIN_P with a policy of trace level 0, making sure no function
+/// item is added, and that the items of the previous tests were popped.
+void policy(UnitTest::Run& ut)
+{
+   using string = std::string;
+   using fail = UnitTest::Run::Fail;
+   using tr = Gwers::Trace;
+   {
+      GWX_BEGIN_P(Full,"full",1,2);
+      if (tr::depth()!=1||*(tr::begin())!=string("full[1],[2]"))
+      {
+         throw fail();
+      }
+   }
+   ut.next();
+   {
+      GWX_BEGIN_P(Names,"names",1,2);
+      if (tr::depth()!=1||*(tr::begin())!=string("names"))
+      {
+         throw fail();
+      }
+   }
+   ut.next();
+   {
+      GWX_BEGIN_P(Off,"off",1,2);
+      if (tr::depth()!=0)
+      {
+         throw fail();
+      }
+   }
+}
+
+
+
+/// @brief Unit tests recycling of static stacks between threads.
+///
+/// This function unit tests that the static stack of a thread is cleared and
+/// unlocked when it is recycled for a new thread. It performs this test with a
+/// single unit test.
+///
+/// -# Runs many threads one after another, each of which leaves a locked stack
+/// with many function items behind when it exits, making sure every thread
+/// starts with an empty and unlocked stack.
+void recycle(UnitTest::Run&)
+{
+   using fail = UnitTest::Run::Fail;
+   using tr = Gwers::Trace;
+   bool good {true};
+   for (int i = 0;i<16;++i)
+   {
+      std::thread t([&good] {
+         if (tr::depth()!=0||tr::locked())
+         {
+            good = false;
+         }
+         tr::restore(tr::list(100,"item"));
+      });
+      t.join();
+   }
+   if (!good)
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Unit tests shortening of function signatures.
+///
+/// This function unit tests the Gwers::Trace::Name class and the GWX_FUNCTION
+/// macro. It performs these tests with three unit tests.
+///
+/// -# Shortens a signature in a constant expression, making sure the return
+/// type is removed and the shortened name is held by a static string.
+///
+/// -# Shortens signatures with template arguments, qualifiers, operators,
+/// anonymous namespaces, and lambdas, making sure each is shortened as it
+/// should be.
+///
+/// -# Uses GWX_FUNCTION in a member function template of a class template and
+/// in a lambda, making sure both give their shortened names.
+void name(UnitTest::Run& ut)
+{
+   using string = std::string;
+   using fail = UnitTest::Run::Fail;
+   using tr = Gwers::Trace;
+   static constexpr tr::Name<sizeof("static int ns::f(char)")> n
+      {"static int ns::f(char)"};
+   static_assert(n.size()==11,"Name is not a constant expression.");
+   if (n.c_str()!=string("ns::f(char)"))
+   {
+      throw fail();
+   }
+   ut.next();
+   if (shorten("static std::vector<int, std::allocator<int> > ns::A<T>::f("
+               "const std::map<int, int>&) const [with T = int]")!=
+          "ns::A<>::f(const std::map<>&)"||
+       shorten("bool ns::operator<(const ns::A&, const ns::A&)")!=
+          "ns::operator<(const ns::A&, const ns::A&)"||
+       shorten("ns::A::operator const char*() const")!=
+          "ns::A::operator const char*()"||
+       shorten("void ns::A::operator()(int)")!="ns::A::operator()(int)"||
+       shorten("void ns::(anonymous namespace)::g()")!=
+          "ns::(anonymous namespace)::g()"||
+       shorten("ns::{anonymous}::f()::<lambda(int)>")!=
+          "ns::{anonymous}::f()::<lambda(int)>")
+   {
+      throw fail();
+   }
+   ut.next();
+   auto lambda = [] { return string(GWX_FUNCTION); };
+   if (Named<double>::get(std::vector<int>())!=
+          "unit::trace::Named<>::get(const std::vector<>&)"||
+       lambda()!="unit::trace::name(UnitTest::Run&)::<lambda()>")
+   {
+      throw fail();
+   }
+}
+
+
+
+/// @brief Unit tests interned function items.
+///
+/// This function unit tests the GWX_BEGIN_I macro. It performs these tests with
+/// two unit tests.
+///
+/// -# Uses GWX_BEGIN_I in two nested scopes with the same name and arguments,
+/// making sure both function items have the right name and point to the same
+/// interned string.
+///
+/// -# Locks the stack and takes a snapshot of it, making sure the interned
+/// names are copied into the snapshot and left untouched on the stack.
+void interned(UnitTest::Run& ut)
+{
+   using string = std::string;
+   using fail = UnitTest::Run::Fail;
+   using tr = Gwers::Trace;
+   tr::list snapshot;
+   GWX_BEGIN_I("interned",1);
+   {
+      GWX_BEGIN_I("interned",1);
+      auto i = tr::begin();
+      if (tr::depth()!=2||*i!=string("interned[1]")||&*i!=&*(++i)||
+          &*i!=Gwers::Intern::get("interned[1]"))
+      {
+         throw fail();
+      }
+      ut.next();
+      tr::lock();
+      snapshot = tr::snapshot();
+   }
+   if (snapshot!=tr::list {"interned[1]","interned[1]"}||tr::depth()!=2||
+       *tr::begin()!=string("interned[1]"))
+   {
+      throw fail();
+   }
+   tr::rewind(1);
+}
+
+
+
 /// @brief Additional unit tests for entire class.
 ///
 /// This function makes additional unit tests to the overall Gwers::Trace class,
@@ -189,6 +508,12 @@ void init(UnitTest& ut)
    t.add("basic",basic);
    t.add("lock",lock);
    t.add("flush",flush);
+   t.add("rewind",rewind);
+   t.add("snapshot",snapshot);
+   t.add("policy",policy);
+   t.add("recycle",recycle);
+   t.add("name",name);
+   t.add("interned",interned);
    t.add("extra",extra);
 }
 
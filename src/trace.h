@@ -1,15 +1,112 @@
 #ifndef GWERS_TRACE_H
 #define GWERS_TRACE_H
+#include <iterator>
+#include <new>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
 #include <vector>
-#include <sstream>
+#include "format.h"
+#include "intern.h"
+#include "key.h"
+#include "probe.h"
+#include "recorder.h"
+#include "recycler.h"
+#include "request.h"
+#include "site.h"
+#define GWX_FUNCTION ({ static constexpr ::Gwers::Trace::Name<\
+                           sizeof(__PRETTY_FUNCTION__)>\
+                              GWX__tmp__name {__PRETTY_FUNCTION__};\
+                        GWX__tmp__name.c_str(); })
+#define GWX__WHERE(N) static constexpr ::Gwers::Trace::Name<\
+                         sizeof(__PRETTY_FUNCTION__)>\
+                            GWX__tmp__where {__PRETTY_FUNCTION__};\
+                      static ::Gwers::Site GWX__tmp__site\
+                         {__FILE__,__LINE__,GWX__tmp__where.c_str(),N};
+#define GWX__SITE(N) GWX__WHERE(N) GWX__ENROLL(GWX__tmp__site)
+#define GWX__LOCAL static thread_local ::Gwers::Site::Local GWX__tmp__local;
+#define GWX__SAMPLE GWX__tmp__site.sample(GWX__tmp__local)
+#if defined(GWX_USDT)&&defined(GWX__PROBES)
+#define GWX__TEXT(F,...) ::Gwers::Trace::text(GWX__tmp__string,\
+                                              GWX__tmp__detail,GWX__tmp__held);
+#define GWX__ARGS(F,...) GWX__tmp__held
+#else
+#define GWX__TEXT(F,...) GWX__tmp__string << F;\
+                         if (GWX__tmp__detail>1)\
+                         {\
+                            ::Gwers::Trace::build(GWX__tmp__string,\
+                                                  ##__VA_ARGS__);\
+                         }
+#define GWX__ARGS(F,...) F,##__VA_ARGS__
+#endif
 #ifdef DTRACE
-#define GWX_BEGIN(F,...) std::ostringstream GWX__tmp__string;\
-                         GWX__tmp__string << F;\
-                         ::Gwers::Trace::build(GWX__tmp__string,##__VA_ARGS__);\
-                         ::Gwers::Trace x_trace(GWX__tmp__string.str());
+#define GWX_BEGIN(F,...) GWX_BEGIN_S(1,F,##__VA_ARGS__)
+#define GWX_BEGIN_S(N,F,...) GWX__WHERE(N)\
+                             GWX__HOLD(F,##__VA_ARGS__)\
+                             ::Gwers::Trace::Keyed<::Gwers::Trace> x_trace;\
+                             if (GWX__KEY)\
+                             {\
+                                GWX__ENROLL(GWX__tmp__site)\
+                                GWX__LOCAL\
+                                ::Gwers::Trace::Text GWX__tmp__string;\
+                                const int GWX__tmp__detail {GWX__SAMPLE};\
+                                if (GWX__tmp__detail>0)\
+                                {\
+                                   GWX__TEXT(F,##__VA_ARGS__)\
+                                }\
+                                x_trace.start(GWX__tmp__site,\
+                                              GWX__tmp__detail>0?\
+                                              &GWX__tmp__string:nullptr);\
+                             }\
+                             GWX__PROBE()
+#define GWX_BEGIN_I(F,...) GWX__WHERE(1)\
+                           GWX__HOLD(F,##__VA_ARGS__)\
+                           ::Gwers::Trace::Keyed<::Gwers::Trace> x_trace;\
+                           if (GWX__KEY)\
+                           {\
+                              GWX__ENROLL(GWX__tmp__site)\
+                              GWX__LOCAL\
+                              ::Gwers::Trace::Text GWX__tmp__string;\
+                              const std::string* GWX__tmp__interned {nullptr};\
+                              const int GWX__tmp__detail {GWX__SAMPLE};\
+                              if (GWX__tmp__detail>0)\
+                              {\
+                                 GWX__TEXT(F,##__VA_ARGS__)\
+                                 GWX__tmp__interned = ::Gwers::Intern::get(\
+                                    GWX__tmp__string.view());\
+                              }\
+                              x_trace.start(GWX__tmp__site,\
+                                            GWX__tmp__interned);\
+                           }\
+                           GWX__PROBE()
+#define GWX_BEGIN_P(P,F,...) GWX__WHERE(1)\
+                             GWX__HOLD(F,##__VA_ARGS__)\
+                             ::Gwers::Trace::Keyed<::Gwers::Trace::Policed<\
+                                (P::trace>1?2:(P::trace>0?1:0))>> x_trace;\
+                             if (GWX__KEY)\
+                             {\
+                                GWX__ENROLL(GWX__tmp__site)\
+                                if (P::trace>0)\
+                                {\
+                                   GWX__LOCAL\
+                                   x_trace.start(GWX__tmp__site,GWX__SAMPLE,\
+                                                 GWX__ARGS(F,##__VA_ARGS__));\
+                                }\
+                             }\
+                             GWX__PROBE()
+#elif defined(GWX_USDT)
+#define GWX_BEGIN(F,...) GWX__SITE(1) GWX__HOLD(F,##__VA_ARGS__) GWX__PROBE()
+#define GWX_BEGIN_S(N,F,...) GWX__SITE(N) GWX__HOLD(F,##__VA_ARGS__)\
+                             GWX__PROBE()
+#define GWX_BEGIN_I(F,...) GWX__SITE(1) GWX__HOLD(F,##__VA_ARGS__) GWX__PROBE()
+#define GWX_BEGIN_P(P,F,...) GWX__SITE(1) GWX__HOLD(F,##__VA_ARGS__)\
+                             GWX__PROBE()
 #else
 #define GWX_BEGIN(F,...)
+#define GWX_BEGIN_S(N,F,...)
+#define GWX_BEGIN_I(F,...)
+#define GWX_BEGIN_P(P,F,...)
 #endif
 namespace Gwers {
 
@@ -31,6 +128,42 @@ namespace Gwers {
 /// the Exception class; the user does not need to use the constructor or most
 /// class functions directly.
 ///
+/// Function items can also be added without any GWX_BEGIN macro by building
+/// the library with ATRACE defined, which links the libgwers.d3.a variant, and
+/// compiling user code with GCC's -finstrument-functions option. The compiler
+/// then calls hooks implemented by this class on entry and exit of every
+/// instrumented function, which push and pop the raw address of the function.
+/// An address is only turned into a function name once the stack is read
+/// through begin() and end(), or a snapshot() is taken, so entering a function
+/// costs little more than a GWX_BEGIN frame with no arguments. Files and
+/// functions are excluded from instrumentation with GCC's
+/// -finstrument-functions-exclude-file-list and
+/// -finstrument-functions-exclude-function-list options, or by giving a
+/// function the no_instrument_function attribute. Names can only be found for
+/// functions in the dynamic symbol table, so programs should also be linked
+/// with -rdynamic; any other function is named by its address.
+///
+/// Function items whose names are built at runtime but repeat heavily, such as
+/// names that include the kind of operation being done, can be added with the
+/// GWX_BEGIN_I(F,...) macro instead, which works the same as GWX_BEGIN but
+/// interns the name with the Intern class. The function item then only points
+/// to the single process wide copy of its name instead of holding a copy of
+/// its own.
+///
+/// Code compiled with GWX_STATIC_KEYS defined puts the switch of the Key class
+/// in front of every GWX_BEGIN, GWX_BEGIN_S, GWX_BEGIN_I, and GWX_BEGIN_P
+/// site, so its sites cost a single NOP and one flag on the stack until
+/// Key::enable() is called. Code compiled with
+/// GWX_USDT defined also places probe points for external tracers at every
+/// site, with or without DTRACE; see Probe. While Profile is on, function
+/// items added by sites are also timed and charged to the Tag of the thread.
+///
+/// The static stack of each thread is taken from a lock free free list of
+/// stacks left behind by threads that have exited, and is cleared and given
+/// back to it when the thread exits. A thread started with tracing enabled
+/// therefore reuses a stack that has already grown, instead of allocating and
+/// growing its own from nothing.
+///
 /// @warning Except for using begin() and end() to iterate through the recorded
 /// stack, the user should not directly use this class. All the user needs to do
 /// is enable DTRACE and add the GWX_BEGIN macro at the beginning of each
@@ -43,8 +176,15 @@ public:
    // *
    /// @brief Used for all strings.
    using string = std::string;
-   /// @brief Type used for iterating through function stack.
-   using iter = std::vector<string>::iterator;
+   class iter;
+   template<int L> class Policed;
+   template<class T> class Keyed;
+   template<std::size_t N> class Name;
+   /// @brief Type of buffer function items are formatted into, longer function
+   /// items being cut off.
+   using Text = Format::Fixed<256>;
+   /// @brief Type used for snapshots of function stack.
+   using list = std::vector<string>;
    // *
    // * BASIC METHODS
    // *
@@ -59,7 +199,37 @@ public:
    /// instead use the X_BEGIN macro which will use this constructor. Also never
    /// include X_BEGIN to functions that are not nested within a
    /// Exception::base_catch() call.
-   Trace(const string& fname);
+   Trace(std::string_view fname);
+   /// @brief Adds new interned function to stack.
+   ///
+   /// @param fname Full function name that has been interned with
+   /// Intern::get().
+   ///
+   /// This will add a new function item to this classes' static stack that
+   /// points to an interned name instead of holding its own copy of it.
+   ///
+   /// @warning This constructor should never be called directly by the user,
+   /// instead use the GWX_BEGIN_I macro which will use this constructor.
+   Trace(const string* fname);
+   /// @brief Adds new function to stack if the call was sampled.
+   ///
+   /// @param site Site of the GWX_BEGIN macro adding the function.
+   /// @param text Full function name that will be added to stack, or nullptr
+   /// if the call was not sampled by the site and nothing is added.
+   ///
+   /// @warning This constructor should never be called directly by the user,
+   /// instead use the GWX_BEGIN macros which will use this constructor.
+   Trace(Site& site, const Format* text);
+   /// @brief Adds new interned function to stack if the call was sampled.
+   ///
+   /// @param site Site of the GWX_BEGIN_I macro adding the function.
+   /// @param fname Full function name that has been interned with
+   /// Intern::get(), or nullptr if the call was not sampled by the site and
+   /// nothing is added.
+   ///
+   /// @warning This constructor should never be called directly by the user,
+   /// instead use the GWX_BEGIN_I macro which will use this constructor.
+   Trace(Site& site, const string* fname);
    /// @brief Pops top function from stack.
    ///
    /// This will remove the top function from this classes' static stack.
@@ -84,51 +254,470 @@ public:
    /// any function items currently loaded on the stack.
    ///
    /// @warning This function should never be called directly by the user. The
-   /// flushing of the classes' static stack is done for you at the beginning of
-   /// the Exception::base_catch() function before it passes control to the main
-   /// function pointer.
+   /// stack is rewound for you at the beginning and end of the
+   /// Exception::base_catch() function, and flushed there if it is locked.
    static void flush();
+   /// @brief Get current depth of the function stack.
+   ///
+   /// This returns the number of function items currently on this classes'
+   /// static stack. The value returned can be given to rewind() at a later
+   /// time as a checkpoint of the stack.
+   static std::size_t depth();
+   /// @brief Rewinds the function stack to a previous checkpoint.
+   ///
+   /// @param depth Depth of the stack, as returned by depth(), that the stack
+   /// will be rewound to.
+   ///
+   /// This removes all function items above the given depth from this classes'
+   /// static stack and unlocks it. This is used by code that runs independent
+   /// units of work on the same thread, such as the ThreadPool, so a unit of
+   /// work that caught its own exception can never leave a locked or partial
+   /// stack behind for the next unit of work.
+   ///
+   /// @warning This function should never be called directly by the user.
+   static void rewind(std::size_t depth);
+   /// @brief Get whether the function stack is locked.
+   static bool locked();
+   /// @brief Get site of top function item.
+   ///
+   /// @return Site that added the top function item of this classes' static
+   /// stack, or nullptr if the stack is empty or the item was not added by a
+   /// GWX_BEGIN macro.
+   static const Site* site();
+   /// @brief Takes a snapshot of the function stack.
+   ///
+   /// This returns a list of all function items on this classes' static stack.
+   /// If the stack is locked, as it is after a %Gwers exception has been thrown,
+   /// the strings are moved into the snapshot instead of copied, leaving empty
+   /// function items of the same depth behind on the stack.
+   ///
+   /// @return Snapshot of function stack.
+   static list snapshot();
+   /// @brief Restores a snapshot on top of the function stack.
+   ///
+   /// @param snapshot Snapshot of a function stack, possibly from another
+   /// thread, that will be moved on top of this thread's stack.
+   ///
+   /// This pushes every function item of the given snapshot on top of this
+   /// classes' static stack and then locks it, just as if the exception that
+   /// the snapshot was taken for had been thrown from the top of this thread's
+   /// stack.
+   ///
+   /// @warning This function should never be called directly by the user. It
+   /// is used by Capture::rethrow().
+   static void restore(list&& snapshot);
    /// @brief Get beginning of list iterator for classes' stack.
    static const iter begin();
    /// @brief Get one past end of list iterator for classes' stack.
    static const iter end();
    /// @brief Do nothing, wrapper for other build functions.
-   static void build(std::ostringstream&) {}
+   static void build(Format&) {}
    /// @brief End of list build function, see main build function for
    /// description.
-   template<class T> static void build(std::ostringstream& str, T val);
+   template<class T> static void build(Format& str, T val);
    /// @brief Builds a variable list of function argument values.
    ///
    /// @tparam T First argument in list of variable function arguments.
    /// @tparam Args List of remaining arguments for provided function.
    ///
-   /// @param str Output stream where list of variable arguments will be written
+   /// @param str Formatter where list of variable arguments will be written
    /// to.
    /// @param val First argument in variable list of function arguments.
    /// @param args Variable list of remaining arguments for provided function.
    ///
-   /// Adds a variable list of function argument values to an output string
-   /// stream.
+   /// Adds a variable list of function argument values to a formatter.
    ///
    /// @warning This function should never be called directly by the user. The
    /// GWX_BEGIN macro uses this function to build the function name header with
    /// a variable number of function argument values.
    template<class T, class... Args>
-      static void build(std::ostringstream& str,T val, Args... args);
+      static void build(Format& str,T val, Args... args);
+   /// @brief Builds function name and argument values held for a probe.
+   ///
+   /// @tparam F Type of function name.
+   /// @tparam Args List of argument values of function.
+   ///
+   /// @param str Formatter where function name and argument values will be
+   /// written to.
+   /// @param detail Level of detail sampled by the site, where only 2 or more
+   /// writes argument values.
+   /// @param held Name and argument values of function returned by
+   /// Probe::hold().
+   ///
+   /// @warning This function should never be called directly by the user. The
+   /// GWX_BEGIN macros use it in place of build() when GWX_USDT is defined, so
+   /// the name and argument values are only evaluated once.
+   template<class F, class... Args>
+      static void text(Format& str, int detail,
+                       const std::tuple<F,Args...>& held);
+   /// @brief Adds function address to stack.
+   ///
+   /// @param address Address of function that has been entered.
+   ///
+   /// This adds a new function item to this classes' static stack that only
+   /// holds the address of a function, which is turned into its name once read.
+   ///
+   /// @warning This function should never be called directly by the user. It
+   /// is called by the -finstrument-functions hooks when ATRACE is defined.
+   static void enter(const void* address);
+   /// @brief Pops top function from stack unless it is locked or empty.
+   ///
+   /// @warning This function should never be called directly by the user. It
+   /// is called by the -finstrument-functions hooks when ATRACE is defined.
+   static void leave();
 private:
    // *
    // * DECLERATIONS
    // *
-   using list = std::vector<string>;
+   struct Frame
+   {
+      Frame(string n): name {std::move(n)} {}
+      Frame(std::string_view n): name {n} {}
+      Frame(const void* a): address {a} {}
+      Frame(const string* t): text {t} {}
+      string name;
+      const void* address {nullptr};
+      const string* text {nullptr};
+      const Site* site {nullptr};
+      unsigned weight {1};
+   };
+   using stack = std::vector<Frame>;
+   struct Buffer
+   {
+      Buffer();
+      ~Buffer();
+      stack* operator->() { return frames; }
+      stack& operator*() { return *frames; }
+      bool grown() const { return frames->capacity()!=capacity; }
+      stack* frames;
+      std::size_t capacity {0};
+      std::int64_t pending {0};
+   };
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   static const string& name(Frame& f);
+   static void symbolize(Frame& f);
+   static std::int64_t bytes(const Frame& f);
+   static void account(std::int64_t bytes);
+   // *
+   // * FUNCTIONS
+   // *
+   void push(Site& site);
+   void observe(std::string_view name);
+   void pop();
+   // *
+   // * VARIABLES
+   // *
+   bool _push {true};
+   unsigned _weight {0};
+   std::int64_t _bytes {0};
+   std::int64_t _start {0};
+   std::int64_t _cpu {0};
+   const Site* _site {nullptr};
    // *
    // * STATIC VARIABLES
    // *
-   thread_local static list _stack;
+   static Recycler<stack,64> _stacks;
+   static const std::size_t _local;
+   thread_local static Buffer _stack;
    thread_local static bool _lock;
 };
 
 
 
+//
+//
+//
+// *==========================================================================*
+// | POLICED                                                                  |
+// *==========================================================================*
+//
+//
+//
+
+
+
+/// @brief Function item added according to a trace level of a policy.
+///
+/// @tparam L Trace level of the policy of the module this function item is in,
+/// clamped to between 0 and 2 by GWX_BEGIN_P. A level of 2 adds the function
+/// name along with all of its argument values, just as GWX_BEGIN does. A level
+/// of 1 adds only the function name, never formatting the argument values. A
+/// level of 0 adds nothing and compiles to nothing other than its site, which
+/// is listed by Site::all() but never reached. Levels 1 and 2 follow the
+/// sampling rate and level of detail of their site, which can only lower the
+/// detail further.
+///
+/// @warning This class should never be used directly by the user, instead use
+/// the GWX_BEGIN_P macro.
+template<int L> class Trace::Policed : public Trace
+{
+public:
+   // *
+   // * BASIC METHODS
+   // *
+   /// @brief Adds function name and argument values to stack.
+   ///
+   /// @tparam Args List of argument values of function.
+   ///
+   /// @param site Site of the GWX_BEGIN_P macro adding the function.
+   /// @param detail Level of detail sampled by the site.
+   /// @param fname Name of function.
+   /// @param args Variable list of argument values of function.
+   template<class... Args> Policed(Site& site, int detail,
+                                   std::string_view fname, Args... args);
+   /// @brief Adds function name and argument values held for a probe to
+   /// stack.
+   ///
+   /// @tparam F Type of function name.
+   /// @tparam Args List of argument values of function.
+   ///
+   /// @param site Site of the GWX_BEGIN_P macro adding the function.
+   /// @param detail Level of detail sampled by the site.
+   /// @param held Name and argument values of function returned by
+   /// Probe::hold().
+   template<class F, class... Args>
+      Policed(Site& site, int detail, const std::tuple<F,Args...>& held);
+private:
+   // *
+   // * BASIC METHODS
+   // *
+   template<class T, std::size_t... I>
+      Policed(Site& site, int detail, const T& held,
+              std::index_sequence<I...>);
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   template<class... Args> static const Format* format(Format&& str,
+                                                       int detail,
+                                                       std::string_view fname,
+                                                       Args... args);
+};
+
+
+
+/// @brief Function item that only adds the function name to the stack.
+template<> class Trace::Policed<1> : public Trace
+{
+public:
+   // *
+   // * BASIC METHODS
+   // *
+   /// @brief Adds function name to stack, ignoring argument values.
+   template<class... Args> Policed(Site& site, int detail,
+                                   std::string_view fname, const Args&...);
+   /// @brief Adds function name held for a probe to stack, ignoring argument
+   /// values.
+   template<class F, class... Args>
+      Policed(Site& site, int detail, const std::tuple<F,Args...>& held);
+};
+
+
+
+/// @brief Function item that adds nothing to the stack.
+template<> class Trace::Policed<0>
+{
+public:
+   // *
+   // * BASIC METHODS
+   // *
+   /// @brief Does nothing.
+   template<class... Args> Policed(const Args&...) {}
+};
+
+
+
+/// @ingroup exception
+/// @brief Function item that is only constructed within the branch of a site.
+///
+/// @tparam T Type of function item, either Trace or Trace::Policed.
+///
+/// This holds the storage of a function item for the whole scope of the
+/// function being traced, but only constructs it once start() is called. The
+/// GWX_BEGIN macros call start() within the branch taken while the switch of
+/// the Key class is on, along with everything else the site does, so while the
+/// switch is off a site only sets up and tests the flag of this object.
+///
+/// @warning This class should never be used directly by the user, instead use
+/// the GWX_BEGIN macros.
+template<class T> class Trace::Keyed
+{
+public:
+   // *
+   // * BASIC METHODS
+   // *
+   /// @brief Sets up storage of function item without constructing it.
+   Keyed() {}
+   /// @brief Destroys function item if it was started.
+   ~Keyed();
+   // *
+   // * COPY METHODS
+   // *
+   Keyed(const Keyed&) = delete;
+   Keyed& operator=(const Keyed&) = delete;
+   // *
+   // * FUNCTIONS
+   // *
+   /// @brief Constructs function item.
+   ///
+   /// @tparam Args List of types of arguments of constructor.
+   ///
+   /// @param args Arguments given to the constructor of the function item.
+   template<class... Args> void start(Args&&... args);
+private:
+   // *
+   // * VARIABLES
+   // *
+   union
+   {
+      T _item;
+   };
+   bool _on {false};
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | NAME                                                                     |
+// *==========================================================================*
+//
+//
+//
+
+
+
+/// @brief Function name shortened at compile time.
+///
+/// @tparam N Size of the function signature being shortened, including its
+/// terminating null character.
+///
+/// This reduces a function signature as written by %__PRETTY_FUNCTION__ to the
+/// qualified name of the function and its parameter list. The return type and
+/// any specifiers in front of it, qualifiers after the parameter list, and the
+/// "[with ...]" list of template arguments GCC appends are removed, and every
+/// template argument list is trimmed to <>. Names of lambdas, operators, and
+/// anonymous namespaces are kept as they are. For example, the signature
+/// "static std::vector<int> ns::A<T>::f(const std::map<int, int>&) const [with
+/// T = int]" becomes "ns::A<>::f(const std::map<>&)".
+///
+/// The constructor is constexpr, so an object of this class declared static
+/// and constexpr holds the shortened name as a static string with no code ran
+/// at runtime. The GWX_FUNCTION macro does this for the function it is used in,
+/// and is meant to be given as the F argument of GWX_BEGIN and GWX_BEGIN_P.
+template<std::size_t N> class Trace::Name
+{
+public:
+   // *
+   // * BASIC METHODS
+   // *
+   /// @brief Shortens function signature.
+   ///
+   /// @param pretty Function signature as written by %__PRETTY_FUNCTION__.
+   constexpr Name(const char (&pretty)[N]);
+   // *
+   // * FUNCTIONS
+   // *
+   /// @brief Get shortened function name as a null terminated string.
+   constexpr const char* c_str() const;
+   /// @brief Get length of shortened function name.
+   constexpr std::size_t size() const;
+private:
+   // *
+   // * STATIC FUNCTIONS
+   // *
+   static constexpr bool starts(const char* s, std::size_t i, std::size_t n,
+                                const char* word);
+   static constexpr bool ident(char c);
+   static constexpr std::size_t close(const char* s, std::size_t i,
+                                      std::size_t n);
+   // *
+   // * VARIABLES
+   // *
+   char _name[N] {};
+   std::size_t _size {0};
+};
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | ITER                                                                     |
+// *==========================================================================*
+//
+//
+//
+
+
+
+/// @brief Bidirectional iterator through function stack.
+///
+/// This iterates through the function items of the static stack of the Trace
+/// class, giving the name of each one. Function items added by
+/// -finstrument-functions only hold an address, which is turned into a name
+/// the first time the item is read through this iterator.
+class Trace::iter
+{
+public:
+   // *
+   // * DECLERATIONS
+   // *
+   /// @brief Category of this iterator.
+   using iterator_category = std::bidirectional_iterator_tag;
+   /// @brief Type of value iterated.
+   using value_type = Trace::string;
+   /// @brief Type of difference between two iterators.
+   using difference_type = std::ptrdiff_t;
+   /// @brief Type of pointer to value iterated.
+   using pointer = const Trace::string*;
+   /// @brief Type of reference to value iterated.
+   using reference = const Trace::string&;
+   // *
+   // * BASIC METHODS
+   // *
+   /// @brief Initializes iterator pointing to nothing.
+   iter() = default;
+   // *
+   // * FUNCTIONS
+   // *
+   /// @brief Get site that added function item, or nullptr if it was not added
+   /// by a GWX_BEGIN macro.
+   const Site* site() const;
+   /// @brief Get number of calls function item stands for, which is the
+   /// sampling rate of its site when it was added, or 1 if it has no site.
+   unsigned weight() const;
+   // *
+   // * OPERATORS
+   // *
+   /// @brief Get name of function item.
+   const string& operator*() const;
+   /// @brief Get name of function item.
+   const string* operator->() const;
+   /// @brief Move to next function item.
+   iter& operator++();
+   /// @brief Move to next function item.
+   iter operator++(int);
+   /// @brief Move to previous function item.
+   iter& operator--();
+   /// @brief Move to previous function item.
+   iter operator--(int);
+   /// @brief Compare with another iterator.
+   bool operator==(const iter& i) const;
+   /// @brief Compare with another iterator.
+   bool operator!=(const iter& i) const;
+private:
+   friend class Trace;
+   iter(stack::iterator i);
+   stack::iterator _i;
+};
+
+
+
 //
 //
 //
@@ -141,9 +730,200 @@ private:
 
 
 
-inline Trace::Trace(const string& fname)
+template<std::size_t N>
+   constexpr Trace::Name<N>::Name(const char (&pretty)[N])
 {
-   _stack.emplace_back(fname);
+   std::size_t n {N-1};
+   for (std::size_t i = 0;i<n;++i)
+   {
+      if (starts(pretty,i,n," [with "))
+      {
+         n = i;
+      }
+   }
+   std::size_t begin {0};
+   std::size_t end {n};
+   std::size_t opbegin {n};
+   std::size_t opend {n};
+   std::size_t i {0};
+   while (i<n)
+   {
+      char c {pretty[i]};
+      if (starts(pretty,i,n,"operator")&&(i==0||!ident(pretty[i-1]))&&
+          (i+8>=n||!ident(pretty[i+8])))
+      {
+         opbegin = i;
+         i += 8;
+         if (starts(pretty,i,n,"()"))
+         {
+            i += 2;
+         }
+         while (i<n&&pretty[i]!='(')
+         {
+            ++i;
+         }
+         opend = i;
+      }
+      else if (c=='('&&!starts(pretty,close(pretty,i,n)+1,n,"::"))
+      {
+         end = close(pretty,i,n)+1;
+         break;
+      }
+      else if (c=='<'||c=='('||c=='{'||c=='[')
+      {
+         i = close(pretty,i,n)+1;
+      }
+      else
+      {
+         if (c==' ')
+         {
+            begin = i+1;
+         }
+         ++i;
+      }
+   }
+   if (end>n)
+   {
+      end = n;
+   }
+   i = begin;
+   while (i<end)
+   {
+      if (i==opbegin)
+      {
+         while (i<opend)
+         {
+            _name[_size++] = pretty[i++];
+         }
+      }
+      else if (pretty[i]=='<'&&!starts(pretty,i,end,"<lambda"))
+      {
+         _name[_size++] = '<';
+         _name[_size++] = '>';
+         i = close(pretty,i,end)+1;
+      }
+      else if (pretty[i]=='<')
+      {
+         std::size_t j {close(pretty,i,end)+1};
+         while (i<j&&i<end)
+         {
+            _name[_size++] = pretty[i++];
+         }
+      }
+      else
+      {
+         _name[_size++] = pretty[i++];
+      }
+   }
+   _name[_size] = '\0';
+}
+
+
+
+template<std::size_t N> constexpr const char* Trace::Name<N>::c_str() const
+{
+   return _name;
+}
+
+
+
+template<std::size_t N> constexpr std::size_t Trace::Name<N>::size() const
+{
+   return _size;
+}
+
+
+
+template<std::size_t N>
+   constexpr bool Trace::Name<N>::starts(const char* s, std::size_t i,
+                                         std::size_t n, const char* word)
+{
+   for (;*word;++word,++i)
+   {
+      if (i>=n||s[i]!=*word)
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+
+
+template<std::size_t N> constexpr bool Trace::Name<N>::ident(char c)
+{
+   return (c>='a'&&c<='z')||(c>='A'&&c<='Z')||(c>='0'&&c<='9')||c=='_';
+}
+
+
+
+template<std::size_t N>
+   constexpr std::size_t Trace::Name<N>::close(const char* s, std::size_t i,
+                                               std::size_t n)
+{
+   char open {s[i]};
+   char shut {open=='<'?'>':(open=='('?')':(open=='{'?'}':']'))};
+   std::size_t depth {0};
+   for (;i<n;++i)
+   {
+      if (s[i]==open)
+      {
+         ++depth;
+      }
+      else if (s[i]==shut&&--depth==0)
+      {
+         return i;
+      }
+   }
+   return n-1;
+}
+
+
+
+inline Trace::Trace(std::string_view fname)
+{
+   _stack->emplace_back(fname);
+   observe(fname);
+}
+
+
+
+inline Trace::Trace(const string* fname)
+{
+   _stack->emplace_back(fname);
+   observe(*fname);
+}
+
+
+
+inline Trace::Trace(Site& site, const Format* text)
+{
+   if (text)
+   {
+      _stack->emplace_back(text->view());
+      push(site);
+      observe(text->view());
+   }
+   else
+   {
+      _push = false;
+   }
+}
+
+
+
+inline Trace::Trace(Site& site, const string* fname)
+{
+   if (fname)
+   {
+      _stack->emplace_back(fname);
+      push(site);
+      observe(*fname);
+   }
+   else
+   {
+      _push = false;
+   }
 }
 
 
@@ -155,21 +935,111 @@ inline void Trace::lock()
 
 
 
+inline std::size_t Trace::depth()
+{
+   return _stack->size();
+}
+
+
+
+inline bool Trace::locked()
+{
+   return _lock;
+}
+
+
+
+inline const Site* Trace::site()
+{
+   return _stack->empty()?nullptr:_stack->back().site;
+}
+
+
+
 inline const Trace::iter Trace::begin()
 {
-   return _stack.begin();
+   return iter(_stack->begin());
 }
 
 
 
 inline const Trace::iter Trace::end()
 {
-   return _stack.end();
+   return iter(_stack->end());
+}
+
+
+
+inline void Trace::enter(const void* address)
+{
+   Buffer& b {_stack};
+   b->emplace_back(address);
+   if (b.grown())
+   {
+      account(0);
+   }
+}
+
+
+
+inline Trace::~Trace()
+{
+   if (_push)
+   {
+      pop();
+   }
+}
+
+
+
+inline void Trace::push(Site& site)
+{
+   Frame& f {_stack->back()};
+   f.site = &site;
+   f.weight = site.weight();
+}
+
+
+
+inline void Trace::leave()
+{
+   if (!_lock&&!_stack->empty())
+   {
+      std::int64_t n {bytes(_stack->back())};
+      if (n)
+      {
+         account(-n);
+      }
+      _stack->pop_back();
+   }
 }
 
 
 
-template<class T> inline void Trace::build(std::ostringstream& str, T val)
+inline std::int64_t Trace::bytes(const Frame& f)
+{
+   std::size_t n {f.name.capacity()};
+   return n>_local?n+1:0;
+}
+
+
+
+inline const Trace::string& Trace::name(Frame& f)
+{
+   if (f.text)
+   {
+      return *f.text;
+   }
+   if (f.address)
+   {
+      symbolize(f);
+   }
+   return f.name;
+}
+
+
+
+template<class T> inline void Trace::build(Format& str, T val)
 {
    str << "[" << val << "]";
 }
@@ -177,7 +1047,7 @@ template<class T> inline void Trace::build(std::ostringstream& str, T val)
 
 
 template<class T, class... Args>
-   void Trace::build(std::ostringstream& str, T val, Args... args)
+   void Trace::build(Format& str, T val, Args... args)
 {
    str << "[" << val << "],";
    build(str,args...);
@@ -185,5 +1055,204 @@ template<class T, class... Args>
 
 
 
+template<class F, class... Args>
+   inline void Trace::text(Format& str, int detail,
+                           const std::tuple<F,Args...>& held)
+{
+   std::apply([&str,detail](const auto& name, const auto&... args) {
+      str << name;
+      if (detail>1)
+      {
+         build(str,args...);
+      }
+   },held);
+}
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | POLICED INLINE/TEMPLATE                                                  |
+// *==========================================================================*
+//
+//
+//
+
+
+
+template<int L> template<class... Args>
+   Trace::Policed<L>::Policed(Site& site, int detail, std::string_view fname,
+                              Args... args):
+   Trace(site,format(Text(),detail,fname,args...))
+{}
+
+
+
+template<int L> template<class F, class... Args>
+   Trace::Policed<L>::Policed(Site& site, int detail,
+                              const std::tuple<F,Args...>& held):
+   Policed(site,detail,held,std::index_sequence_for<F,Args...>())
+{}
+
+
+
+template<int L> template<class T, std::size_t... I>
+   Trace::Policed<L>::Policed(Site& site, int detail, const T& held,
+                              std::index_sequence<I...>):
+   Policed(site,detail,std::get<I>(held)...)
+{}
+
+
+
+template<int L> template<class... Args>
+   const Format* Trace::Policed<L>::format(Format&& str, int detail,
+                                           std::string_view fname,
+                                           Args... args)
+{
+   if (detail==0)
+   {
+      return nullptr;
+   }
+   str << fname;
+   if (detail>1)
+   {
+      build(str,args...);
+   }
+   return &str;
+}
+
+
+
+template<class... Args>
+   Trace::Policed<1>::Policed(Site& site, int detail, std::string_view fname,
+                              const Args&...):
+   Trace(site,detail>0?&(Text() << fname):nullptr)
+{}
+
+
+
+template<class F, class... Args>
+   Trace::Policed<1>::Policed(Site& site, int detail,
+                              const std::tuple<F,Args...>& held):
+   Trace(site,detail>0?&(Text() << std::get<0>(held)):nullptr)
+{}
+
+
+
+template<class T> inline Trace::Keyed<T>::~Keyed()
+{
+   if (_on)
+   {
+      _item.~T();
+   }
+}
+
+
+
+template<class T> template<class... Args>
+   inline void Trace::Keyed<T>::start(Args&&... args)
+{
+   new (&_item) T(std::forward<Args>(args)...);
+   _on = true;
+}
+
+
+
+//
+//
+//
+// *==========================================================================*
+// | ITER INLINE/TEMPLATE                                                     |
+// *==========================================================================*
+//
+//
+//
+
+
+
+inline Trace::iter::iter(stack::iterator i):
+   _i {i}
+{}
+
+
+
+inline const Site* Trace::iter::site() const
+{
+   return _i->site;
+}
+
+
+
+inline unsigned Trace::iter::weight() const
+{
+   return _i->weight;
+}
+
+
+
+inline const Trace::string& Trace::iter::operator*() const
+{
+   return Trace::name(*_i);
+}
+
+
+
+inline const Trace::string* Trace::iter::operator->() const
+{
+   return &Trace::name(*_i);
+}
+
+
+
+inline Trace::iter& Trace::iter::operator++()
+{
+   ++_i;
+   return *this;
+}
+
+
+
+inline Trace::iter Trace::iter::operator++(int)
+{
+   iter ret {*this};
+   ++_i;
+   return ret;
+}
+
+
+
+inline Trace::iter& Trace::iter::operator--()
+{
+   --_i;
+   return *this;
+}
+
+
+
+inline Trace::iter Trace::iter::operator--(int)
+{
+   iter ret {*this};
+   --_i;
+   return ret;
+}
+
+
+
+inline bool Trace::iter::operator==(const iter& i) const
+{
+   return _i==i._i;
+}
+
+
+
+inline bool Trace::iter::operator!=(const iter& i) const
+{
+   return _i!=i._i;
+}
+
+
+
 }
 #endif
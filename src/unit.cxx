@@ -1,12 +1,40 @@
+#include <cstdio>
 #include "unit.hh"
+#include "coverage.h"
 
 
 
 int main()
 {
    UnitTest ut;
+   unit::coverage::init(ut);
+   unit::recycler::init(ut);
+   unit::intern::init(ut);
+   unit::format::init(ut);
+   unit::site::init(ut);
+   unit::governor::init(ut);
+   unit::request::init(ut);
+   unit::recorder::init(ut);
+   unit::config::init(ut);
+   unit::metrics::init(ut);
+   unit::memory::init(ut);
+   unit::key::init(ut);
+   unit::probe::init(ut);
+   unit::tag::init(ut);
+   unit::profile::init(ut);
+   unit::queue::init(ut);
    unit::trace::init(ut);
+   unit::autotrace::init(ut);
    unit::exception::init(ut);
+   unit::context::init(ut);
+   unit::capture::init(ut);
+   unit::reporter::init(ut);
+   unit::threadpool::init(ut);
+   unit::parallel::init(ut);
+   Gwers::Coverage::start();
    ut.execute();
+   Gwers::Coverage::stop();
+   std::fflush(stdout);
+   Gwers::Coverage::print(1);
    return 0;
 }
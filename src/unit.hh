@@ -10,7 +10,29 @@
 /// space.
 namespace unit {
 namespace exception { void init(UnitTest&); }
+namespace capture { void init(UnitTest&); }
 namespace trace { void init(UnitTest&); }
+namespace autotrace { void init(UnitTest&); }
+namespace recycler { void init(UnitTest&); }
+namespace intern { void init(UnitTest&); }
+namespace format { void init(UnitTest&); }
+namespace site { void init(UnitTest&); }
+namespace coverage { void init(UnitTest&); }
+namespace governor { void init(UnitTest&); }
+namespace request { void init(UnitTest&); }
+namespace queue { void init(UnitTest&); }
+namespace reporter { void init(UnitTest&); }
+namespace context { void init(UnitTest&); }
+namespace metrics { void init(UnitTest&); }
+namespace memory { void init(UnitTest&); }
+namespace key { void init(UnitTest&); }
+namespace probe { void init(UnitTest&); }
+namespace tag { void init(UnitTest&); }
+namespace profile { void init(UnitTest&); }
+namespace recorder { void init(UnitTest&); }
+namespace config { void init(UnitTest&); }
+namespace threadpool { void init(UnitTest&); }
+namespace parallel { void init(UnitTest&); }
 }
 
 
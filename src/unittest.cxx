@@ -1,7 +1,8 @@
 #include "unittest.hh"
-#include <iostream>
+#include <cstdio>
 #include <utility>
 #include "exception.h"
+#include "format.h"
 
 
 
@@ -9,6 +10,19 @@ int UnitTest::_count {0};
 
 
 
+/// @brief Internal type of buffer each line of output is formatted into.
+using Line = Gwers::Format::Fixed<512>;
+
+
+
+/// @brief Writes formatted output to standard output.
+static void print(const Gwers::Format& str)
+{
+   std::fwrite(str.c_str(),1,str.size(),stdout);
+}
+
+
+
 UnitTest::Run& UnitTest::add(const string& name, fp in, fp out)
 {
    _runs.emplace_back(name,in,out);
@@ -30,7 +44,7 @@ void UnitTest::execute()
    }
    if (pass)
    {
-      std::cout << _count << " unit test(s) passed.\n";
+      print(Line() << _count << " unit test(s) passed.\n");
    }
 }
 
@@ -51,7 +65,7 @@ void UnitTest::execute()
 bool UnitTest::Run::execute()
 {
    bool ret {true};
-   std::cout << _name;
+   print(Line() << _name);
    if (_in)
    {
       _in();
@@ -60,26 +74,30 @@ bool UnitTest::Run::execute()
    {
       _count = 1;
       ++(UnitTest::_count);
-      std::cout << ".";
+      print(Line() << ".");
       try
       {
          i.second(*this);
       }
-      catch (Gwers::Exception e)
+      catch (const Gwers::Exception& e)
       {
-         std::cout << i.first << _count << " FAILED.\n";
-         std::cout << "Gwers: " << e.who() << ":" << e.what() << "\n";
-         std::cout << "TRACE:\n";
+         print(Line() << i.first << _count << " FAILED.\n");
+         print(Line() << "Gwers: " << e.who() << ":" << e.what() << "\n");
+         if (!e.context().empty())
+         {
+            print(Line() << "CONTEXT: " << e.context() << "\n");
+         }
+         print(Line() << "TRACE:\n");
          for (auto i = Gwers::Trace::begin();i!=Gwers::Trace::end();++i)
          {
-            std::cout << *i;
+            print(Line() << *i);
             if (++i!=Gwers::Trace::end())
             {
-               std::cout << " --->\n";
+               print(Line() << " --->\n");
             }
             else
             {
-               std::cout << "\n";
+               print(Line() << "\n");
             }
          }
          if (_out)
@@ -89,10 +107,10 @@ bool UnitTest::Run::execute()
          ret = false;
          break;
       }
-      catch (std::exception e)
+      catch (const std::exception& e)
       {
-         std::cout << i.first << _count << " FAILED.\n";
-         std::cout << "Std: " << e.what() << "\n";
+         print(Line() << i.first << _count << " FAILED.\n");
+         print(Line() << "Std: " << e.what() << "\n");
          if (_out)
          {
             _out();
@@ -102,7 +120,7 @@ bool UnitTest::Run::execute()
       }
       catch (...)
       {
-         std::cout << i.first << _count << " FAILED.\n";
+         print(Line() << i.first << _count << " FAILED.\n");
          if (_out)
          {
             _out();
@@ -117,7 +135,7 @@ bool UnitTest::Run::execute()
       {
          _out();
       }
-      std::cout << "\n";
+      print(Line() << "\n");
    }
    return ret;
 }
@@ -126,7 +144,7 @@ bool UnitTest::Run::execute()
 
 void UnitTest::Run::next()
 {
-   std::cout << ".";
+   print(Line() << ".");
    ++_count;
    ++(UnitTest::_count);
 }